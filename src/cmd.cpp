@@ -262,35 +262,36 @@ I_DoubleTime
 double I_DoubleTime (void)
 {
 #if defined(WIN32) || defined(_WIN64)
-	static DWORD starttime;
+	// monotonic high-resolution counter
+	static LARGE_INTEGER frequency;
+	static LARGE_INTEGER starttime;
 	static bool first = true;
-	DWORD now;
-
-	if (first)
-		timeBeginPeriod (1);
-
-	now = timeGetTime ();
+	LARGE_INTEGER now;
 
 	if (first)
 	{
+		// polling loops (write queue, scheduler, memory budget) Sleep() for 1-5 ms
+		timeBeginPeriod(1);
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&starttime);
 		first = false;
-		starttime = now;
 		return 0.0;
 	}
-
-	if (now < starttime)				// wrapped?
-		return (now / 1000.0) + (LONG_MAX - starttime / 1000.0);
-
-	if (now - starttime == 0)
-		return 0.0;
-
-	return (now - starttime) / 1000.0;
+	QueryPerformanceCounter(&now);
+	return (double)(now.QuadPart - starttime.QuadPart) / (double)frequency.QuadPart;
 #else
-	time_t	t;
-
-	time (&t);
+	static struct timespec starttime;
+	static bool first = true;
+	struct timespec now;
 
-	return t;
+	if (first)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &starttime);
+		first = false;
+		return 0.0;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)(now.tv_sec - starttime.tv_sec) + (double)(now.tv_nsec - starttime.tv_nsec) / 1000000000.0;
 #endif
 }
 
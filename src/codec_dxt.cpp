@@ -135,7 +135,7 @@ void CodecDXT_Encode(TexEncodeTask *task)
 ==========================================================================================
 */
 
-// using GimpDDS to decode DXT
+// native decoder or GimpDDS (both output swapped colors)
 void CodecDXT_Decode(TexDecodeTask *task)
 {
 	byte *data;
@@ -144,6 +144,13 @@ void CodecDXT_Decode(TexDecodeTask *task)
 
 	size = task->image->width * task->image->height * task->image->bpp;
 	data = (byte *)mem_alloc(size);
+	if (!task->libraryDecode && BlockDecode(task->format->block, task->pixeldata, task->pixeldatasize, data, task->image->width, task->image->height, task->image->bpp))
+	{
+		Image_StoreUnalignedData(task->image, data, size);
+		mem_free(data);
+		task->image->colorSwap = task->ImageParms.colorSwap ? false : true;
+		return;
+	}
 	if (task->format->block == &B_DXT1)
 		dxtformat = DDS_COMPRESS_BC1;
 	else if (task->format->block == &B_DXT2 || task->format->block == &B_DXT3)
@@ -154,7 +161,7 @@ void CodecDXT_Decode(TexDecodeTask *task)
 		Error("CodecDXT_Decode: block compression type %s not supported\n", task->format->block->name);
 	dxt_decompress(data, task->pixeldata, dxtformat, task->pixeldatasize, task->image->width, task->image->height, task->image->bpp, 0);
 	Image_StoreUnalignedData(task->image, data, size);
-	free(data);
+	mem_free(data);
 	task->image->colorSwap = task->ImageParms.colorSwap ? false : true; // dxt_decompress() swaps BGR->RGB
 }
 
@@ -190,6 +197,11 @@ void Swizzle_Premult(byte *data, int width, int height, int pitch, int bpp, bool
 		return;
 	}
 	// encode
+	if (bpp == 4)
+	{
+		ImageData_Premultiply(data, width, height, pitch);
+		return;
+	}
 	for (y = 0; y < height; y++)
 	{
 		byte *in = data;
@@ -209,92 +221,26 @@ void Swizzle_Premult(byte *data, int width, int height, int pitch, int bpp, bool
 // Doom 3's normalmap trick (store R channel in DXT5 alpha)
 void Swizzle_XGBR(byte *data, int width, int height, int pitch, int bpp, bool rgbSwap, bool sRGB, bool decode)
 {
-	int y;
+	static const int decodeOrder[4] = { 3, 1, 2, -1 };
+	static const int encodeOrder[4] = { 0, 1, -1, 2 };
 
 	if (bpp != 4)
 		Error("Swizzle_XGBR: image have no alpha channel!\n");
-	// decode
-	if (decode)
-	{
-		for (y = 0; y < height; y++)
-		{
-			byte *in = data;
-			byte *end = in + width*bpp;
-			while(in < end)
-			{
-				in[0] = in[3];
-				in[3] = 0;
-				in += bpp;
-			}
-			data += pitch;
-		}
-		return;
-	}
-	// encode
-	for (y = 0; y < height; y++)
-	{
-		byte *in = data;
-		byte *end = in + width*bpp;
-		while(in < end)
-		{
-			in[3] = in[2];
-			in[2] = 0;
-			in += bpp;
-		}
-		data += pitch;
-	}
+	ImageData_Shuffle(data, width, height, pitch, decode ? decodeOrder : encodeOrder);
 }
 
 // Doom 3's normalmap trick (store R channel in DXT5 alpha) with alpha stored in R (it seems it is only suitable for binaryalpha)
 void Swizzle_AGBR(byte *data, int width, int height, int pitch, int bpp, bool rgbSwap, bool sRGB, bool decode)
 {
-	int y;
+	static const int swapRA[4] = { 3, 1, 2, 0 };
+	static const int swapBA[4] = { 0, 1, 3, 2 };
 
 	if (bpp != 4)
 		Error("Swizzle_AGBR: image have no alpha channel!\n");
-
-	// decode
-	if (decode)
-	{
-		for (y = 0; y < height; y++)
-		{
-			byte *in = data;
-			byte *end = in + width*bpp;
-			while(in < end)
-			{
-				byte saved = in[0];
-				in[0] = in[3];
-				in[3] = saved;
-				in += bpp;
-			}
-			data += pitch;
-		}
-		return;
-	}
-	// encode
-	byte saved;
-	for (y = 0; y < height; y++)
-	{
-		byte *in = data;
-		byte *end = in + width*bpp;
-		while(in < end)
-		{
-			if (rgbSwap == false)
-			{
-				saved = in[0];
-				in[0] = in[3];
-				in[3] = saved;
-			}
-			else
-			{
-				saved = in[2];
-				in[2] = in[3];
-				in[3] = saved;
-			}
-			in += bpp;
-		}
-		data += pitch;
-	}
+	if (decode || rgbSwap == false)
+		ImageData_Shuffle(data, width, height, pitch, swapRA);
+	else
+		ImageData_Shuffle(data, width, height, pitch, swapBA);
 }
 
 // IdTech5 Chrominance/Luminance swizzle (can store low quality alpha)
@@ -339,30 +285,7 @@ void Swizzle_YCoCg(byte *data, int width, int height, int pitch, int bpp, bool r
 		return;
 	}
 	// encode
-	byte Y, Co, Cg;
-	for (y = 0; y < height; y++)
-	{
-		byte *in = data;
-		byte *end = in + width*bpp;
-		while(in < end)
-		{
-			Y  = ((in[2] + (in[1] << 1) + in[0]) + 2) >> 2;
-			Co = ((((in[2] << 1) - (in[0] << 1)) + 2) >> 2) + 128;
-			Cg = (((-in[2] + (in[1] << 1) - in[0]) + 2) >> 2) + 128;
-			in[0] = in[3];
-			in[1] = (Cg > 255 ? 255 : (Cg < 0 ? 0 : Cg));
-			in[2] = (Co > 255 ? 255 : (Co < 0 ? 0 : Co));
-			in[3] = (Y  > 255 ? 255 : (Y  < 0 ? 0 :  Y));
-			if (rgbSwap == false)
-			{
-				Y = in[2];
-				in[2] = in[0];
-				in[0] = Y;
-			}
-			in += bpp;
-		}
-		data += pitch;
-	}
+	ImageData_EncodeYCoCg(data, width, height, pitch, rgbSwap, false);
 }
 
 // YCoCg Unscaled Gamma 2.0
@@ -485,30 +408,7 @@ void Swizzle_YCoCgScaled(byte *data, int width, int height, int pitch, int bpp,
 		return;
 	}
 	// encode YCoCg (scale will be applied during compression)
-	byte Y, Co, Cg;
-	for (y = 0; y < height; y++)
-	{
-		byte *in = data;
-		byte *end = in + width*bpp;
-		while(in < end)
-		{
-			Y  = ((in[2] + (in[1] << 1) + in[0]) + 2) >> 2;
-			Co = ((((in[2] << 1) - (in[0] << 1)) + 2) >> 2) + 128;
-			Cg = (((-in[2] + (in[1] << 1) - in[0]) + 2) >> 2) + 128;
-			in[0] = 0;
-			in[1] = (Cg > 255 ? 255 : (Cg < 0 ? 0 : Cg));
-			in[2] = (Co > 255 ? 255 : (Co < 0 ? 0 : Co));
-			in[3] = (Y  > 255 ? 255 : (Y  < 0 ? 0 :  Y));
-			if (rgbSwap == false)
-			{
-				Y = in[2];
-				in[2] = in[0];
-				in[0] = Y;
-			}
-			in += bpp;
-		}
-		data += pitch;
-	}
+	ImageData_EncodeYCoCg(data, width, height, pitch, rgbSwap, true);
 }
 
 // YCoCg Scaled Gamma 2.0
@@ -106,7 +106,7 @@ void CodecETC1_Encode(TexEncodeTask *task)
 ==========================================================================================
 */
 
-// using EtcPack to decode ETC1
+// native decoder or EtcPack to decode ETC1
 void CodecETC1_Decode(TexDecodeTask *task)
 {
 	byte *data, *stream;
@@ -118,6 +118,13 @@ void CodecETC1_Decode(TexDecodeTask *task)
 	size = w * h * task->image->bpp;
 	data = (byte *)mem_alloc(size);
 	stream = task->pixeldata;
+	if (!task->libraryDecode && BlockDecode(task->format->block, task->pixeldata, task->pixeldatasize, data, w, h, task->image->bpp))
+	{
+		Image_StoreUnalignedData(task->image, data, size);
+		mem_free(data);
+		task->image->colorSwap = false;
+		return;
+	}
 	for (y = 0; y < h / 4; y++)
 	{
 		for (x = 0; x < w / 4; x++)
@@ -139,6 +146,6 @@ void CodecETC1_Decode(TexDecodeTask *task)
 		}
 	}
 	Image_StoreUnalignedData(task->image, data, size);
-	free(data);
+	mem_free(data);
 	task->image->colorSwap = false;
 }
\ No newline at end of file
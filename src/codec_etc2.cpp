@@ -121,7 +121,7 @@ void readColorBlockETC(byte **stream, unsigned int &block1, unsigned int &block2
 	*stream = data + 8;
 }
 
-// using EtcPack to decode ETC2
+// native decoder or EtcPack to decode ETC2
 void CodecETC2_Decode(TexDecodeTask *task)
 {
 	byte *data, *stream, rgba[4*4*4], *lb;
@@ -136,6 +136,15 @@ void CodecETC2_Decode(TexDecodeTask *task)
 	data = (byte *)mem_alloc(w * h * bpp);
 	stream = task->pixeldata;
 
+	// native decoder
+	if (!task->libraryDecode && BlockDecode(task->format->block, task->pixeldata, task->pixeldatasize, data, w, h, bpp))
+	{
+		Image_StoreUnalignedData(task->image, data, w*h*bpp);
+		mem_free(data);
+		task->image->colorSwap = false;
+		return;
+	}
+
 	// decode
 	if (task->format->block == &B_ETC2)
 	{
@@ -197,7 +206,7 @@ void CodecETC2_Decode(TexDecodeTask *task)
 
 	// store decoded image
 	Image_StoreUnalignedData(task->image, data, w*h*bpp);
-	free(data);
+	mem_free(data);
 	task->image->colorSwap = false;
 }
 
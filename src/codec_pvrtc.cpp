@@ -126,7 +126,10 @@ void CodecPVRTC_Decode(TexDecodeTask *task)
 	// decompress
 	// vortex: since BPP is 4, data is always properly aligned, so we dont need pitch
 	byte *data = Image_GetData(task->image, NULL, NULL);
-	pvr::PVRTDecompressPVRTC(task->pixeldata, do2bit, task->image->width, task->image->height, data);
+	if (task->libraryDecode)
+		pvr::PVRTDecompressPVRTC(task->pixeldata, do2bit, task->image->width, task->image->height, data);
+	else
+		BlockDecode_PVRTC(task->pixeldata, data, task->image->width, task->image->height, do2bit);
 	if (havebpp != task->image->bpp)
 		Image_ConvertBPP(task->image, havebpp);
 }
\ No newline at end of file
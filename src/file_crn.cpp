@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / Crunch CRN file format
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#define F_FILE_CRN_C
+#include "main.h"
+#include "tex.h"
+
+// crnd implementation is linked from crnlib
+#define CRND_HEADER_FILE_ONLY
+#include "crunch/inc/crn_decomp.h"
+
+TexContainer CONTAINER_CRN =
+{
+	"CRN", "Crunch (.CRN)", "crn", 2,
+	&CRN_Scan,
+	0, 0, 0,
+	&CRN_PrintHeader,
+	&CRN_CreateHeader,
+	NULL,
+	&CRN_Read,
+	&CRN_PackStream,
+};
+
+bool CRN_Scan(byte *data)
+{
+	if (data[0] != 'H' || data[1] != 'x')
+		return false;
+	return true;
+}
+
+void CRN_PrintHeader(byte *data)
+{
+	crnd::crn_texture_info info;
+
+	Print("CRN header:\n");
+	if (!crnd::crnd_get_texture_info(data, sizeof(crnd::crn_header), &info))
+	{
+		Print("  not a valid CRN file\n");
+		return;
+	}
+	Print("  width: %i\n", info.m_width);
+	Print("  height: %i\n", info.m_height);
+	Print("  levels: %i\n", info.m_levels);
+	Print("  faces: %i\n", info.m_faces);
+	Print("  format: %s\n", crn_get_format_stringa(info.m_format));
+	Print("  userdata0: 0x%08X\n", info.m_userdata0);
+	Print("  userdata1: 0x%08X\n", info.m_userdata1);
+}
+
+// .crn file is generated as a whole by CRN_PackStream, tools write plain DXT (or nothing)
+byte *CRN_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize)
+{
+	*outsize = 0;
+	return NULL;
+}
+
+void CRN_PackStream(TexEncodeTask *task)
+{
+	size_t size;
+	byte *data;
+
+	if (task->tool != &TOOL_CRUNCH)
+		Error("CRN_PackStream(%s): .crn files can only be made with %s\n", task->file->name.c_str(), TOOL_CRUNCH.fullName);
+	data = Crunch_CompressFile(task, &size);
+	mem_free(task->stream);
+	task->stream = data;
+	task->streamLen = size;
+}
+
+bool CRN_Read(TexDecodeTask *task)
+{
+	crnd::crn_texture_info info;
+	crn_uint32 ddssize;
+	byte *dds;
+
+	// validate header
+	if (!crnd::crnd_get_texture_info(task->data, (crn_uint32)task->datasize, &info))
+	{
+		sprintf(task->errorMessage, "failed to read CRN header");
+		return false;
+	}
+	if (info.m_faces > 1) { sprintf(task->errorMessage, "cubemaps are not supported"); return false; }
+
+	// detect file type, userdata keeps exact RwgTex format
+	if (info.m_userdata0)
+		findFormatByFourCCAndAlpha(info.m_userdata0, (info.m_userdata1 & CRN_USERDATA_ALPHA) ? true : false, &task->codec, &task->format);
+	if (!task->codec)
+		findFormatByFourCCAndAlpha(crn_get_format_fourcc(crn_get_fundamental_dxt_format(info.m_format)), info.m_format != cCRNFmtDXT1, &task->codec, &task->format);
+	if (!task->codec)
+	{
+		sprintf(task->errorMessage, "failed to find decoder");
+		return false;
+	}
+
+	// transcode to DXT
+	ddssize = (crn_uint32)task->datasize;
+	dds = (byte *)crn_decompress_crn_to_dds(task->data, ddssize);
+	if (!dds || ddssize < DDS_HEADER_SIZE)
+	{
+		sprintf(task->errorMessage, "failed to transcode CRN file");
+		return false;
+	}
+	task->unpacked = (byte *)mem_alloc(max(ddssize - DDS_HEADER_SIZE, 1));
+	memcpy(task->unpacked, dds + DDS_HEADER_SIZE, ddssize - DDS_HEADER_SIZE);
+	crn_free_block(dds);
+
+	task->ImageParms.hasAlpha = (task->format->features & FF_ALPHA) ? true : false;
+	task->ImageParms.colorSwap = false;
+	task->ImageParms.isNormalmap = (info.m_userdata1 & CRN_USERDATA_NORMALMAP) ? true : false;
+	task->ImageParms.sRGB = (info.m_userdata1 & CRN_USERDATA_SRGB) ? true : false;
+	task->numMipmaps = info.m_levels - 1;
+	task->width = info.m_width;
+	task->height = info.m_height;
+	task->pixeldata = task->unpacked;
+	task->pixeldatasize = ddssize - DDS_HEADER_SIZE;
+	return true;
+}
@@ -0,0 +1,18 @@
+// file_crn.h
+#ifndef H_FILE_CRN_H
+#define H_FILE_CRN_H
+
+extern TexContainer CONTAINER_CRN;
+
+bool   CRN_Scan(byte *data);
+void   CRN_PrintHeader(byte *data);
+byte  *CRN_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize);
+bool   CRN_Read(TexDecodeTask *task);
+void   CRN_PackStream(TexEncodeTask *task);
+
+// CRN header userdata1 flags (userdata0 is a fourCC of texture format)
+#define CRN_USERDATA_ALPHA     1
+#define CRN_USERDATA_SRGB      2
+#define CRN_USERDATA_NORMALMAP 4
+
+#endif
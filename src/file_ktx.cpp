@@ -19,6 +19,7 @@ TexContainer CONTAINER_KTX =
 	&KTX_CreateHeader,
 	&KTX_WriteMipHeader,
 	&KTX_Read,
+	&KTX_PackStream,
 };
 
 bool KTX_Scan(byte *data)
@@ -28,18 +29,26 @@ bool KTX_Scan(byte *data)
 	return true;
 }
 
+/*
+==========================================================================================
+
+  Key/value metadata
+
+==========================================================================================
+*/
+
 // extract new key/value pair from KTX metadata, returns allocated value
 char *KTX_ReadKeyPair(byte **stream, char **key, uint *valueSize)
 {
 	uint keyAndValueSize, i;
 	size_t valsize = 0;
-	char *value, *s;
+	char *value = NULL, *s;
 
 	keyAndValueSize = *((uint *)*stream);
 	*key = (char *)(*stream + 4);
 	for (i = 0; i < keyAndValueSize; i++)
 	{
-		if (!*key[i])
+		if (!(*key)[i])
 		{
 			i++;
 			value = *key + i;
@@ -47,7 +56,7 @@ char *KTX_ReadKeyPair(byte **stream, char **key, uint *valueSize)
 			break;
 		}
 	}
-	*stream += 4 + keyAndValueSize + ((keyAndValueSize/4)*4 - keyAndValueSize);
+	*stream += 4 + keyAndValueSize + (4 - keyAndValueSize % 4) % 4;
 	// extract value as string
 	s = (char *)mem_alloc(valsize + 1);
 	if (valsize)
@@ -58,46 +67,86 @@ char *KTX_ReadKeyPair(byte **stream, char **key, uint *valueSize)
 	return s;
 }
 
-// write key/value pair to KTX metadata datastream
-void KTX_WriteKeyPair(char *key, byte *data, uint dataSize, byte **keyData, uint *keyDataSize)
+// find value of a key in KTX metadata, returns pointer into metadata
+byte *KTX_FindKeyValue(byte *data, uint datasize, const char *key, uint *valueSize)
 {
-	uint keyLen, newSize, keyAndValueSize, valuePadding;
-	byte *stream;
+	uint keyAndValueSize, keyLen;
+	byte *end;
 
-	// allocate and expand
 	keyLen = strlen(key) + 1;
-	keyAndValueSize = keyLen + dataSize;
-	valuePadding = ((keyAndValueSize/4)*4 - keyAndValueSize);
-	newSize = 4 + keyAndValueSize + valuePadding;
-	if (!*keyDataSize)
+	end = data + datasize;
+	while(data + 4 <= end)
 	{
-		*keyDataSize = newSize;
-		*keyData = (byte *)mem_alloc(newSize);
-		stream = *keyData;
+		keyAndValueSize = *((uint *)data);
+		if (keyAndValueSize > (uint)(end - data) - 4)
+			break;
+		if (keyAndValueSize >= keyLen && !memcmp(data + 4, key, keyLen))
+		{
+			if (valueSize)
+				*valueSize = keyAndValueSize - keyLen;
+			return data + 4 + keyLen;
+		}
+		data += 4 + keyAndValueSize + (4 - keyAndValueSize % 4) % 4;
 	}
-	else
+	return NULL;
+}
+
+void KTX_AddKeyValue(KTX_KeyValue *pairs, int *numPairs, const char *key, const void *value, uint valueSize)
+{
+	pairs[*numPairs].key = key;
+	pairs[*numPairs].value = (const byte *)value;
+	pairs[*numPairs].valueSize = valueSize;
+	(*numPairs)++;
+}
+
+// write key/value pairs to KTX metadata datastream, allocated at once
+byte *KTX_WriteKeyValueData(KTX_KeyValue *pairs, int numPairs, uint *outsize)
+{
+	uint keyLen, keyAndValueSize, size;
+	byte *data, *stream;
+	int i;
+
+	// measure
+	size = 0;
+	for (i = 0; i < numPairs; i++)
 	{
-		*keyData = (byte *)mem_realloc(*keyData, *keyDataSize + newSize);
-		stream = *keyData + *keyDataSize;
-		*keyDataSize = *keyDataSize + newSize;
+		keyAndValueSize = strlen(pairs[i].key) + 1 + pairs[i].valueSize;
+		size += 4 + keyAndValueSize + (4 - keyAndValueSize % 4) % 4;
 	}
+	*outsize = size;
+	if (!size)
+		return NULL;
+
 	// write
-	memcpy(stream, &keyAndValueSize, 4);
-	memcpy(stream + 4, key, keyLen);
-	memcpy(stream + 4 + keyLen, data, dataSize);
-	memset(stream + 4 + keyLen + dataSize, 0, valuePadding);
+	data = (byte *)mem_alloc(size);
+	memset(data, 0, size);
+	stream = data;
+	for (i = 0; i < numPairs; i++)
+	{
+		keyLen = strlen(pairs[i].key) + 1;
+		keyAndValueSize = keyLen + pairs[i].valueSize;
+		memcpy(stream, &keyAndValueSize, 4);
+		memcpy(stream + 4, pairs[i].key, keyLen);
+		if (pairs[i].valueSize)
+			memcpy(stream + 4 + keyLen, pairs[i].value, pairs[i].valueSize);
+		stream += 4 + keyAndValueSize + (4 - keyAndValueSize % 4) % 4;
+	}
+	return data;
 }
 
-void KTX_WriteKeyPair(char *key, char *string, byte **keyData, uint *keyDataSize)
-{
-	KTX_WriteKeyPair(key, (byte *)string, strlen(string), keyData, keyDataSize);
-}
+/*
+==========================================================================================
+
+  KTX
+
+==========================================================================================
+*/
 
 void KTX_PrintHeader(byte *data)
 {
 	byte *kv, *end;
 	char *key, *value;
-	size_t valueSize;
+	uint valueSize;
 	KTX_HEADER *header;
 
 	header = (KTX_HEADER *)data;
@@ -131,19 +180,22 @@ void KTX_PrintHeader(byte *data)
 
 byte *KTX_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize)
 {
+	KTX_KeyValue pairs[6];
+	int numPairs = 0;
+
 	// generate KTX metadata key/value pairs
-	byte *keyData = NULL;
-	uint keyDataSize = 0;
-	KTX_WriteKeyPair("KTXorientation", "S=r,T=d,R=i", &keyData, &keyDataSize);
-	KTX_WriteKeyPair("fourCC", (byte *)format->fourCC, 4, &keyData, &keyDataSize);
+	KTX_AddKeyValue(pairs, &numPairs, "KTXorientation", "S=r,T=d,R=i", 11);
+	KTX_AddKeyValue(pairs, &numPairs, "fourCC", &format->fourCC, 4);
 	if (tex_useSign)
-		KTX_WriteKeyPair("comment", tex_sign, &keyData, &keyDataSize);
+		KTX_AddKeyValue(pairs, &numPairs, "comment", tex_sign, strlen(tex_sign));
 	if (image->hasAverageColor)
-		KTX_WriteKeyPair("avgColor", image->averagecolor, 3, &keyData, &keyDataSize);
+		KTX_AddKeyValue(pairs, &numPairs, "avgColor", image->averagecolor, 3);
 	if (image->maps->sRGB)
-		KTX_WriteKeyPair("sRGBcolorspace", 0, 0, &keyData, &keyDataSize);
+		KTX_AddKeyValue(pairs, &numPairs, "sRGBcolorspace", NULL, 0);
 	if (image->datatype == IMAGE_NORMALMAP)
-		KTX_WriteKeyPair("normalmap", 0, 0, &keyData, &keyDataSize);
+		KTX_AddKeyValue(pairs, &numPairs, "normalmap", NULL, 0);
+	uint keyDataSize;
+	byte *keyData = KTX_WriteKeyValueData(pairs, numPairs, &keyDataSize);
 
 	// create header
 	byte *head = (byte *)mem_alloc(sizeof(KTX_HEADER) + keyDataSize);
@@ -161,11 +213,12 @@ byte *KTX_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize)
 	ktx->pixelHeight = image->height;
 	ktx->pixelDepth = 0;
 	ktx->numberOfArrayElements = 0;
-	ktx->numberOfFaces = 0;
+	ktx->numberOfFaces = 1;
 	ktx->numberOfMipmapLevels = 0;
 	for (ImageMap *map = image->maps; map; map = map->next) ktx->numberOfMipmapLevels++;
 	ktx->bytesOfKeyValueData = keyDataSize;
 
+	*outsize = sizeof(KTX_HEADER) + keyDataSize;
 	return head;
 }
 
@@ -175,7 +228,117 @@ size_t KTX_WriteMipHeader(byte *stream, size_t width, size_t height, size_t pixe
 	return 4;
 }
 
+// tools write levels back to back, insert imageSize and mip padding
+// stream is allocated with room for them, so levels are moved in place starting from the last one
+void KTX_PackStream(TexEncodeTask *task)
+{
+	vector<size_t> sizes;
+	size_t headersize, src, dst, padded;
+	KTX_HEADER *header;
+	int level;
+
+	header = (KTX_HEADER *)task->stream;
+	headersize = sizeof(KTX_HEADER) + header->bytesOfKeyValueData;
+	src = dst = headersize;
+	for (ImageMap *map = task->image->maps; map; map = map->next)
+	{
+		sizes.push_back(compressedLevelSize(task->format, map->width, map->height));
+		src += sizes.back();
+		dst += 4 + (sizes.back() + 3) / 4 * 4;
+	}
+	for (level = (int)sizes.size() - 1; level >= 0; level--)
+	{
+		padded = (sizes[level] + 3) / 4 * 4;
+		src -= sizes[level];
+		dst -= 4 + padded;
+		memmove(task->stream + dst + 4, task->stream + src, sizes[level]);
+		memset(task->stream + dst + 4 + sizes[level], 0, padded - sizes[level]);
+		KTX_WriteMipHeader(task->stream + dst, 0, 0, sizes[level]);
+	}
+}
+
 bool KTX_Read(TexDecodeTask *task)
 {
-	return false;
-}
\ No newline at end of file
+	KTX_HEADER *header;
+	byte *kvd, *value, *in, *end, *out;
+	uint valueSize, imageSize;
+	size_t total;
+	int levels, level;
+
+	// validate header
+	if (task->datasize < sizeof(KTX_HEADER))
+	{
+		sprintf(task->errorMessage, "failed to read KTX header");
+		return false;
+	}
+	header = (KTX_HEADER *)task->data;
+	if (header->endianness != 0x04030201) { sprintf(task->errorMessage, "big endian files are not supported"); return false; }
+	if (header->pixelDepth > 1 || header->numberOfArrayElements > 1 || header->numberOfFaces > 1) { sprintf(task->errorMessage, "3D textures, arrays and cubemaps are not supported"); return false; }
+	if (sizeof(KTX_HEADER) + header->bytesOfKeyValueData > task->datasize) { sprintf(task->errorMessage, "key/value data is out of file"); return false; }
+	kvd = task->data + sizeof(KTX_HEADER);
+
+	// detect file type, fourCC key tells swizzled formats
+	findFormatByGLType(header->glFormat, header->glInternalFormat, header->glType, &task->codec, &task->format);
+	value = KTX_FindKeyValue(kvd, header->bytesOfKeyValueData, "fourCC", &valueSize);
+	if (value && valueSize == 4)
+		findFormatByFourCCAndAlpha(*(DWORD *)value, (task->format && (task->format->features & FF_ALPHA)) ? true : false, &task->codec, &task->format);
+	if (!task->codec)
+	{
+		sprintf(task->errorMessage, "failed to find decoder");
+		return false;
+	}
+
+	// read metadata
+	value = KTX_FindKeyValue(kvd, header->bytesOfKeyValueData, "comment", &valueSize);
+	if (value)
+	{
+		task->comment = (char *)mem_alloc(valueSize + 1);
+		memcpy(task->comment, value, valueSize);
+		task->comment[valueSize] = 0;
+	}
+	value = KTX_FindKeyValue(kvd, header->bytesOfKeyValueData, "avgColor", &valueSize);
+	if (value && valueSize == 3)
+	{
+		task->ImageParms.hasAverageColor = true;
+		task->ImageParms.averagecolor[0] = value[0];
+		task->ImageParms.averagecolor[1] = value[1];
+		task->ImageParms.averagecolor[2] = value[2];
+	}
+	task->ImageParms.hasAlpha = (task->format->features & FF_ALPHA) ? true : false;
+	task->ImageParms.colorSwap = (task->codec == &CODEC_BGRA) ? true : false;
+	task->ImageParms.isNormalmap = KTX_FindKeyValue(kvd, header->bytesOfKeyValueData, "normalmap", NULL) ? true : false;
+	task->ImageParms.sRGB = KTX_FindKeyValue(kvd, header->bytesOfKeyValueData, "sRGBcolorspace", NULL) ? true : false;
+	levels = max(1, (int)header->numberOfMipmapLevels);
+	task->numMipmaps = levels - 1;
+	task->width = header->pixelWidth;
+	task->height = header->pixelHeight;
+
+	// strip imageSize and mip padding
+	end = task->data + task->datasize;
+	in = kvd + header->bytesOfKeyValueData;
+	total = 0;
+	for (level = 0; level < levels; level++)
+	{
+		if (in + 4 > end || *(uint *)in > (size_t)(end - in) - 4)
+		{
+			sprintf(task->errorMessage, "level %i is out of file", level);
+			return false;
+		}
+		imageSize = *(uint *)in;
+		total += imageSize;
+		in += 4 + (imageSize + 3) / 4 * 4;
+	}
+	task->unpacked = (byte *)mem_alloc(max(total, 1));
+	in = kvd + header->bytesOfKeyValueData;
+	out = task->unpacked;
+	for (level = 0; level < levels; level++)
+	{
+		imageSize = *(uint *)in;
+		memcpy(out, in + 4, imageSize);
+		out += imageSize;
+		in += 4 + (imageSize + 3) / 4 * 4;
+	}
+	task->pixeldata = task->unpacked;
+	task->pixeldatasize = total;
+	return true;
+}
@@ -9,6 +9,20 @@ void   KTX_PrintHeader(byte *data);
 byte  *KTX_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize);
 size_t KTX_WriteMipHeader(byte *stream, size_t width, size_t height, size_t pixeldatasize);
 bool   KTX_Read(TexDecodeTask *task);
+void   KTX_PackStream(TexEncodeTask *task);
+
+// key/value metadata (shared with KTX2)
+typedef struct
+{
+	const char *key;
+	const byte *value;
+	uint        valueSize;
+} KTX_KeyValue;
+
+void   KTX_AddKeyValue(KTX_KeyValue *pairs, int *numPairs, const char *key, const void *value, uint valueSize);
+byte  *KTX_WriteKeyValueData(KTX_KeyValue *pairs, int numPairs, uint *outsize);
+char  *KTX_ReadKeyPair(byte **stream, char **key, uint *valueSize);
+byte  *KTX_FindKeyValue(byte *data, uint datasize, const char *key, uint *valueSize);
 
 // KTX file strucrure
 const char KTX_IDENTIFIER[12] = { '', 'K', 'T', 'X', ' ', '1', '1', '', '\r', '\n', '\x1A', '\n' };
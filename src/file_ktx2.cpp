@@ -0,0 +1,529 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / KTX2 file format
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#define F_FILE_KTX2_C
+#include "main.h"
+#include "tex.h"
+
+TexContainer CONTAINER_KTX2 =
+{
+	"KTX2", "Khronos Texture 2 (.KTX2)", "ktx2", 12,
+	&KTX2_Scan,
+	sizeof(KTX2_HEADER), 0, 0,
+	&KTX2_PrintHeader,
+	&KTX2_CreateHeader,
+	NULL,
+	&KTX2_Read,
+	&KTX2_PackStream,
+};
+
+#define KTX2_WRITER "RwgTex " RWGTEX_VERSION_MAJOR "." RWGTEX_VERSION_MINOR
+
+/*
+==========================================================================================
+
+  Zstandard
+
+==========================================================================================
+*/
+
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+
+#define ZSTD_c_compressionLevel 100
+#define ZSTD_c_nbWorkers        400
+
+static ZSTD_CCtx  *(*qZSTD_createCCtx)(void);
+static size_t      (*qZSTD_freeCCtx)(ZSTD_CCtx *cctx);
+static size_t      (*qZSTD_CCtx_setParameter)(ZSTD_CCtx *cctx, int param, int value);
+static size_t      (*qZSTD_compress2)(ZSTD_CCtx *cctx, void *dst, size_t dstCapacity, const void *src, size_t srcSize);
+static size_t      (*qZSTD_compressBound)(size_t srcSize);
+static size_t      (*qZSTD_decompress)(void *dst, size_t dstCapacity, const void *src, size_t compressedSize);
+static unsigned    (*qZSTD_isError)(size_t code);
+static const char *(*qZSTD_getErrorName)(size_t code);
+
+static const char *zstd_dllnames[] =
+{
+#ifdef WIN32
+	"libzstd.dll",
+	"zstd.dll",
+#else
+	"libzstd.so.1",
+	"libzstd.so",
+#endif
+	NULL
+};
+
+static dllfunction_t zstd_funcs[] =
+{
+	{ "ZSTD_createCCtx",         (void **)&qZSTD_createCCtx },
+	{ "ZSTD_freeCCtx",           (void **)&qZSTD_freeCCtx },
+	{ "ZSTD_CCtx_setParameter",  (void **)&qZSTD_CCtx_setParameter },
+	{ "ZSTD_compress2",          (void **)&qZSTD_compress2 },
+	{ "ZSTD_compressBound",      (void **)&qZSTD_compressBound },
+	{ "ZSTD_decompress",         (void **)&qZSTD_decompress },
+	{ "ZSTD_isError",            (void **)&qZSTD_isError },
+	{ "ZSTD_getErrorName",       (void **)&qZSTD_getErrorName },
+	{ NULL, NULL }
+};
+
+static dllhandle_t zstd_dll = NULL;
+
+bool KTX2_LoadZstd(void)
+{
+	if (!zstd_dll)
+		LoadDll(zstd_dllnames, &zstd_dll, zstd_funcs, false);
+	return zstd_dll ? true : false;
+}
+
+void KTX2_UnloadZstd(void)
+{
+	if (zstd_dll)
+		UnloadDll(&zstd_dll);
+	zstd_dll = NULL;
+}
+
+bool KTX2_ZstdLoaded(void)
+{
+	return zstd_dll ? true : false;
+}
+
+/*
+==========================================================================================
+
+  Formats
+
+==========================================================================================
+*/
+
+// Khronos data format descriptor constants
+#define KHR_DF_MODEL_RGBSDA         1
+#define KHR_DF_MODEL_BC1A           128
+#define KHR_DF_MODEL_BC2            129
+#define KHR_DF_MODEL_BC3            130
+#define KHR_DF_MODEL_ETC1           160
+#define KHR_DF_MODEL_ETC2           161
+#define KHR_DF_MODEL_PVRTC          164
+#define KHR_DF_MODEL_PVRTC2         165
+#define KHR_DF_PRIMARIES_BT709      1
+#define KHR_DF_TRANSFER_LINEAR      1
+#define KHR_DF_TRANSFER_SRGB        2
+#define KHR_DF_FLAG_PREMULTIPLIED   1
+#define KHR_DF_CHANNEL_ALPHA        15
+#define KHR_DF_SAMPLE_LINEAR        0x10
+
+// vkFormat and data format descriptor of texture format
+typedef struct
+{
+	TexFormat *format;
+	uint       vkFormat;
+	uint       vkFormat_SRGB;
+	byte       colorModel;
+	byte       blockWidth;
+	byte       blockHeight;
+	byte       blockBytes;
+	byte       flags;
+	int        numSamples;
+	byte       channels[4]; // channel of each sample, by increasing bit offset
+} KTX2_Format;
+
+static KTX2_Format ktx2_formats[] =
+{
+	{ &F_DXT1,            131,        132,        KHR_DF_MODEL_BC1A,   4, 4, 8,  0, 1, { 0 } },
+	{ &F_DXT1A,           133,        134,        KHR_DF_MODEL_BC1A,   4, 4, 8,  0, 1, { 1 } },
+	{ &F_DXT2,            135,        136,        KHR_DF_MODEL_BC2,    4, 4, 16, KHR_DF_FLAG_PREMULTIPLIED, 2, { KHR_DF_CHANNEL_ALPHA, 0 } },
+	{ &F_DXT3,            135,        136,        KHR_DF_MODEL_BC2,    4, 4, 16, 0, 2, { KHR_DF_CHANNEL_ALPHA, 0 } },
+	{ &F_DXT4,            137,        138,        KHR_DF_MODEL_BC3,    4, 4, 16, KHR_DF_FLAG_PREMULTIPLIED, 2, { KHR_DF_CHANNEL_ALPHA, 0 } },
+	{ &F_DXT5,            137,        138,        KHR_DF_MODEL_BC3,    4, 4, 16, 0, 2, { KHR_DF_CHANNEL_ALPHA, 0 } },
+	{ &F_ETC1,            147,        148,        KHR_DF_MODEL_ETC1,   4, 4, 8,  0, 1, { 0 } },
+	{ &F_ETC2,            147,        148,        KHR_DF_MODEL_ETC2,   4, 4, 8,  0, 1, { 2 } },
+	{ &F_ETC2A1,          149,        150,        KHR_DF_MODEL_ETC2,   4, 4, 8,  0, 1, { 2 } },
+	{ &F_ETC2A,           151,        152,        KHR_DF_MODEL_ETC2,   4, 4, 16, 0, 2, { KHR_DF_CHANNEL_ALPHA, 2 } },
+	{ &F_EAC1,            153,        153,        KHR_DF_MODEL_ETC2,   4, 4, 8,  0, 1, { 0 } },
+	{ &F_EAC2,            155,        155,        KHR_DF_MODEL_ETC2,   4, 4, 16, 0, 2, { 0, 1 } },
+	{ &F_PVRTC_2BPP_RGB,  1000054000, 1000054004, KHR_DF_MODEL_PVRTC,  8, 4, 8,  0, 1, { 0 } },
+	{ &F_PVRTC_2BPP_RGBA, 1000054000, 1000054004, KHR_DF_MODEL_PVRTC,  8, 4, 8,  0, 1, { 0 } },
+	{ &F_PVRTC_4BPP_RGB,  1000054001, 1000054005, KHR_DF_MODEL_PVRTC,  4, 4, 8,  0, 1, { 0 } },
+	{ &F_PVRTC_4BPP_RGBA, 1000054001, 1000054005, KHR_DF_MODEL_PVRTC,  4, 4, 8,  0, 1, { 0 } },
+	{ &F_PVRTC2_2BPP,     1000054002, 1000054006, KHR_DF_MODEL_PVRTC2, 8, 4, 8,  0, 1, { 0 } },
+	{ &F_PVRTC2_4BPP,     1000054003, 1000054007, KHR_DF_MODEL_PVRTC2, 4, 4, 8,  0, 1, { 0 } },
+	{ &F_BGRA,            44,         50,         KHR_DF_MODEL_RGBSDA, 1, 1, 4,  0, 4, { 2, 1, 0, KHR_DF_CHANNEL_ALPHA } },
+	// alpha is packed into color bits, only RwgTex can read it (by fourCC key)
+	{ &F_BGR6,            30,         36,         KHR_DF_MODEL_RGBSDA, 1, 1, 3,  0, 3, { 2, 1, 0 } },
+	{ &F_BGR3,            30,         36,         KHR_DF_MODEL_RGBSDA, 1, 1, 3,  0, 3, { 2, 1, 0 } },
+	{ &F_BGR1,            30,         36,         KHR_DF_MODEL_RGBSDA, 1, 1, 3,  0, 3, { 2, 1, 0 } },
+	{ NULL }
+};
+
+// swizzled formats share vkFormat with base format
+KTX2_Format *KTX2_FindFormat(TexFormat *format)
+{
+	if (format->baseFormat)
+		format = format->baseFormat;
+	for (KTX2_Format *f = ktx2_formats; f->format; f++)
+		if (f->format == format)
+			return f;
+	return NULL;
+}
+
+KTX2_Format *KTX2_FindVkFormat(uint vkFormat)
+{
+	for (KTX2_Format *f = ktx2_formats; f->format; f++)
+		if ((f->vkFormat == vkFormat || f->vkFormat_SRGB == vkFormat) && !f->format->colorSwizzle)
+			return f;
+	return NULL;
+}
+
+size_t KTX2_DFDSize(KTX2_Format *f)
+{
+	return 4 + 24 + 16 * f->numSamples;
+}
+
+// data format descriptor with single basic descriptor block
+void KTX2_WriteDFD(uint *dfd, KTX2_Format *f, bool sRGB)
+{
+	uint bits, channel;
+	int i;
+
+	dfd[0] = (uint)KTX2_DFDSize(f);
+	dfd[1] = 0; // Khronos vendor, basic descriptor
+	dfd[2] = 2 | ((24 + 16 * f->numSamples) << 16); // version 2, descriptor block size
+	dfd[3] = f->colorModel | (KHR_DF_PRIMARIES_BT709 << 8) | ((sRGB ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16) | (f->flags << 24);
+	dfd[4] = (f->blockWidth - 1) | ((f->blockHeight - 1) << 8);
+	dfd[5] = f->blockBytes;
+	dfd[6] = 0;
+	bits = f->blockBytes * 8 / f->numSamples;
+	for (i = 0; i < f->numSamples; i++)
+	{
+		channel = f->channels[i];
+		if (sRGB && channel == KHR_DF_CHANNEL_ALPHA)
+			channel |= KHR_DF_SAMPLE_LINEAR;
+		dfd[7 + i*4 + 0] = (i * bits) | ((bits - 1) << 16) | (channel << 24);
+		dfd[7 + i*4 + 1] = 0; // sample position
+		dfd[7 + i*4 + 2] = 0; // lower
+		dfd[7 + i*4 + 3] = (f->colorModel == KHR_DF_MODEL_RGBSDA) ? 255 : 0xFFFFFFFF; // upper
+	}
+}
+
+/*
+==========================================================================================
+
+  KTX2
+
+==========================================================================================
+*/
+
+bool KTX2_Scan(byte *data)
+{
+	if (memcmp(data, &KTX2_IDENTIFIER, 12))
+		return false;
+	return true;
+}
+
+void KTX2_PrintHeader(byte *data)
+{
+	byte *kv, *end;
+	char *key, *value;
+	uint valueSize, level;
+	KTX2_HEADER *header;
+	KTX2_LEVEL *index;
+
+	header = (KTX2_HEADER *)data;
+	Print("KTX2 header:\n");
+	Print("  vkFormat: %i\n", header->vkFormat);
+	Print("  typeSize: %i\n", header->typeSize);
+	Print("  pixelWidth: %i\n", header->pixelWidth);
+	Print("  pixelHeight: %i\n", header->pixelHeight);
+	Print("  pixelDepth: %i\n", header->pixelDepth);
+	Print("  layerCount: %i\n", header->layerCount);
+	Print("  faceCount: %i\n", header->faceCount);
+	Print("  levelCount: %i\n", header->levelCount);
+	Print("  supercompressionScheme: %i\n", header->supercompressionScheme);
+	Print("  dfdByteOffset: %i\n", header->dfdByteOffset);
+	Print("  dfdByteLength: %i\n", header->dfdByteLength);
+	Print("  kvdByteOffset: %i\n", header->kvdByteOffset);
+	Print("  kvdByteLength: %i\n", header->kvdByteLength);
+	index = (KTX2_LEVEL *)(data + sizeof(KTX2_HEADER));
+	for (level = 0; level < max(1u, header->levelCount); level++)
+		Print("  level %i: offset %i, length %i, uncompressed length %i\n", level, (int)index[level].byteOffset, (int)index[level].byteLength, (int)index[level].uncompressedByteLength);
+	if (header->kvdByteLength)
+	{
+		Print("KTX2 metadata:\n");
+		kv = data + header->kvdByteOffset;
+		end = kv + header->kvdByteLength;
+		while(kv < end)
+		{
+			value = KTX_ReadKeyPair(&kv, &key, &valueSize);
+			Print("  %s: %s\n", key, value);
+			mem_free(value);
+		}
+	}
+}
+
+// level index is filled by KTX2_PackStream as tools write levels back to back
+byte *KTX2_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize)
+{
+	KTX_KeyValue pairs[6];
+	KTX2_HEADER *ktx;
+	KTX2_Format *f;
+	uint levels, keyDataSize;
+	size_t dfdSize, size;
+	int numPairs = 0;
+	byte *head;
+
+	f = KTX2_FindFormat(format);
+	if (!f)
+		Error("KTX2_CreateHeader: %s format is not supported\n", format->name);
+	levels = 0;
+	for (ImageMap *map = image->maps; map; map = map->next)
+		levels++;
+
+	// generate KTX2 metadata key/value pairs, sorted by key
+	KTX_AddKeyValue(pairs, &numPairs, "KTXorientation", "rd", 3);
+	KTX_AddKeyValue(pairs, &numPairs, "KTXwriter", KTX2_WRITER, sizeof(KTX2_WRITER));
+	if (image->hasAverageColor)
+		KTX_AddKeyValue(pairs, &numPairs, "avgColor", image->averagecolor, 3);
+	if (tex_useSign)
+		KTX_AddKeyValue(pairs, &numPairs, "comment", tex_sign, strlen(tex_sign));
+	KTX_AddKeyValue(pairs, &numPairs, "fourCC", &format->fourCC, 4);
+	if (image->datatype == IMAGE_NORMALMAP)
+		KTX_AddKeyValue(pairs, &numPairs, "normalmap", NULL, 0);
+	byte *keyData = KTX_WriteKeyValueData(pairs, numPairs, &keyDataSize);
+
+	// create header
+	dfdSize = KTX2_DFDSize(f);
+	size = sizeof(KTX2_HEADER) + levels * sizeof(KTX2_LEVEL) + dfdSize + keyDataSize;
+	head = (byte *)mem_alloc(size);
+	memset(head, 0, size);
+	ktx = (KTX2_HEADER *)head;
+	memcpy(ktx->identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	ktx->vkFormat = image->maps->sRGB ? f->vkFormat_SRGB : f->vkFormat;
+	ktx->typeSize = 1;
+	ktx->pixelWidth = image->width;
+	ktx->pixelHeight = image->height;
+	ktx->pixelDepth = 0;
+	ktx->layerCount = 0;
+	ktx->faceCount = 1;
+	ktx->levelCount = levels;
+	ktx->supercompressionScheme = KTX2_SUPERCOMPRESSION_NONE;
+	ktx->dfdByteOffset = sizeof(KTX2_HEADER) + levels * sizeof(KTX2_LEVEL);
+	ktx->dfdByteLength = (uint)dfdSize;
+	ktx->kvdByteOffset = keyDataSize ? ktx->dfdByteOffset + ktx->dfdByteLength : 0;
+	ktx->kvdByteLength = keyDataSize;
+	KTX2_WriteDFD((uint *)(head + ktx->dfdByteOffset), f, image->maps->sRGB);
+	if (keyDataSize)
+		memcpy(head + ktx->kvdByteOffset, keyData, keyDataSize);
+	mem_free(keyData);
+
+	*outsize = size;
+	return head;
+}
+
+// store levels smallest first (so files can be streamed), supercompressed with given scheme
+// returns false if supercompression failed, no stream is allocated then
+bool KTX2_WriteLevels(TexEncodeTask *task, KTX2_Format *f, size_t headersize, uint scheme, byte **outstream, size_t *outsize)
+{
+	vector<size_t> sizes, offsets;
+	size_t capacity, pos, len;
+	KTX2_HEADER *header;
+	KTX2_LEVEL *index;
+	ZSTD_CCtx *cctx;
+	uint align;
+	byte *out;
+	int level;
+
+	// uncompressed levels are aligned to lcm(texel block size, 4)
+	align = 1;
+	if (scheme == KTX2_SUPERCOMPRESSION_NONE)
+		align = (f->blockBytes % 4 == 0) ? f->blockBytes : ((f->blockBytes % 2 == 0) ? f->blockBytes * 2 : f->blockBytes * 4);
+
+	// measure
+	capacity = pos = headersize;
+	for (ImageMap *map = task->image->maps; map; map = map->next)
+	{
+		sizes.push_back(compressedLevelSize(task->format, map->width, map->height));
+		offsets.push_back(pos);
+		pos += sizes.back();
+		capacity += align - 1 + ((scheme == KTX2_SUPERCOMPRESSION_ZSTD) ? qZSTD_compressBound(sizes.back()) : sizes.back());
+	}
+	out = (byte *)mem_alloc(capacity);
+	memcpy(out, task->stream, headersize);
+	header = (KTX2_HEADER *)out;
+	index = (KTX2_LEVEL *)(out + sizeof(KTX2_HEADER));
+
+	// write
+	cctx = NULL;
+	if (scheme == KTX2_SUPERCOMPRESSION_ZSTD)
+	{
+		cctx = qZSTD_createCCtx();
+		qZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, tex_zstdLevel);
+		if (tex_zstdThreads > 0)
+			qZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, tex_zstdThreads); // fails silently on single-threaded libzstd
+	}
+	pos = headersize;
+	for (level = (int)sizes.size() - 1; level >= 0; level--)
+	{
+		len = (pos + align - 1) / align * align;
+		memset(out + pos, 0, len - pos);
+		pos = len;
+		if (cctx)
+		{
+			len = qZSTD_compress2(cctx, out + pos, capacity - pos, task->stream + offsets[level], sizes[level]);
+			if (qZSTD_isError(len))
+			{
+				Warning("KTX2_PackStream(%s): zstd failed - %s, levels are stored without supercompression", task->file->name.c_str(), qZSTD_getErrorName(len));
+				qZSTD_freeCCtx(cctx);
+				mem_free(out);
+				return false;
+			}
+		}
+		else
+		{
+			len = sizes[level];
+			memcpy(out + pos, task->stream + offsets[level], len);
+		}
+		index[level].byteOffset = pos;
+		index[level].byteLength = len;
+		index[level].uncompressedByteLength = sizes[level];
+		pos += len;
+	}
+	if (cctx)
+		qZSTD_freeCCtx(cctx);
+	header->supercompressionScheme = scheme;
+	// supercompressed levels have no fixed bytes per plane
+	if (scheme != KTX2_SUPERCOMPRESSION_NONE)
+		((uint *)(out + header->dfdByteOffset))[5] = 0;
+
+	*outstream = out;
+	*outsize = pos;
+	return true;
+}
+
+void KTX2_PackStream(TexEncodeTask *task)
+{
+	size_t headersize, size;
+	KTX2_HEADER *header;
+	uint scheme;
+	byte *out;
+
+	header = (KTX2_HEADER *)task->stream;
+	headersize = header->dfdByteOffset + header->dfdByteLength + header->kvdByteLength;
+	scheme = (tex_zstdLevel > 0 && zstd_dll) ? KTX2_SUPERCOMPRESSION_ZSTD : KTX2_SUPERCOMPRESSION_NONE;
+	if (!KTX2_WriteLevels(task, KTX2_FindFormat(task->format), headersize, scheme, &out, &size))
+		KTX2_WriteLevels(task, KTX2_FindFormat(task->format), headersize, KTX2_SUPERCOMPRESSION_NONE, &out, &size);
+	mem_free(task->stream);
+	task->stream = out;
+	task->streamLen = size;
+}
+
+bool KTX2_Read(TexDecodeTask *task)
+{
+	KTX2_HEADER *header;
+	KTX2_LEVEL *index;
+	KTX2_Format *f;
+	byte *kvd, *value, *out;
+	uint valueSize, kvdSize, transfer;
+	size_t total, len;
+	int levels, level;
+
+	// validate header
+	if (task->datasize < sizeof(KTX2_HEADER))
+	{
+		sprintf(task->errorMessage, "failed to read KTX2 header");
+		return false;
+	}
+	header = (KTX2_HEADER *)task->data;
+	levels = max(1, (int)header->levelCount);
+	if (header->pixelDepth > 1 || header->layerCount > 1 || header->faceCount > 1) { sprintf(task->errorMessage, "3D textures, arrays and cubemaps are not supported"); return false; }
+	if (header->supercompressionScheme != KTX2_SUPERCOMPRESSION_NONE && header->supercompressionScheme != KTX2_SUPERCOMPRESSION_ZSTD) { sprintf(task->errorMessage, "unsupported supercompression scheme %i", header->supercompressionScheme); return false; }
+	if (header->supercompressionScheme == KTX2_SUPERCOMPRESSION_ZSTD && !zstd_dll) { sprintf(task->errorMessage, "file is zstd supercompressed but zstd library is not loaded"); return false; }
+	if (sizeof(KTX2_HEADER) + levels * sizeof(KTX2_LEVEL) > task->datasize) { sprintf(task->errorMessage, "level index is out of file"); return false; }
+	if ((size_t)header->dfdByteOffset + header->dfdByteLength > task->datasize || header->dfdByteLength < 16) { sprintf(task->errorMessage, "data format descriptor is out of file"); return false; }
+	if ((size_t)header->kvdByteOffset + header->kvdByteLength > task->datasize) { sprintf(task->errorMessage, "key/value data is out of file"); return false; }
+	index = (KTX2_LEVEL *)(task->data + sizeof(KTX2_HEADER));
+	kvd = task->data + header->kvdByteOffset;
+	kvdSize = header->kvdByteLength;
+
+	// detect file type, fourCC key tells swizzled formats
+	f = KTX2_FindVkFormat(header->vkFormat);
+	if (f)
+	{
+		task->codec = f->format->codec;
+		task->format = f->format;
+	}
+	value = KTX_FindKeyValue(kvd, kvdSize, "fourCC", &valueSize);
+	if (value && valueSize == 4)
+		findFormatByFourCCAndAlpha(*(DWORD *)value, (task->format && (task->format->features & FF_ALPHA)) ? true : false, &task->codec, &task->format);
+	if (!task->codec)
+	{
+		sprintf(task->errorMessage, "failed to find decoder");
+		return false;
+	}
+
+	// read metadata
+	value = KTX_FindKeyValue(kvd, kvdSize, "comment", &valueSize);
+	if (value)
+	{
+		task->comment = (char *)mem_alloc(valueSize + 1);
+		memcpy(task->comment, value, valueSize);
+		task->comment[valueSize] = 0;
+	}
+	value = KTX_FindKeyValue(kvd, kvdSize, "avgColor", &valueSize);
+	if (value && valueSize == 3)
+	{
+		task->ImageParms.hasAverageColor = true;
+		task->ImageParms.averagecolor[0] = value[0];
+		task->ImageParms.averagecolor[1] = value[1];
+		task->ImageParms.averagecolor[2] = value[2];
+	}
+	transfer = (((uint *)(task->data + header->dfdByteOffset))[3] >> 16) & 0xFF;
+	task->ImageParms.hasAlpha = (task->format->features & FF_ALPHA) ? true : false;
+	task->ImageParms.colorSwap = (task->codec == &CODEC_BGRA) ? true : false;
+	task->ImageParms.isNormalmap = KTX_FindKeyValue(kvd, kvdSize, "normalmap", NULL) ? true : false;
+	task->ImageParms.sRGB = (transfer == KHR_DF_TRANSFER_SRGB) ? true : false;
+	task->numMipmaps = levels - 1;
+	task->width = header->pixelWidth;
+	task->height = header->pixelHeight;
+
+	// unpack levels base first
+	total = 0;
+	for (level = 0; level < levels; level++)
+	{
+		if (index[level].byteOffset + index[level].byteLength > task->datasize)
+		{
+			sprintf(task->errorMessage, "level %i is out of file", level);
+			return false;
+		}
+		if (header->supercompressionScheme == KTX2_SUPERCOMPRESSION_NONE && index[level].byteLength != index[level].uncompressedByteLength)
+		{
+			sprintf(task->errorMessage, "level %i has wrong uncompressed length", level);
+			return false;
+		}
+		total += (size_t)index[level].uncompressedByteLength;
+	}
+	task->unpacked = (byte *)mem_alloc(max(total, 1));
+	out = task->unpacked;
+	for (level = 0; level < levels; level++)
+	{
+		len = (size_t)index[level].uncompressedByteLength;
+		if (header->supercompressionScheme == KTX2_SUPERCOMPRESSION_ZSTD)
+		{
+			size_t r = qZSTD_decompress(out, len, task->data + index[level].byteOffset, (size_t)index[level].byteLength);
+			if (qZSTD_isError(r) || r != len)
+			{
+				sprintf(task->errorMessage, "level %i zstd decompression failed", level);
+				return false;
+			}
+		}
+		else
+			memcpy(out, task->data + index[level].byteOffset, len);
+		out += len;
+	}
+	task->pixeldata = task->unpacked;
+	task->pixeldatasize = total;
+	return true;
+}
@@ -0,0 +1,48 @@
+// file_ktx2.h
+#ifndef H_FILE_KTX2_H
+#define H_FILE_KTX2_H
+
+extern TexContainer CONTAINER_KTX2;
+
+bool   KTX2_Scan(byte *data);
+void   KTX2_PrintHeader(byte *data);
+byte  *KTX2_CreateHeader(LoadedImage *image, TexFormat *format, size_t *outsize);
+bool   KTX2_Read(TexDecodeTask *task);
+void   KTX2_PackStream(TexEncodeTask *task);
+
+// Zstandard library (loaded at runtime)
+bool   KTX2_LoadZstd(void);
+void   KTX2_UnloadZstd(void);
+bool   KTX2_ZstdLoaded(void);
+
+// KTX2 file structure
+const char KTX2_IDENTIFIER[12] = { '\xAB', 'K', 'T', 'X', ' ', '2', '0', '\xBB', '\r', '\n', '\x1A', '\n' };
+#define KTX2_SUPERCOMPRESSION_NONE 0
+#define KTX2_SUPERCOMPRESSION_ZSTD 2
+struct KTX2_HEADER
+{
+	byte               identifier[12];
+	uint               vkFormat;
+	uint               typeSize;
+	uint               pixelWidth;
+	uint               pixelHeight;
+	uint               pixelDepth;
+	uint               layerCount;
+	uint               faceCount;
+	uint               levelCount;
+	uint               supercompressionScheme;
+	uint               dfdByteOffset;
+	uint               dfdByteLength;
+	uint               kvdByteOffset;
+	uint               kvdByteLength;
+	unsigned long long sgdByteOffset;
+	unsigned long long sgdByteLength;
+};
+struct KTX2_LEVEL
+{
+	unsigned long long byteOffset;
+	unsigned long long byteLength;
+	unsigned long long uncompressedByteLength;
+};
+
+#endif
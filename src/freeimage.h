@@ -75,6 +75,11 @@ FIBITMAP *fiConvertType(FIBITMAP *bitmap, FREE_IMAGE_TYPE want_type);
 FIBITMAP *fiScale2x(byte *data, int pitch, int width, int height, int bpp, int scaler, bool freeData);
 FIBITMAP *fiScale2x(FIBITMAP *bitmap, int scaler, bool freeSource);
 
+// 3x3 filter passes with clamped edges, generic one goes from in to out, separable one is done in place and needs kernels from fiFilterSeparable
+bool fiFilterSeparable(double *m, double scale, float *v, float *h);
+void fiFilterSeparablePass(byte *data, int pitch, int width, int height, int bpp, float *v, float *h, float bias);
+void fiFilterGenericPass(byte *in, byte *out, int width, int height, int bpp, double *m, double scale, double bias);
+
 // apply a custom filter matrix to bitmap
 FIBITMAP *fiFilter(FIBITMAP *bitmap, double *m, double scale, double bias, int iteractions, bool removeSource);
 
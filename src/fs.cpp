@@ -337,11 +337,17 @@ bool FS_CheckOption(FS_File *file, LoadedImage *loadedimage, TexCalcErrors *erro
 		if (!stricmp(key, "bpp"))
 			IntOp(loadedimage->bpp)
 		else if (!stricmp(key, "width"))
-			IntOp(loadedimage->bpp)
+			IntOp(loadedimage->width)
 		else if (!stricmp(key, "height"))
-			IntOp(loadedimage->bpp)
+			IntOp(loadedimage->height)
 		else if (!stricmp(key, "alpha"))
 			IntOp(loadedimage->hasAlpha ? 1 : 0)
+		else if (!stricmp(key, "alphatype"))
+			EnumOp(loadedimage->stats.alphaClass, ImageAlphaClass, ImageAlphaClasses)
+		else if (!stricmp(key, "grayscale"))
+			IntOp(loadedimage->stats.grayscale ? 1 : 0)
+		else if (!stricmp(key, "colors"))
+			IntOp(loadedimage->stats.numColors)
 		else if (!stricmp(key, "srgb"))
 			IntOp(loadedimage->sRGB ? 1 : 0)
 		else if (!stricmp(key, "type"))
@@ -466,6 +472,16 @@ bool FS_FindFile(char *pattern)
 
 bool AllowFile(FS_File *file)
 {
+	// verify mode picks compressed files (archives are scanned for them)
+	if (tex_verify)
+	{
+		if (FS_FileMatchList(file, tex_archiveFiles.items))
+			return true;
+		for (TexContainer *container = tex_containers; container; container = container->next)
+			if (!stricmp(container->extensionName, file->ext.c_str()))
+				return true;
+		return false;
+	}
 	if (!FS_FileMatchList(file, tex_includeFiles.items))
 		return false;
 	return true;
@@ -599,7 +615,7 @@ byte *FS_LoadFile(FS_File *file, size_t *filesize)
 	byte *filedata;
 
 	sprintf(filename, "%s%s.%s", file->path.c_str(), file->name.c_str(), file->ext.c_str());
-	sprintf(filepath, "%s%s", tex_srcDir, filename);
+	sprintf(filepath, "%s%s", file->basepath.empty() ? tex_srcDir : file->basepath.c_str(), filename);
 
 	// unpack ZIP
 	if (!file->zipfile.empty())
@@ -640,6 +656,75 @@ byte *FS_LoadFile(FS_File *file, size_t *filesize)
 	return filedata;
 }
 
+// load first maxsize bytes of file (or whole file if it is smaller)
+// archive members are unpacked only as far as needed
+byte *FS_LoadFilePart(FS_File *file, size_t maxsize, size_t *readsize)
+{
+	char filepath[MAX_FPATH];
+	byte *filedata;
+	FILE *f;
+
+	*readsize = 0;
+	if (!file->zipfile.empty())
+	{
+		HZIP zh = OpenZip(file->zipfile.c_str(), "");
+		if (!zh)
+			return NULL;
+		ZIPENTRY ze;
+		ZRESULT zr = GetZipItem(zh, file->zipindex, &ze);
+		if (zr != ZR_OK || ze.unc_size <= 0)
+		{
+			CloseZip(zh);
+			return NULL;
+		}
+		*readsize = min(maxsize, (size_t)ze.unc_size);
+		filedata = (byte *)mem_alloc(*readsize);
+		zr = UnzipItem(zh, file->zipindex, filedata, (unsigned int)*readsize);
+		CloseZip(zh);
+		if (zr != ZR_OK && zr != ZR_MORE)
+		{
+			mem_free(filedata);
+			*readsize = 0;
+			return NULL;
+		}
+		return filedata;
+	}
+	sprintf(filepath, "%s%s%s.%s", file->basepath.empty() ? tex_srcDir : file->basepath.c_str(), file->path.c_str(), file->name.c_str(), file->ext.c_str());
+	f = fopen(filepath, "rb");
+	if (!f)
+		return NULL;
+	filedata = (byte *)mem_alloc(maxsize);
+	*readsize = fread(filedata, 1, maxsize, f);
+	fclose(f);
+	return filedata;
+}
+
+// unpacked size of file, 0 if it cannot be opened
+size_t FS_FileSize(FS_File *file)
+{
+	char filepath[MAX_FPATH];
+	size_t filesize;
+	FILE *f;
+
+	if (!file->zipfile.empty())
+	{
+		HZIP zh = OpenZip(file->zipfile.c_str(), "");
+		if (!zh)
+			return 0;
+		ZIPENTRY ze;
+		ZRESULT zr = GetZipItem(zh, file->zipindex, &ze);
+		CloseZip(zh);
+		return (zr == ZR_OK && ze.unc_size > 0) ? (size_t)ze.unc_size : 0;
+	}
+	sprintf(filepath, "%s%s%s.%s", file->basepath.empty() ? tex_srcDir : file->basepath.c_str(), file->path.c_str(), file->name.c_str(), file->ext.c_str());
+	f = fopen(filepath, "rb");
+	if (!f)
+		return 0;
+	filesize = Q_filelength(f);
+	fclose(f);
+	return filesize;
+}
+
 /*
 ==========================================================================================
 
@@ -25,6 +25,16 @@ typedef struct
 	// zip info
 	string zipfile;
 	size_t zipindex;
+
+	// image dimensions, filled by Image_Probe (0 if unknown)
+	int    width;
+	int    height;
+
+	// directory to load file from instead of source dir (empty - source dir)
+	string basepath;
+
+	// predicted processing time (seconds), filled by TexSchedule_Order
+	double cost;
 }
 FS_File;
 
@@ -34,6 +44,8 @@ unsigned int FS_CRC32(char *filename);
 bool         FS_CheckCache(const char *filepath, unsigned int *fileCRC);
 void         FS_ScanPath(char *basepath, const char *singlefile, char *addpath);
 byte        *FS_LoadFile(FS_File *file, size_t *filesize);
+byte        *FS_LoadFilePart(FS_File *file, size_t maxsize, size_t *readsize);
+size_t       FS_FileSize(FS_File *file);
 
 typedef enum
 {
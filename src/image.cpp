@@ -93,17 +93,258 @@ void Image_Delete(LoadedImage *image)
 ==========================================================================================
 */
 
+// SSSE3 kernels for channel reorder, packing and YCoCg conversion
+// selected at runtime by CPUID, scalar loops are used as a fallback and give same results
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || defined(__SSSE3__)
+#define IMAGEDATA_SSSE3
+#endif
+
+#ifdef IMAGEDATA_SSSE3
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+int imagedata_ssse3_state = -1;
+
+bool ImageData_SSSE3(void)
+{
+#ifdef IMAGEDATA_SSSE3
+	if (imagedata_ssse3_state < 0)
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		imagedata_ssse3_state = (info[2] & (1 << 9)) ? 1 : 0;
+#else
+		unsigned int eax, ebx, ecx, edx;
+		imagedata_ssse3_state = (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 9))) ? 1 : 0;
+#endif
+	}
+	return imagedata_ssse3_state ? true : false;
+#else
+	return false;
+#endif
+}
+
+// turn SSSE3 kernels on or off, scalar loops are used when off
+// returns true if SSSE3 kernels are used after the call, benchmark compares both
+bool ImageData_SetSSSE3(bool enable)
+{
+	imagedata_ssse3_state = enable ? -1 : 0;
+	return ImageData_SSSE3();
+}
+
+// ImageData_Shuffle
+// reorder channels of 4 bpp data, order[c] is source channel for channel c or -1 to clear it
+void ImageData_Shuffle(byte *data, int width, int height, int pitch, const int *order)
+{
+	byte *in, *end, saved[4];
+	int x, y, c;
+
+	for (y = 0; y < height; y++)
+	{
+		in = data;
+		x = 0;
+#ifdef IMAGEDATA_SSSE3
+		if (ImageData_SSSE3())
+		{
+			char m[16];
+			for (c = 0; c < 16; c++)
+				m[c] = (order[c & 3] < 0) ? (char)0x80 : (char)((c & ~3) + order[c & 3]);
+			__m128i mask = _mm_setr_epi8(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]);
+			for (; x + 4 <= width; x += 4, in += 16)
+				_mm_storeu_si128((__m128i *)in, _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)in), mask));
+		}
+#endif
+		end = data + width*4;
+		while(in < end)
+		{
+			saved[0] = in[0];
+			saved[1] = in[1];
+			saved[2] = in[2];
+			saved[3] = in[3];
+			for (c = 0; c < 4; c++)
+				in[c] = (order[c] < 0) ? 0 : saved[order[c]];
+			in += 4;
+		}
+		data += pitch;
+	}
+}
+
+// ImageData_CopyPixels
+// copy pixels between 3 and 4 bpp buffers, alpha is set to 255 if opaque is set or source has no alpha
+void ImageData_CopyPixels(byte *out, int outbpp, byte *in, int inbpp, int pixels, bool opaque)
+{
+	byte *end;
+
+	end = out + pixels*outbpp;
+#ifdef IMAGEDATA_SSSE3
+	if (ImageData_SSSE3())
+	{
+		__m128i alpha = _mm_set1_epi32(0xFF000000);
+		if (inbpp == 4 && outbpp == 4)
+		{
+			for (; out + 16 <= end; out += 16, in += 16)
+			{
+				__m128i v = _mm_loadu_si128((__m128i *)in);
+				_mm_storeu_si128((__m128i *)out, opaque ? _mm_or_si128(v, alpha) : v);
+			}
+		}
+		else if (inbpp == 3 && outbpp == 4)
+		{
+			// 16 bytes are loaded for 4 pixels (12 bytes), so 6 pixels should remain
+			__m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			for (; out + 24 <= end; out += 16, in += 12)
+				_mm_storeu_si128((__m128i *)out, _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128((__m128i *)in), mask), alpha));
+		}
+		else if (inbpp == 4 && outbpp == 3)
+		{
+			// 16 bytes are stored for 4 pixels (12 bytes), last 4 are overwritten by next store
+			__m128i mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			for (; out + 16 <= end; out += 12, in += 16)
+				_mm_storeu_si128((__m128i *)out, _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)in), mask));
+		}
+	}
+#endif
+	while(out < end)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		if (outbpp == 4)
+			out[3] = (opaque || inbpp != 4) ? 255 : in[3];
+		out += outbpp;
+		in  += inbpp;
+	}
+}
+
+// ImageData_EncodeYCoCg
+// RGBA -> CoCgAY (or AGCoY if rgbSwap) swizzle, alpha is cleared if dropAlpha is set
+// this is bit-exact with original per-pixel code, including wrap of Co and Cg at 256
+void ImageData_EncodeYCoCg(byte *data, int width, int height, int pitch, bool rgbSwap, bool dropAlpha)
+{
+	int x, y, Y, Co, Cg, A;
+	byte *in;
+
+	for (y = 0; y < height; y++)
+	{
+		in = data;
+		x = 0;
+#ifdef IMAGEDATA_SSSE3
+		if (ImageData_SSSE3())
+		{
+			__m128i c0, c1, c2, c3, vY, vCo, vCg, v;
+			__m128i lo = _mm_set1_epi32(0xFF);
+			__m128i two = _mm_set1_epi32(2);
+			__m128i bias = _mm_set1_epi32(128);
+			for (; x + 4 <= width; x += 4, in += 16)
+			{
+				v = _mm_loadu_si128((__m128i *)in);
+				c0 = _mm_and_si128(v, lo);
+				c1 = _mm_and_si128(_mm_srli_epi32(v, 8), lo);
+				c2 = _mm_and_si128(_mm_srli_epi32(v, 16), lo);
+				c3 = dropAlpha ? _mm_setzero_si128() : _mm_srli_epi32(v, 24);
+				vY  = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(c2, _mm_slli_epi32(c1, 1)), _mm_add_epi32(c0, two)), 2);
+				vCo = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(c2, 1), _mm_slli_epi32(c0, 1)), two), 2), bias);
+				vCg = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(c1, 1), _mm_add_epi32(c2, c0)), two), 2), bias);
+				vCo = _mm_and_si128(vCo, lo);
+				vCg = _mm_and_si128(vCg, lo);
+				if (rgbSwap)
+					v = _mm_or_si128(_mm_or_si128(c3, _mm_slli_epi32(vCg, 8)), _mm_or_si128(_mm_slli_epi32(vCo, 16), _mm_slli_epi32(vY, 24)));
+				else
+					v = _mm_or_si128(_mm_or_si128(vCo, _mm_slli_epi32(vCg, 8)), _mm_or_si128(_mm_slli_epi32(c3, 16), _mm_slli_epi32(vY, 24)));
+				_mm_storeu_si128((__m128i *)in, v);
+			}
+		}
+#endif
+		for (; x < width; x++, in += 4)
+		{
+			Y  = ((in[2] + (in[1] << 1) + in[0]) + 2) >> 2;
+			Co = (((((in[2] << 1) - (in[0] << 1)) + 2) >> 2) + 128) & 0xFF;
+			Cg = ((((-in[2] + (in[1] << 1) - in[0]) + 2) >> 2) + 128) & 0xFF;
+			A  = dropAlpha ? 0 : in[3];
+			in[0] = (byte)(rgbSwap ? A : Co);
+			in[1] = (byte)Cg;
+			in[2] = (byte)(rgbSwap ? Co : A);
+			in[3] = (byte)Y;
+		}
+		data += pitch;
+	}
+}
+
+// ImageData_Premultiply
+// multiply color by alpha, truncating like original float code
+void ImageData_Premultiply(byte *data, int width, int height, int pitch)
+{
+	float mod;
+	byte *in;
+	int x, y;
+
+	for (y = 0; y < height; y++)
+	{
+		in = data;
+		x = 0;
+#ifdef IMAGEDATA_SSSE3
+		if (ImageData_SSSE3())
+		{
+			__m128i lo = _mm_set1_epi32(0xFF);
+			__m128 scale = _mm_set1_ps(255.0f);
+			__m128i v, c0, c1, c2, c3;
+			__m128 m;
+			for (; x + 4 <= width; x += 4, in += 16)
+			{
+				v = _mm_loadu_si128((__m128i *)in);
+				c3 = _mm_srli_epi32(v, 24);
+				m = _mm_div_ps(_mm_cvtepi32_ps(c3), scale);
+				c0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, lo)), m));
+				c1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), lo)), m));
+				c2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), lo)), m));
+				v = _mm_or_si128(_mm_or_si128(c0, _mm_slli_epi32(c1, 8)), _mm_or_si128(_mm_slli_epi32(c2, 16), _mm_slli_epi32(c3, 24)));
+				_mm_storeu_si128((__m128i *)in, v);
+			}
+		}
+#endif
+		for (; x < width; x++, in += 4)
+		{
+			mod = (float)in[3] / 255.0f;
+			in[0] = (byte)(in[0] * mod);
+			in[1] = (byte)(in[1] * mod);
+			in[2] = (byte)(in[2] * mod);
+		}
+		data += pitch;
+	}
+}
+
 // ImageData_SwapRB
 // swap reg and blue channels
 void ImageData_SwapRB(byte *data, int width, int height, int pitch, int bpp)
 {
+	static const int order[4] = { 2, 1, 0, 3 };
 	byte *in, *end, saved;
 	int y;
 
+	if (bpp == 4)
+	{
+		ImageData_Shuffle(data, width, height, pitch, order);
+		return;
+	}
 	for (y = 0; y < height; y++)
 	{
 		in = data;
 		end = in + width*bpp;
+#ifdef IMAGEDATA_SSSE3
+		// 5 RGB pixels per 16 bytes, last byte is kept
+		if (bpp == 3 && ImageData_SSSE3())
+		{
+			__m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+			for (; in + 16 <= end; in += 15)
+				_mm_storeu_si128((__m128i *)in, _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)in), mask));
+		}
+#endif
 		while(in < end)
 		{
 			saved = in[0];
@@ -344,6 +585,107 @@ void Image_CalcAverageColor(LoadedImage *image)
 	image->averagecolor[2] = (byte)(avgcolor[2] * 255.0f);
 }
 
+// gather image statistics in one pass
+// also determines alpha type and average color
+void Image_CalcStats(LoadedImage *image)
+{
+	ImageStats *stats = &image->stats;
+	unsigned int colors[IMAGE_STATS_MAX_COLORS], color, lastcolor;
+	size_t num_grad, need_grad, samples, sum[3];
+	int x, y, c, r, b, pitch;
+	byte *data, *in, mn[4], mx[4];
+	bool gray;
+
+	memset(stats, 0, sizeof(ImageStats));
+	if (!image->bitmap)
+		return;
+	r = image->colorSwap ? 2 : 0;
+	b = image->colorSwap ? 0 : 2;
+	mn[0] = mn[1] = mn[2] = mn[3] = 255;
+	mx[0] = mx[1] = mx[2] = mx[3] = 0;
+	if (image->bpp != 4)
+		mn[3] = mx[3] = 255;
+	stats->bounds[0] = image->width;
+	stats->bounds[1] = image->height;
+	stats->bounds[2] = -1;
+	stats->bounds[3] = -1;
+	num_grad = 0;
+	need_grad = (size_t)(image->width*image->height*(100.0f - tex_binaryAlphaThreshold)/100.0f);
+	samples = sum[0] = sum[1] = sum[2] = 0;
+	gray = true;
+	lastcolor = 0;
+	data = fiGetData(image->bitmap, &pitch);
+	for (y = 0; y < image->height; y++)
+	{
+		in = data + y*pitch;
+		for (x = 0; x < image->width; x++, in += image->bpp)
+		{
+			// min/max
+			for (c = 0; c < image->bpp; c++)
+			{
+				mn[c] = min(mn[c], in[c]);
+				mx[c] = max(mx[c], in[c]);
+			}
+			if (in[0] != in[1] || in[1] != in[2])
+				gray = false;
+			// average color (only use not-black pixels)
+			if (in[0] != 0 || in[1] != 0 || in[2] != 0)
+			{
+				sum[0] += in[r];
+				sum[1] += in[1];
+				sum[2] += in[b];
+				samples++;
+			}
+			// alpha
+			color = in[r] | (in[1] << 8) | (in[b] << 16) | 0xFF000000;
+			if (image->bpp == 4)
+			{
+				color = (color & 0x00FFFFFF) | (in[3] << 24);
+				if (in[3] >= tex_binaryAlphaMin && in[3] <= tex_binaryAlphaMax)
+					num_grad++;
+				if (in[3] > tex_binaryAlphaMin)
+				{
+					stats->bounds[0] = min(stats->bounds[0], x);
+					stats->bounds[1] = min(stats->bounds[1], y);
+					stats->bounds[2] = max(stats->bounds[2], x);
+					stats->bounds[3] = max(stats->bounds[3], y);
+				}
+			}
+			// unique colors
+			if (stats->numColors <= IMAGE_STATS_MAX_COLORS && (color != lastcolor || !stats->numColors))
+			{
+				for (c = 0; c < stats->numColors; c++)
+					if (colors[c] == color)
+						break;
+				if (c == stats->numColors)
+				{
+					if (stats->numColors < IMAGE_STATS_MAX_COLORS)
+						colors[c] = color;
+					stats->numColors++;
+				}
+				lastcolor = color;
+			}
+		}
+	}
+	if (image->bpp != 4)
+	{
+		stats->bounds[0] = stats->bounds[1] = 0;
+		stats->bounds[2] = image->width - 1;
+		stats->bounds[3] = image->height - 1;
+	}
+
+	// store
+	stats->valid = true;
+	stats->min[0] = mn[r]; stats->min[1] = mn[1]; stats->min[2] = mn[b]; stats->min[3] = mn[3];
+	stats->max[0] = mx[r]; stats->max[1] = mx[1]; stats->max[2] = mx[b]; stats->max[3] = mx[3];
+	stats->grayscale = gray;
+	stats->alphaClass = IMAGE_ALPHA_OPAQUE;
+	if (mn[3] < 255)
+		stats->alphaClass = (num_grad > need_grad) ? IMAGE_ALPHA_FULL : IMAGE_ALPHA_BINARY;
+	for (c = 0; c < 3; c++)
+		stats->averageColor[c] = samples ? (byte)(min(1.0, max(0.0, (double)sum[c] / 255.0 / samples)) * 255.0f) : 0;
+}
+
 void Image_FreeMaps(LoadedImage *image)
 {
 	if (image->maps)
@@ -443,7 +785,23 @@ void Image_Scale2x_Super2x(LoadedImage *image, bool makePowerOfTwo)
 	image->scaled = true;
 }
 
+// row bands for scale2x
+typedef struct
+{
+	byte *dst;
+	byte *src;
+	int   width;
+	int   height;
+}Scale2xRows;
+
+void Image_Scale2xRows(void *data, int yFirst, int yLast)
+{
+	Scale2xRows *rows = (Scale2xRows *)data;
+	sxScaleRows(2, rows->dst, rows->width*2*4, rows->src, rows->width*4, 4, rows->width, rows->height, yFirst, yLast);
+}
+
 // scale for 2x
+// 4x scale is done as two 2x passes (same as scale4x does), so both can be split to row bands
 void Image_Scale2x(LoadedImage *image, int factor)
 {
 	if (!image->bitmap)
@@ -460,13 +818,30 @@ void Image_Scale2x(LoadedImage *image, int factor)
 
 	// scale
 	// vortex: since BPP is 4, data is always properly aligned, so we dont need pitch
-	int w = image->width;
-	int h = image->height;
-	FIBITMAP *scaled = fiCreate(w*factor, h*factor, 4, "Image_Scale2x");
-	byte *data_scaled = fiGetData(scaled, NULL);
-	byte *data_bitmap = fiGetData(image->bitmap, NULL);
-	sxScale(factor, data_scaled, w*factor*4, data_bitmap, w*4, 4, w, h);
-	fiBindToImage(scaled, image);
+	Scale2xRows rows;
+	if (factor == 2 || factor == 4)
+	{
+		for (int pass = 0; pass < factor / 2; pass++)
+		{
+			rows.width = image->width;
+			rows.height = image->height;
+			FIBITMAP *scaled = fiCreate(rows.width*2, rows.height*2, 4, "Image_Scale2x");
+			rows.dst = fiGetData(scaled, NULL);
+			rows.src = fiGetData(image->bitmap, NULL);
+			ParallelRows(rows.height, (size_t)rows.width * rows.height, &rows, Image_Scale2xRows);
+			fiBindToImage(scaled, image);
+		}
+	}
+	else
+	{
+		int w = image->width;
+		int h = image->height;
+		FIBITMAP *scaled = fiCreate(w*factor, h*factor, 4, "Image_Scale2x");
+		byte *data_scaled = fiGetData(scaled, NULL);
+		byte *data_bitmap = fiGetData(image->bitmap, NULL);
+		sxScale(factor, data_scaled, w*factor*4, data_bitmap, w*4, 4, w, h);
+		fiBindToImage(scaled, image);
+	}
 
 	// finish
 	if (!image->hasAlpha)
@@ -474,6 +849,37 @@ void Image_Scale2x(LoadedImage *image, int factor)
 	image->scaled = true;
 }
 
+// row bands for xBR scaler
+typedef struct
+{
+	int               factor;
+	uint32_t         *src;
+	uint32_t         *dst;
+	int               width;
+	int               height;
+	xbrz::ScalerCfg  *cfg;
+}ScalexBRRows;
+
+void Image_ScalexBRRows(void *data, int yFirst, int yLast)
+{
+	ScalexBRRows *rows = (ScalexBRRows *)data;
+	xbrz::scale(rows->factor, rows->src, rows->dst, rows->width, rows->height, *rows->cfg, yFirst, yLast);
+}
+
+void Image_ScalexBRParallel(int factor, uint32_t *src, uint32_t *dst, int width, int height, xbrz::ScalerCfg *cfg)
+{
+	ScalexBRRows rows;
+
+	rows.factor = factor;
+	rows.src = src;
+	rows.dst = dst;
+	rows.width = width;
+	rows.height = height;
+	rows.cfg = cfg;
+	// xBR is much heavier than scale2x, so treat it as a bigger image
+	ParallelRows(height, (size_t)width * height * factor * factor, &rows, Image_ScalexBRRows);
+}
+
 // scale using xBR scaler
 void Image_ScalexBR(LoadedImage *image, int factor)
 {
@@ -507,12 +913,12 @@ void Image_ScalexBR(LoadedImage *image, int factor)
 			out += 4;
 		}
 		// alpha scale
-		xbrz::scale(factor, (uint32_t *)alpha, (uint32_t *)fiGetData(scaled, NULL), image->width, image->height, scalerconfig, 0, image->height);
+		Image_ScalexBRParallel(factor, (uint32_t *)alpha, (uint32_t *)fiGetData(scaled, NULL), image->width, image->height, &scalerconfig);
 		mem_free(alpha);
 		// RGB scale
 		Image_SetAlpha(image, 0);
 		FIBITMAP *rgb_scaled = fiCreate(image->width*factor, image->height*factor, 4, "fiCreate");
-		xbrz::scale(factor, (uint32_t *)fiGetData(image->bitmap, NULL), (uint32_t *)fiGetData(rgb_scaled, NULL), image->width, image->height, scalerconfig, 0, image->height);
+		Image_ScalexBRParallel(factor, (uint32_t *)fiGetData(image->bitmap, NULL), (uint32_t *)fiGetData(rgb_scaled, NULL), image->width, image->height, &scalerconfig);
 		// combine and return
 		fiCombine(rgb_scaled, scaled, COMBINE_R_TO_ALPHA, 1, true);
 		fiBindToImage(rgb_scaled, image);
@@ -523,7 +929,7 @@ void Image_ScalexBR(LoadedImage *image, int factor)
 	// RGB scale
 	Image_ConvertBPP(image, 4);
 	Image_SetAlpha(image, 0);
-	xbrz::scale(factor, (uint32_t *)fiGetData(image->bitmap, NULL), (uint32_t *)fiGetData(scaled, NULL), image->width, image->height, scalerconfig, 0, image->height);
+	Image_ScalexBRParallel(factor, (uint32_t *)fiGetData(image->bitmap, NULL), (uint32_t *)fiGetData(scaled, NULL), image->width, image->height, &scalerconfig);
 	fiBindToImage(scaled, image);
 	Image_ConvertBPP(image, 3);
 	image->scaled = true;
@@ -891,7 +1297,7 @@ void Image_Generate(LoadedImage *image, int width, int height, int bpp)
 	image->width = width;
 	image->height = height;
 	image->bpp = bpp;
-	Image_LoadFinish(image);
+	Image_LoadFinish(image, false);
 }
 
 // returns true if image was changed since latest load
@@ -905,7 +1311,8 @@ bool Image_Changed(LoadedImage *image)
 	return false;
 }
 
-void Image_LoadFinish(LoadedImage *image)
+// source images may drop opaque alpha, decoded ones keep what decoder gave
+void Image_LoadFinish(LoadedImage *image, bool source)
 {
 	if (!image->bitmap)
 		return;
@@ -925,36 +1332,18 @@ void Image_LoadFinish(LoadedImage *image)
 	else if (image->bpp != 3 && image->bpp != 4)
 		Image_ConvertBPP(image, 3);
 
-	// check alpha
-	image->hasAlpha = false;
-	image->hasGradientAlpha = false;
-	if (image->bpp == 4)
-	{
-		int num_grad = 0;
-		int need_grad = (int)(image->width*image->height*(100.0f - tex_binaryAlphaThreshold)/100.0f);
-		long pixels = image->width*image->height*image->bpp;
-		// vortex: since BPP is 4, data is always properly aligned, so we dont need pitch
-		byte *data = fiGetData(image->bitmap, NULL);
-		image->hasAlpha = true;
-		if (!tex_detectBinaryAlpha)
-			image->hasGradientAlpha = true;
-		else
-		{
-			for (long i = 0; i < pixels; i+= image->bpp)
-			{
-				if (data[i+3] >= tex_binaryAlphaMin && data[i+3] <= tex_binaryAlphaMax)
-					num_grad++;
-				if (num_grad > need_grad)
-				{
-					image->hasGradientAlpha = true;
-					break;
-				}
-			}
-		}
-	}
+	// check alpha and calc average color
+	Image_CalcStats(image);
 
-	// calc average color
-	Image_CalcAverageColor(image);
+	// alpha channel with all pixels opaque is dropped, so image gets opaque format
+	if (source && image->bpp == 4 && image->stats.alphaClass == IMAGE_ALPHA_OPAQUE && !tex_keepOpaqueAlpha)
+		Image_ConvertBPP(image, 3);
+	image->hasAlpha = (image->bpp == 4);
+	image->hasGradientAlpha = false;
+	if (image->hasAlpha)
+		image->hasGradientAlpha = (!tex_detectBinaryAlpha || image->stats.alphaClass == IMAGE_ALPHA_FULL);
+	image->hasAverageColor = true;
+	memcpy(image->averagecolor, image->stats.averageColor, 3);
 
 	// save the loaded state (for comparison if image was altered)
 	memcpy(&image->loadedState, &image->width, sizeof(ImageState));
@@ -992,7 +1381,7 @@ void LoadImage_QuakeSprite(FS_File *file, byte *filedata, size_t filesize, Loade
 				fiLoadDataRaw(frame->width, frame->height, 1, pic->pixels, frame->width * frame->height, pic->colormap->palette, false, frame);
 			else
 				fiLoadDataRaw(frame->width, frame->height, 4, pic->pixels, frame->width * frame->height * 4, NULL, false, frame);
-			Image_LoadFinish(frame);
+			Image_LoadFinish(frame, true);
 			// go next frame
 			if ((i+1) < sprite->numPics)
 			{
@@ -1036,7 +1425,7 @@ void LoadImage_QuakeBSP(FS_File *file, byte *filedata, size_t filesize, LoadedIm
 				if (texwidth < 0 || texwidth > 32768 || texheight < 0 || texheight > 32768)
 					Error("LoadImage_QuakeBSP(%s) bogus texture size: %ix%i", tex->texname, texwidth, texheight);
 				fiLoadDataRaw(texwidth, texheight, 1, (byte *)(buf + textureoffsets[texnum] + texmipofs), texwidth * texheight, quake_palette, true, tex);
-				Image_LoadFinish(tex);
+				Image_LoadFinish(tex, true);
 				// set next texture
 				tex->next = Image_Create();
 				tex = tex->next;
@@ -1052,7 +1441,63 @@ void LoadImage_Generic(FS_File *file, byte *filedata, size_t filesize, LoadedIma
 	image->filesize = filesize;
 	fiLoadData(FIF_UNKNOWN, file, filedata, filesize, image);
 	mem_free(filedata);
-	Image_LoadFinish(image);
+	Image_LoadFinish(image, true);
+}
+
+// bytes of archive member unpacked to probe it's header
+#define IMAGE_PROBE_HEADER_SIZE (64*1024)
+
+// read image dimensions from file header without decoding pixels
+// special containers are not probed
+bool Image_Probe(FS_File *file)
+{
+	char filepath[MAX_FPATH];
+	FREE_IMAGE_FORMAT fif;
+	FIBITMAP *header;
+
+	if (file->width > 0 && file->height > 0)
+		return true;
+
+	// archive members are probed from first unpacked bytes, headers are expected to fit there
+	if (!file->zipfile.empty())
+	{
+		FIMEMORY *stream;
+		size_t filesize;
+		byte *filedata;
+
+		filedata = FS_LoadFilePart(file, IMAGE_PROBE_HEADER_SIZE, &filesize);
+		if (!filedata)
+			return false;
+		stream = FreeImage_OpenMemory(filedata, (DWORD)filesize);
+		fif = FreeImage_GetFileTypeFromMemory(stream, 0);
+		if (fif == FIF_UNKNOWN)
+			fif = FreeImage_GetFIFFromFilename(file->fullpath.c_str());
+		header = NULL;
+		if (fif != FIF_UNKNOWN && FreeImage_FIFSupportsNoPixels(fif))
+			header = FreeImage_LoadFromMemory(fif, stream, FIF_LOAD_NOPIXELS);
+		if (header)
+		{
+			file->width = FreeImage_GetWidth(header);
+			file->height = FreeImage_GetHeight(header);
+			FreeImage_Unload(header);
+		}
+		FreeImage_CloseMemory(stream);
+		mem_free(filedata);
+		return (file->width > 0 && file->height > 0);
+	}
+	sprintf(filepath, "%s%s%s.%s", tex_srcDir, file->path.c_str(), file->name.c_str(), file->ext.c_str());
+	fif = FreeImage_GetFileType(filepath, 0);
+	if (fif == FIF_UNKNOWN)
+		fif = FreeImage_GetFIFFromFilename(filepath);
+	if (fif == FIF_UNKNOWN || !FreeImage_FIFSupportsNoPixels(fif))
+		return false;
+	header = FreeImage_Load(fif, filepath, FIF_LOAD_NOPIXELS);
+	if (!header)
+		return false;
+	file->width = FreeImage_GetWidth(header);
+	file->height = FreeImage_GetHeight(header);
+	FreeImage_Unload(header);
+	return (file->width > 0 && file->height > 0);
 }
 
 void Image_Load(FS_File *file, LoadedImage *image)
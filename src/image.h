@@ -74,6 +74,42 @@ typedef enum
 	extern OptionList ImageScalers[];
 #endif
 
+// alpha channel contents
+typedef enum
+{
+	IMAGE_ALPHA_OPAQUE, // no alpha or all pixels are opaque
+	IMAGE_ALPHA_BINARY, // most pixels are outside binaryalpha_0..binaryalpha_1
+	IMAGE_ALPHA_FULL
+}ImageAlphaClass;
+#ifdef F_IMAGE_C
+	OptionList ImageAlphaClasses[] =
+	{
+		{ "opaque", IMAGE_ALPHA_OPAQUE },
+		{ "binary", IMAGE_ALPHA_BINARY },
+		{ "full",   IMAGE_ALPHA_FULL },
+		{ 0 },
+	};
+#else
+	extern OptionList ImageAlphaClasses[];
+#endif
+
+// unique colors are counted up to this number
+#define IMAGE_STATS_MAX_COLORS 16
+
+// image statistics gathered in a single pass by Image_LoadFinish
+// describes image as it was loaded, colors are in RGBA order
+typedef struct ImageStats_s
+{
+	bool            valid;
+	byte            min[4];          // per-channel min/max
+	byte            max[4];
+	ImageAlphaClass alphaClass;
+	bool            grayscale;       // R == G == B for all pixels
+	int             numColors;       // unique RGBA colors, IMAGE_STATS_MAX_COLORS + 1 means "more"
+	byte            averageColor[3]; // average of non-black pixels
+	int             bounds[4];       // bounding box of non-transparent pixels (x1, y1, x2, y2), x2 < x1 if there is none
+}ImageStats;
+
 typedef struct ImageState_s
 {
 	int          width;
@@ -125,6 +161,9 @@ typedef struct LoadedImage_s
 	byte         averagecolor[3];
 	bool         hasAverageColor;
 
+	// load-time statistics
+	ImageStats   stats;
+
 	// set by texture tool
 	ImageType    datatype;
 
@@ -135,8 +174,9 @@ LoadedImage;
 
 LoadedImage *Image_Create(void);
 void  Image_Generate(LoadedImage *image, int width, int height, int bpp);
+bool  Image_Probe(FS_File *file);
 void  Image_Load(FS_File *file, LoadedImage *image);
-void  Image_LoadFinish(LoadedImage *image);
+void  Image_LoadFinish(LoadedImage *image, bool source);
 bool  Image_Changed(LoadedImage *image);
 void  Image_GenerateMaps(LoadedImage *image, bool overwrite, bool miplevels, bool binaryalpha, bool srgb);
 void  Image_FreeMaps(LoadedImage *image);
@@ -157,6 +197,12 @@ void  Image_Delete(LoadedImage *image);
 #define srgb_to_linear(c) (((c) <= 0.04045f) ? (c) * (1.0f / 12.92f) : (float)pow(((c) + 0.055f)*(1.0f/1.055f), 2.4f))
 
 // raw data functions
+bool ImageData_SSSE3(void);
+bool ImageData_SetSSSE3(bool enable);
+void ImageData_Shuffle(byte *data, int width, int height, int pitch, const int *order);
+void ImageData_CopyPixels(byte *out, int outbpp, byte *in, int inbpp, int pixels, bool opaque);
+void ImageData_EncodeYCoCg(byte *data, int width, int height, int pitch, bool rgbSwap, bool dropAlpha);
+void ImageData_Premultiply(byte *data, int width, int height, int pitch);
 void ImageData_SwapRB(byte *data, int width, int height, int pitch, int bpp);
 void ImageData_ConvertSRGB(byte *data, int width, int height, int pitch, int bpp, bool srcSRGB, bool dstSRGB);
 bool ImageData_ProbeLinearToSRGB_16bit(byte *data, int width, int height, int pitch, int bpp, bool rgbSwap);
@@ -166,6 +212,7 @@ void  Image_ConvertBPP(LoadedImage *image, int bpp);
 void  Image_ConvertSRGB(LoadedImage *image, bool useSRGB);
 void  Image_SwapColors(LoadedImage *image, bool swappedColor);
 void  Image_CalcAverageColor(LoadedImage *image);
+void  Image_CalcStats(LoadedImage *image);
 byte *Image_GenerateTarga(size_t *outsize, int width, int height, int bpp, byte *data, bool flip, bool rgb, bool grayscale);
 bool  Image_Save(LoadedImage *image, char *filename);
 byte *Image_ExportTarga(LoadedImage *image, size_t *tgasize);
@@ -20,7 +20,7 @@ int Help(void)
 	"       -nc: print no caption\n"
 	"        -w: wait for key when finished\n"
 	"       -nw: do not wait for key\n"
-	"      -mem: show memstats\n"
+	"      -mem: show memstats and allocation sites profile\n"
 	"        -v: show verbose messages\n"
 	"     -spac: solid pacifier prints\n"
 	"        -c: compact mode (only generic prints)\n"
@@ -68,7 +68,7 @@ int main(int argc, char **argv)
 	printcap = CheckParm("-nc") ? false : true;
 	// COMMANDLINEPARM: -w: wait for key when finished
 	waitforkey = (CheckParm("-w") || CheckParm("-"));
-	// COMMANDLINEPARM: -mem: show memstats
+	// COMMANDLINEPARM: -mem: show memstats and allocation sites profile
 	memstats = CheckParm("-mem");
 	// COMMANDLINEPARM: -v: show verbose messages
 	verbose = CheckParm("-v");
@@ -146,7 +146,7 @@ int main(int argc, char **argv)
 	}
 
 	//COMMANDLINEPARM: -version: show modules versions
-	if (tex_active_codecs)
+	if (tex_active_codecs || CheckParm("-verify"))
 	{
 		LoadOptions(optionfile);
 		returncode = TexMain(argc-i, argv+i);
@@ -11,6 +11,7 @@
 #include "dll.h"
 #include "options.h"
 #include "thread.h"
+#include "trace.h"
 #include "image.h"
 #include "tex.h"
 #include "fs.h"
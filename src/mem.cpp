@@ -10,27 +10,108 @@
 #include "mem.h"
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
 using namespace std;
 
+// sentinels are kept in sharded hash maps keyed by pointer
+// so alloc/free is O(1) and threads rarely contend for the same lock
+#define MEM_SHARDS      64
+#define MEM_REPORTSITES 32
+#define MEM_SITECACHE   256 // per-thread cache of call sites, power of two
+
+// allocation call site (file:line of mem_alloc macro)
+typedef struct memsite_s
+{
+	char          *file;
+	int            line;
+	atomic<size_t> allocs;  // number of allocations
+	atomic<size_t> bytes;   // total bytes allocated
+	atomic<size_t> active;  // live bytes
+	atomic<size_t> peak;    // peak live bytes
+}memsite;
+
 typedef struct
 {
-	char  *name;
-	char  *file;
-	int    line;
-	size_t size;
-	void  *ptr;
-	bool   free;
+	char    *name;
+	char    *file;
+	int      line;
+	size_t   size;
+	memsite *site;
 }memsentinel;
 
+typedef struct
+{
+	char *file;
+	int   line;
+}memsitekey;
+
+struct memsitekey_hash
+{
+	size_t operator()(const memsitekey &k) const { return (size_t)k.file ^ ((size_t)k.line * 2654435761u); }
+};
+
+struct memsitekey_equal
+{
+	bool operator()(const memsitekey &a, const memsitekey &b) const { return a.file == b.file && a.line == b.line; }
+};
+
+typedef struct
+{
+	mutex                                lock;
+	unordered_map<void *, memsentinel>   sentinels;
+}memshard;
+
+typedef struct
+{
+	mutex                                                             lock;
+	unordered_map<memsitekey, memsite *, memsitekey_hash, memsitekey_equal> sites;
+}memsiteshard;
+
+// sites are looked up in shared map once per thread, then taken from this cache
+typedef struct
+{
+	char    *file;
+	int      line;
+	memsite *site;
+}memsitecache;
+
+// per-thread counters, merged into global ones when thread exits
+typedef struct memthreadstats_s
+{
+	size_t allocated;
+	size_t allocs;
+	size_t frees;
+	void   Flush(void);
+	~memthreadstats_s() { Flush(); }
+}memthreadstats;
+
 bool                initialized = false;
-size_t              total_allocated;
-size_t              total_active;
-size_t              total_active_peak;
-vector<memsentinel> sentinels;
-HANDLE              sentinelMutex = NULL;
-HANDLE              sentinelMutex2 = NULL;
-
-void Mem_Error(char *message_format, ...) 
+atomic<size_t>      total_allocated;
+atomic<size_t>      total_allocs;
+atomic<size_t>      total_frees;
+atomic<size_t>      total_active;
+atomic<size_t>      total_active_peak;
+memshard            sentinels[MEM_SHARDS];
+memsiteshard        sites[MEM_SHARDS];
+thread_local memthreadstats threadstats = { 0 };
+atomic<size_t>      sites_generation;
+thread_local memsitecache sitecache[MEM_SITECACHE];
+thread_local size_t sitecache_generation = 0;
+
+void memthreadstats_s::Flush(void)
+{
+	total_allocated += allocated;
+	total_allocs += allocs;
+	total_frees += frees;
+	allocated = 0;
+	allocs = 0;
+	frees = 0;
+}
+
+void Mem_Error(char *message_format, ...)
 {
 	char msg[16384];
 	va_list argptr;
@@ -41,6 +122,127 @@ void Mem_Error(char *message_format, ...)
 	Error(msg);
 }
 
+static inline memshard *Mem_ShardForPointer(void *ptr)
+{
+	size_t h = (size_t)ptr >> 4;
+	return &sentinels[(h ^ (h >> 7) ^ (h >> 13)) % MEM_SHARDS];
+}
+
+static inline void Mem_PopPeak(atomic<size_t> *peak, size_t value)
+{
+	size_t cur = peak->load(memory_order_relaxed);
+	while(value > cur && !peak->compare_exchange_weak(cur, value, memory_order_relaxed));
+}
+
+static memsite *Mem_GetSite(char *file, int line)
+{
+	memsitekey key;
+	memsite *site;
+	size_t hash;
+
+	key.file = file;
+	key.line = line;
+	hash = memsitekey_hash()(key);
+
+	// cached sites are dropped after Mem_Shutdown frees them
+	if (sitecache_generation != sites_generation.load(memory_order_relaxed))
+	{
+		memset(sitecache, 0, sizeof(sitecache));
+		sitecache_generation = sites_generation.load(memory_order_relaxed);
+	}
+	memsitecache *cache = &sitecache[hash & (MEM_SITECACHE - 1)];
+	if (cache->file == file && cache->line == line)
+		return cache->site;
+
+	memsiteshard *shard = &sites[hash % MEM_SHARDS];
+	shard->lock.lock();
+	unordered_map<memsitekey, memsite *, memsitekey_hash, memsitekey_equal>::iterator s = shard->sites.find(key);
+	if (s != shard->sites.end())
+		site = s->second;
+	else
+	{
+		site = new memsite();
+		site->file = file;
+		site->line = line;
+		site->allocs = 0;
+		site->bytes = 0;
+		site->active = 0;
+		site->peak = 0;
+		shard->sites[key] = site;
+	}
+	shard->lock.unlock();
+	cache->file = file;
+	cache->line = line;
+	cache->site = site;
+	return site;
+}
+
+static bool Mem_CompareSitePeak(memsite *a, memsite *b)
+{
+	return a->peak.load() > b->peak.load();
+}
+
+// print allocation profile, sites are sorted by peak live bytes
+static void Mem_PrintSites(int maxsites)
+{
+	vector<memsite *> list;
+	int i, n;
+
+	for (i = 0; i < MEM_SHARDS; i++)
+	{
+		sites[i].lock.lock();
+		for (unordered_map<memsitekey, memsite *, memsitekey_hash, memsitekey_equal>::iterator s = sites[i].sites.begin(); s != sites[i].sites.end(); s++)
+			list.push_back(s->second);
+		sites[i].lock.unlock();
+	}
+	sort(list.begin(), list.end(), Mem_CompareSitePeak);
+	n = min((int)list.size(), maxsites);
+	if (!n)
+		return;
+	Print(" Allocation sites (top %i of %i by peak)\n", n, (int)list.size());
+	Print("       peak Mb       live Mb      total Mb     allocs  site\n");
+	for (i = 0; i < n; i++)
+		Print(" %13.3f %13.3f %13.3f %10llu  %s:%i\n", (double)list[i]->peak / 1048576.0, (double)list[i]->active / 1048576.0, (double)list[i]->bytes / 1048576.0, (unsigned long long)list[i]->allocs, list[i]->file, list[i]->line);
+}
+
+// print live sentinels
+static void Mem_PrintSentinels(void)
+{
+	for (int i = 0; i < MEM_SHARDS; i++)
+	{
+		sentinels[i].lock.lock();
+		for (unordered_map<void *, memsentinel>::iterator s = sentinels[i].sentinels.begin(); s != sentinels[i].sentinels.end(); s++)
+			Print("%s:%i (%s) %llu bytes (%.3f Mb)\n", s->second.file, s->second.line, s->second.name, (unsigned long long)s->second.size, (double)s->second.size / 1048576.0);
+		sentinels[i].lock.unlock();
+	}
+}
+
+static size_t Mem_CountSentinels(size_t *bytes)
+{
+	size_t count = 0, size = 0;
+
+	for (int i = 0; i < MEM_SHARDS; i++)
+	{
+		sentinels[i].lock.lock();
+		count += sentinels[i].sentinels.size();
+		for (unordered_map<void *, memsentinel>::iterator s = sentinels[i].sentinels.begin(); s != sentinels[i].sentinels.end(); s++)
+			size += s->second.size;
+		sentinels[i].lock.unlock();
+	}
+	if (bytes)
+		*bytes = size;
+	return count;
+}
+
+// called when allocation fails
+static void Mem_PrintAllocations(void)
+{
+	if (!memstats)
+		return;
+	Print("memory allocations: %llu\n", (unsigned long long)Mem_CountSentinels(NULL));
+	Mem_PrintSites(MEM_REPORTSITES);
+}
+
 void Mem_Init(void)
 {
 	if (initialized)
@@ -48,12 +250,12 @@ void Mem_Init(void)
 
 	initialized = true;
 	total_allocated = 0;
+	total_allocs = 0;
+	total_frees = 0;
 	total_active = 0;
 	total_active_peak = 0;
-
-	sentinels.clear();
-	sentinelMutex = CreateMutex(NULL, FALSE, NULL);
-	sentinelMutex2 = CreateMutex(NULL, FALSE, NULL);
+	for (int i = 0; i < MEM_SHARDS; i++)
+		sentinels[i].sentinels.clear();
 }
 
 void Mem_Shutdown(void)
@@ -62,123 +264,115 @@ void Mem_Shutdown(void)
 		return;
 	if (memstats)
 	{
-		size_t leaks = 0;
 		size_t leaked = 0;
-		for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
-		{
-			if (!s->free)
-			{
-				leaked += s->size;
-				leaks++;
-			}
-		}
+		size_t leaks = Mem_CountSentinels(&leaked);
+
+		// worker threads flushed on exit, main thread is still running
+		threadstats.Flush();
 
 		Print("----------------------------------------\n");
 		Print(" Dynamic memory usage stats\n");
 		Print("----------------------------------------\n");
 		Print("        Peak allocated: %.3f Mb\n", (double)total_active_peak / 1048576.0 );
 		Print("       total allocated: %.3f Mb\n", (double)total_allocated / 1048576.0 );
+		Print("           allocations: %llu (%llu freed)\n", (unsigned long long)total_allocs, (unsigned long long)total_frees );
 		Print("                 leaks: %.3f Mb\n", (double)leaked / 1048576.0 );
 		if (leaks)
 		{
-			Print("            leak spots: %i\n", leaks );
+			Print("            leak spots: %llu\n", (unsigned long long)leaks );
 			Print("\n");
-			for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
-				if (!s->free)
-					Print("%s:%i (%s) %i bytes (%.3f Mb)\n", s->file, s->line, s->name, s->size, (double)s->size / 1048576.0);
+			Mem_PrintSentinels();
 		}
 		Print("\n");
+		Mem_PrintSites(MEM_REPORTSITES);
+		Print("\n");
 	}
 	initialized = false;
-	sentinels.clear();
+	for (int i = 0; i < MEM_SHARDS; i++)
+	{
+		sentinels[i].sentinels.clear();
+		for (unordered_map<memsitekey, memsite *, memsitekey_hash, memsitekey_equal>::iterator s = sites[i].sites.begin(); s != sites[i].sites.end(); s++)
+			delete s->second;
+		sites[i].sites.clear();
+	}
+	sites_generation++;
 }
 
 void _mem_sentinel(char *name, void *ptr, size_t size, char *file, int line)
 {
+	memsentinel s;
+
 	if (!memstats)
 		return;
 
-	WaitForSingleObject(sentinelMutex, INFINITE);
-
 	// create sentinel
-	// pick free one or allocate
-	bool picked = false;
-	for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
+	s.name = name;
+	s.file = file;
+	s.line = line;
+	s.size = size;
+	s.site = Mem_GetSite(file, line);
+	memsentinel old;
+	bool reused = false;
+	memshard *shard = Mem_ShardForPointer(ptr);
+	shard->lock.lock();
+	unordered_map<void *, memsentinel>::iterator i = shard->sentinels.find(ptr);
+	if (i != shard->sentinels.end())
 	{
-		if (s->free)
-		{
-			s->name = name;
-			s->file = file;
-			s->line = line;
-			s->size = size;
-			s->ptr = ptr;
-			s->free = false;
-			picked = true;
-			break;
-		}
+		old = i->second;
+		reused = true;
 	}
-	if (!picked)
+	shard->sentinels[ptr] = s;
+	shard->lock.unlock();
+
+	// address was released without sentinel free (CRT free), drop stale one
+	if (reused)
 	{
-		memsentinel s;
-		s.name = name;
-		s.file = file;
-		s.line = line;
-		s.size = size;
-		s.ptr  = ptr;
-		s.free = false;
-		sentinels.push_back(s);
+		Warning("%s:%i (%s) - page %p was allocated at %s:%i (%s) and not released with mem_free", file, line, name, ptr, old.file, old.line, old.name);
+		old.site->active.fetch_sub(old.size, memory_order_relaxed);
+		total_active.fetch_sub(old.size, memory_order_relaxed);
 	}
 
-	// pop global stats
-	total_allocated += size;
-	total_active += size;
-	if (total_active > total_active_peak)
-		total_active_peak = total_active;
+	// pop site stats
+	s.site->allocs.fetch_add(1, memory_order_relaxed);
+	s.site->bytes.fetch_add(size, memory_order_relaxed);
+	Mem_PopPeak(&s.site->peak, s.site->active.fetch_add(size, memory_order_relaxed) + size);
 
-	ReleaseMutex(sentinelMutex);
+	// pop global stats
+	threadstats.allocated += size;
+	threadstats.allocs++;
+	Mem_PopPeak(&total_active_peak, total_active.fetch_add(size, memory_order_relaxed) + size);
 }
 
 bool _mem_sentinel_free(char *name, void *ptr, char *file, int line)
 {
+	memsentinel s;
+	bool found = false;
+
 	if (!memstats)
 		return true;
 
-	WaitForSingleObject(sentinelMutex2, INFINITE);
-	// find sentinel for pointer
-	int found = -1;
-	for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
+	// find sentinel for pointer and throw it
+	memshard *shard = Mem_ShardForPointer(ptr);
+	shard->lock.lock();
+	unordered_map<void *, memsentinel>::iterator i = shard->sentinels.find(ptr);
+	if (i != shard->sentinels.end())
 	{
-		if (s->ptr == ptr)
-		{
-			if (!s->free)
-			{
-				// throw sentinel
-				total_active -= s->size;
-				s->size = 0;
-				s->file = 0;
-				s->line = 0;
-				s->name = 0;
-				s->ptr = 0;
-				s->free = true;
-				found = 1;
-			}
-			else
-			{
-				// already freed
-				found = -2;
-			}
-			break;
-		}
+		s = i->second;
+		shard->sentinels.erase(i);
+		found = true;
 	}
-	ReleaseMutex(sentinelMutex2);
+	shard->lock.unlock();
+
 	// oops, this pointer was not allocated
-	if (found == 1)
-		return true;
-	if (found == -1)
-		Mem_Error("%s:%i (%s) - trying to free non-allocated page %i (sentinel not found)\n", file, line, name, ptr);
-	if (found == -2)
-		Mem_Error("%s:%i (%s) - trying to free non-allocated page %i (sentinel already freed)\n", file, line, name, ptr);
-	return false;
+	if (!found)
+	{
+		Mem_Error("%s:%i (%s) - trying to free non-allocated page %p (sentinel not found)\n", file, line, name, ptr);
+		return false;
+	}
+	s.site->active.fetch_sub(s.size, memory_order_relaxed);
+	total_active.fetch_sub(s.size, memory_order_relaxed);
+	threadstats.frees++;
+	return true;
 }
 
 void *_mem_realloc(void *data, size_t size, char *file, int line)
@@ -192,14 +386,8 @@ void *_mem_realloc(void *data, size_t size, char *file, int line)
 	data = realloc(data, size);
 	if (!data)
 	{
-		if (memstats)
-		{
-			Print("memory allocations: %i\n", sentinels.size());
-			for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
-				if (!s->free)
-					Print("%s:%i (%s) %i bytes (%.3f Mb)\n", s->file, s->line, s->name, s->size, (double)s->size / 1048576.0);
-		}
-		Mem_Error("%s:%i - error reallocating %d bytes (%.2f Mb)\n", file, line, size, (double)size / 1048576.0);
+		Mem_PrintAllocations();
+		Mem_Error("%s:%i - error reallocating %llu bytes (%.2f Mb)\n", file, line, (unsigned long long)size, (double)size / 1048576.0);
 	}
 	if (!initialized)
 		return data;
@@ -217,14 +405,8 @@ void *_mem_alloc(size_t size, char *file, int line)
 	data = malloc(size);
 	if (!data)
 	{
-		if (memstats)
-		{
-			Print("memory allocations: %i\n", sentinels.size());
-			for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
-				if (!s->free)
-					Print("%s:%i (%s) %i bytes (%.3f Mb)\n", s->file, s->line, s->name, s->size, (double)s->size / 1048576.0);
-		}
-		Mem_Error("%s:%i - error allocating %d bytes (%.2f Mb)\n", file, line, size, (double)size / 1048576.0);
+		Mem_PrintAllocations();
+		Mem_Error("%s:%i - error allocating %llu bytes (%.2f Mb)\n", file, line, (unsigned long long)size, (double)size / 1048576.0);
 	}
 	if (!initialized)
 		return data;
@@ -242,14 +424,8 @@ void _mem_calloc(void **bufferptr, size_t size, char *file, int line)
 	memset(data, 0, size);
 	if (!data)
 	{
-		if (memstats)
-		{
-			Print("memory allocations: %i\n", sentinels.size());
-			for (std::vector<memsentinel>::iterator s = sentinels.begin(); s < sentinels.end(); s++)
-				if (!s->free)
-					Print("%s:%i (%s) %i bytes (%.3f Mb)\n", s->file, s->line, s->name, s->size, (double)s->size / 1048576.0);
-		}
-		Mem_Error("%s:%i - error allocating %d bytes (%.2f Mb)\n", file, line, size, (double)size / 1048576.0);
+		Mem_PrintAllocations();
+		Mem_Error("%s:%i - error allocating %llu bytes (%.2f Mb)\n", file, line, (unsigned long long)size, (double)size / 1048576.0);
 	}
 	if (!initialized)
 		return;
@@ -2165,6 +2165,239 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 #endif
 }
 
+/*
+===================================================================================================
+ 
+ SSE2
+ 
+===================================================================================================
+*/
+
+/*
+ * SSE2 versions of the 8 and 32 bit Scale2x and 32 bit Scale3x row functions.
+ * Rules are evaluated on 16 (8 bit) or 4 (32 bit) pixels at once using compare masks
+ * and blends instead of branches, border pixels and tails are done by the scalar rules,
+ * so the result is bit-exact with the C implementation.
+ * Selected at runtime by CPUID, C implementation is used as a fallback.
+ */
+
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || defined(__SSE2__)
+#define SCALE2X_SSE2
+#endif
+
+#ifdef SCALE2X_SSE2
+
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+int scale2x_sse2_state = -1;
+
+int scale2x_sse2_check(void)
+{
+	if (scale2x_sse2_state < 0) {
+#if defined(_M_X64) || defined(__x86_64__)
+		scale2x_sse2_state = 1;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		scale2x_sse2_state = (info[3] & (1 << 26)) ? 1 : 0;
+#else
+		unsigned int eax, ebx, ecx, edx;
+		scale2x_sse2_state = (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & (1 << 26))) ? 1 : 0;
+#endif
+	}
+	return scale2x_sse2_state;
+}
+
+/* select mask ? a : b */
+#define SCALE2X_BLEND(mask, a, b) _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+
+/* Scale2x rule on a single pixel, D and F are given to handle the borders */
+#define SCALE2X_PIXEL(dst0, dst1, B, D, E, F, H) \
+	if (B != H && D != F) { \
+		(dst0)[0] = D == B ? B : E; \
+		(dst0)[1] = F == B ? B : E; \
+		(dst1)[0] = D == H ? H : E; \
+		(dst1)[1] = F == H ? H : E; \
+	} else { \
+		(dst0)[0] = E; \
+		(dst0)[1] = E; \
+		(dst1)[0] = E; \
+		(dst1)[1] = E; \
+	}
+
+/* Scale2x rule on a vector of pixels, gives four output vectors */
+#define SCALE2X_VECTOR(cmpeq, B, D, E, F, H, E0, E1, E2, E3) { \
+	__m128i cond = _mm_andnot_si128(_mm_or_si128(cmpeq(B, H), cmpeq(D, F)), _mm_set1_epi32(-1)); \
+	E0 = SCALE2X_BLEND(_mm_and_si128(cond, cmpeq(D, B)), B, E); \
+	E1 = SCALE2X_BLEND(_mm_and_si128(cond, cmpeq(F, B)), B, E); \
+	E2 = SCALE2X_BLEND(_mm_and_si128(cond, cmpeq(D, H)), H, E); \
+	E3 = SCALE2X_BLEND(_mm_and_si128(cond, cmpeq(F, H)), H, E); \
+}
+
+void scale2x_32_sse2(scale2x_uint32* dst0, scale2x_uint32* dst1, const scale2x_uint32* src0, const scale2x_uint32* src1, const scale2x_uint32* src2, unsigned count)
+{
+	__m128i B, D, E, F, H, E0, E1, E2, E3;
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	SCALE2X_PIXEL(dst0, dst1, src0[0], src1[0], src1[0], src1[1], src2[0]);
+
+	/* central pixels, 4 at once */
+	for (i = 1; i + 4 < count; i += 4) {
+		B = _mm_loadu_si128((const __m128i*)(src0 + i));
+		D = _mm_loadu_si128((const __m128i*)(src1 + i - 1));
+		E = _mm_loadu_si128((const __m128i*)(src1 + i));
+		F = _mm_loadu_si128((const __m128i*)(src1 + i + 1));
+		H = _mm_loadu_si128((const __m128i*)(src2 + i));
+		SCALE2X_VECTOR(_mm_cmpeq_epi32, B, D, E, F, H, E0, E1, E2, E3);
+		_mm_storeu_si128((__m128i*)(dst0 + 2 * i), _mm_unpacklo_epi32(E0, E1));
+		_mm_storeu_si128((__m128i*)(dst0 + 2 * i + 4), _mm_unpackhi_epi32(E0, E1));
+		_mm_storeu_si128((__m128i*)(dst1 + 2 * i), _mm_unpacklo_epi32(E2, E3));
+		_mm_storeu_si128((__m128i*)(dst1 + 2 * i + 4), _mm_unpackhi_epi32(E2, E3));
+	}
+
+	/* central pixels tail */
+	for (; i < count - 1; i++) {
+		SCALE2X_PIXEL(dst0 + 2 * i, dst1 + 2 * i, src0[i], src1[i - 1], src1[i], src1[i + 1], src2[i]);
+	}
+
+	/* last pixel */
+	SCALE2X_PIXEL(dst0 + 2 * i, dst1 + 2 * i, src0[i], src1[i - 1], src1[i], src1[i], src2[i]);
+}
+
+void scale2x_8_sse2(scale2x_uint8* dst0, scale2x_uint8* dst1, const scale2x_uint8* src0, const scale2x_uint8* src1, const scale2x_uint8* src2, unsigned count)
+{
+	__m128i B, D, E, F, H, E0, E1, E2, E3;
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	SCALE2X_PIXEL(dst0, dst1, src0[0], src1[0], src1[0], src1[1], src2[0]);
+
+	/* central pixels, 16 at once */
+	for (i = 1; i + 16 < count; i += 16) {
+		B = _mm_loadu_si128((const __m128i*)(src0 + i));
+		D = _mm_loadu_si128((const __m128i*)(src1 + i - 1));
+		E = _mm_loadu_si128((const __m128i*)(src1 + i));
+		F = _mm_loadu_si128((const __m128i*)(src1 + i + 1));
+		H = _mm_loadu_si128((const __m128i*)(src2 + i));
+		SCALE2X_VECTOR(_mm_cmpeq_epi8, B, D, E, F, H, E0, E1, E2, E3);
+		_mm_storeu_si128((__m128i*)(dst0 + 2 * i), _mm_unpacklo_epi8(E0, E1));
+		_mm_storeu_si128((__m128i*)(dst0 + 2 * i + 16), _mm_unpackhi_epi8(E0, E1));
+		_mm_storeu_si128((__m128i*)(dst1 + 2 * i), _mm_unpacklo_epi8(E2, E3));
+		_mm_storeu_si128((__m128i*)(dst1 + 2 * i + 16), _mm_unpackhi_epi8(E2, E3));
+	}
+
+	/* central pixels tail */
+	for (; i < count - 1; i++) {
+		SCALE2X_PIXEL(dst0 + 2 * i, dst1 + 2 * i, src0[i], src1[i - 1], src1[i], src1[i + 1], src2[i]);
+	}
+
+	/* last pixel */
+	SCALE2X_PIXEL(dst0 + 2 * i, dst1 + 2 * i, src0[i], src1[i - 1], src1[i], src1[i], src2[i]);
+}
+
+/* Scale3x rule on a single pixel, A..I are the 3x3 neighbourhood with borders already clamped */
+#define SCALE3X_PIXEL(dst0, dst1, dst2, A, B, C, D, E, F, G, H, I) \
+	if (B != H && D != F) { \
+		(dst0)[0] = D == B ? D : E; \
+		(dst0)[1] = (D == B && E != C) || (F == B && E != A) ? B : E; \
+		(dst0)[2] = F == B ? F : E; \
+		(dst1)[0] = (D == B && E != G) || (D == H && E != A) ? D : E; \
+		(dst1)[1] = E; \
+		(dst1)[2] = (F == B && E != I) || (F == H && E != C) ? F : E; \
+		(dst2)[0] = D == H ? D : E; \
+		(dst2)[1] = (D == H && E != I) || (F == H && E != G) ? H : E; \
+		(dst2)[2] = F == H ? F : E; \
+	} else { \
+		(dst0)[0] = E; \
+		(dst0)[1] = E; \
+		(dst0)[2] = E; \
+		(dst1)[0] = E; \
+		(dst1)[1] = E; \
+		(dst1)[2] = E; \
+		(dst2)[0] = E; \
+		(dst2)[1] = E; \
+		(dst2)[2] = E; \
+	}
+
+/* store three vectors of 4 pixels interleaved (a0 b0 c0 a1 b1 c1 ...) */
+#define SCALE3X_STORE(dst, a, b, c) { \
+	__m128i ab_lo = _mm_unpacklo_epi32(a, b); \
+	__m128i ab_hi = _mm_unpackhi_epi32(a, b); \
+	__m128i ca_lo = _mm_unpacklo_epi32(c, a); \
+	__m128i ca_hi = _mm_unpackhi_epi32(c, a); \
+	__m128i bc_lo = _mm_unpacklo_epi32(b, c); \
+	__m128i bc_hi = _mm_unpackhi_epi32(b, c); \
+	_mm_storeu_ps((float*)(dst), _mm_shuffle_ps(_mm_castsi128_ps(ab_lo), _mm_castsi128_ps(ca_lo), _MM_SHUFFLE(3, 0, 1, 0))); \
+	_mm_storeu_ps((float*)(dst) + 4, _mm_shuffle_ps(_mm_castsi128_ps(bc_lo), _mm_castsi128_ps(ab_hi), _MM_SHUFFLE(1, 0, 3, 2))); \
+	_mm_storeu_ps((float*)(dst) + 8, _mm_shuffle_ps(_mm_castsi128_ps(ca_hi), _mm_castsi128_ps(bc_hi), _MM_SHUFFLE(3, 2, 3, 0))); \
+}
+
+void scale3x_32_sse2(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32* dst2, const scale3x_uint32* src0, const scale3x_uint32* src1, const scale3x_uint32* src2, unsigned count)
+{
+	__m128i A, B, C, D, E, F, G, H, I, cond, eqDB, eqFB, eqDH, eqFH, neA, neC, neG, neI, ones;
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	SCALE3X_PIXEL(dst0, dst1, dst2, src0[0], src0[0], src0[1], src1[0], src1[0], src1[1], src2[0], src2[0], src2[1]);
+
+	/* central pixels, 4 at once */
+	ones = _mm_set1_epi32(-1);
+	for (i = 1; i + 4 < count; i += 4) {
+		A = _mm_loadu_si128((const __m128i*)(src0 + i - 1));
+		B = _mm_loadu_si128((const __m128i*)(src0 + i));
+		C = _mm_loadu_si128((const __m128i*)(src0 + i + 1));
+		D = _mm_loadu_si128((const __m128i*)(src1 + i - 1));
+		E = _mm_loadu_si128((const __m128i*)(src1 + i));
+		F = _mm_loadu_si128((const __m128i*)(src1 + i + 1));
+		G = _mm_loadu_si128((const __m128i*)(src2 + i - 1));
+		H = _mm_loadu_si128((const __m128i*)(src2 + i));
+		I = _mm_loadu_si128((const __m128i*)(src2 + i + 1));
+		cond = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(B, H), _mm_cmpeq_epi32(D, F)), ones);
+		eqDB = _mm_and_si128(cond, _mm_cmpeq_epi32(D, B));
+		eqFB = _mm_and_si128(cond, _mm_cmpeq_epi32(F, B));
+		eqDH = _mm_and_si128(cond, _mm_cmpeq_epi32(D, H));
+		eqFH = _mm_and_si128(cond, _mm_cmpeq_epi32(F, H));
+		neA = _mm_andnot_si128(_mm_cmpeq_epi32(E, A), ones);
+		neC = _mm_andnot_si128(_mm_cmpeq_epi32(E, C), ones);
+		neG = _mm_andnot_si128(_mm_cmpeq_epi32(E, G), ones);
+		neI = _mm_andnot_si128(_mm_cmpeq_epi32(E, I), ones);
+		SCALE3X_STORE(dst0 + 3 * i,
+			SCALE2X_BLEND(eqDB, D, E),
+			SCALE2X_BLEND(_mm_or_si128(_mm_and_si128(eqDB, neC), _mm_and_si128(eqFB, neA)), B, E),
+			SCALE2X_BLEND(eqFB, F, E));
+		SCALE3X_STORE(dst1 + 3 * i,
+			SCALE2X_BLEND(_mm_or_si128(_mm_and_si128(eqDB, neG), _mm_and_si128(eqDH, neA)), D, E),
+			E,
+			SCALE2X_BLEND(_mm_or_si128(_mm_and_si128(eqFB, neI), _mm_and_si128(eqFH, neC)), F, E));
+		SCALE3X_STORE(dst2 + 3 * i,
+			SCALE2X_BLEND(eqDH, D, E),
+			SCALE2X_BLEND(_mm_or_si128(_mm_and_si128(eqDH, neI), _mm_and_si128(eqFH, neG)), H, E),
+			SCALE2X_BLEND(eqFH, F, E));
+	}
+
+	/* central pixels tail */
+	for (; i < count - 1; i++) {
+		SCALE3X_PIXEL(dst0 + 3 * i, dst1 + 3 * i, dst2 + 3 * i, src0[i - 1], src0[i], src0[i + 1], src1[i - 1], src1[i], src1[i + 1], src2[i - 1], src2[i], src2[i + 1]);
+	}
+
+	/* last pixel */
+	SCALE3X_PIXEL(dst0 + 3 * i, dst1 + 3 * i, dst2 + 3 * i, src0[i - 1], src0[i], src0[i], src1[i - 1], src1[i], src1[i], src2[i - 1], src2[i], src2[i]);
+}
+
+#endif
+
 /*
 ===================================================================================================
  
@@ -2197,6 +2430,14 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
  */
 static inline void stage_scale2x(void* dst0, void* dst1, const void* src0, const void* src1, const void* src2, unsigned pixel, unsigned pixel_per_row)
 {
+#ifdef SCALE2X_SSE2
+	if (scale2x_sse2_check()) {
+		switch (pixel) {
+			case 1 : scale2x_8_sse2(SSDST(8,0), SSDST(8,1), SSSRC(8,0), SSSRC(8,1), SSSRC(8,2), pixel_per_row); return;
+			case 4 : scale2x_32_sse2(SSDST(32,0), SSDST(32,1), SSSRC(32,0), SSSRC(32,1), SSSRC(32,2), pixel_per_row); return;
+		}
+	}
+#endif
 	switch (pixel) {
 #if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
 		case 1 : scale2x_8_mmx(SSDST(8,0), SSDST(8,1), SSSRC(8,0), SSSRC(8,1), SSSRC(8,2), pixel_per_row); break;
@@ -2251,6 +2492,12 @@ static inline void stage_scale2x4(void* dst0, void* dst1, void* dst2, void* dst3
  */
 static inline void stage_scale3x(void* dst0, void* dst1, void* dst2, const void* src0, const void* src1, const void* src2, unsigned pixel, unsigned pixel_per_row)
 {
+#ifdef SCALE2X_SSE2
+	if (pixel == 4 && scale2x_sse2_check()) {
+		scale3x_32_sse2(SSDST(32,0), SSDST(32,1), SSDST(32,2), SSSRC(32,0), SSSRC(32,1), SSSRC(32,2), pixel_per_row);
+		return;
+	}
+#endif
 	switch (pixel) {
 		case 1 : scale3x_8_def(SSDST(8,0), SSDST(8,1), SSDST(8,2), SSSRC(8,0), SSSRC(8,1), SSSRC(8,2), pixel_per_row); break;
 		case 2 : scale3x_16_def(SSDST(16,0), SSDST(16,1), SSDST(16,2), SSSRC(16,0), SSSRC(16,1), SSSRC(16,2), pixel_per_row); break;
@@ -2660,4 +2907,68 @@ void sxScale(unsigned int scale, void* void_dst, unsigned int dst_slice, const v
 			scale4x(void_dst, dst_slice, void_src, src_slice, bpp, width, height);
 			break;
 	}
-}
\ No newline at end of file
+}
+
+/**
+ * Enable or disable the SIMD row functions.
+ * The C implementation is used when disabled, this is how the benchmark compares them.
+ * \param enable Non zero to use SIMD row functions when the CPU supports them.
+ * \return Non zero if SIMD row functions are used after the call.
+*/
+int sxSetSIMD(int enable)
+{
+#ifdef SCALE2X_SSE2
+	scale2x_sse2_state = -1;
+	if (!enable)
+		scale2x_sse2_state = 0;
+	return scale2x_sse2_check();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Apply the Scale effect on a band of source rows.
+ * Neighbour rows are taken from the whole bitmap, so bands can be processed
+ * in parallel and give the same result as ::sxScale().
+ * Scale4x should be done as two passes of Scale2x.
+ * \param scale Scale factor. 2, 203 (fox 2x3), 204 (for 2x4) or 3.
+ * \param yFirst First source row of the band.
+ * \param yLast Source row after the last row of the band.
+*/
+void sxScaleRows(unsigned int scale, void* void_dst, unsigned int dst_slice, const void* void_src, unsigned int src_slice, unsigned char bpp, unsigned int width, unsigned int height, unsigned int yFirst, unsigned int yLast)
+{
+	const unsigned char* src = (const unsigned char*)void_src;
+	unsigned char* dst;
+	const unsigned char *src0, *src1, *src2;
+	unsigned int y;
+
+	for (y = yFirst; y < yLast && y < height; y++)
+	{
+		src0 = src + (y > 0 ? y - 1 : 0) * src_slice;
+		src1 = src + y * src_slice;
+		src2 = src + (y + 1 < height ? y + 1 : height - 1) * src_slice;
+		dst = (unsigned char*)void_dst + y * (scale > 100 ? scale % 100 : scale) * dst_slice;
+		switch (scale)
+		{
+			case 202:
+			case   2:
+				stage_scale2x(dst, dst + dst_slice, src0, src1, src2, bpp, width);
+				break;
+			case 203:
+				stage_scale2x3(dst, dst + dst_slice, dst + 2 * dst_slice, src0, src1, src2, bpp, width);
+				break;
+			case 204:
+				stage_scale2x4(dst, dst + dst_slice, dst + 2 * dst_slice, dst + 3 * dst_slice, src0, src1, src2, bpp, width);
+				break;
+			case 303:
+			case   3:
+				stage_scale3x(dst, dst + dst_slice, dst + 2 * dst_slice, src0, src1, src2, bpp, width);
+				break;
+		}
+	}
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	scale2x_mmx_emms();
+#endif
+}
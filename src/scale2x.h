@@ -54,4 +54,16 @@ extern int sxCheck(unsigned int scale, unsigned char bpp, unsigned int width, un
 */
 extern void sxScale(unsigned int scale, void* void_dst, unsigned int dst_slice, const void* void_src, unsigned int src_slice, unsigned char bpp, unsigned int width, unsigned int height);
 
+/**
+ * Apply the Scale effect on a band of source rows [yFirst, yLast).
+ * Bands can be processed in parallel, result matches ::sxScale().
+ * Scale 4 is not supported (apply scale 2 twice).
+*/
+extern void sxScaleRows(unsigned int scale, void* void_dst, unsigned int dst_slice, const void* void_src, unsigned int src_slice, unsigned char bpp, unsigned int width, unsigned int height, unsigned int yFirst, unsigned int yLast);
+
+/**
+ * Enable or disable the SIMD row functions, returns non zero if they are used after the call.
+*/
+extern int sxSetSIMD(int enable);
+
 #endif
\ No newline at end of file
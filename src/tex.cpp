@@ -46,14 +46,19 @@ CompareList   tex_glowMapFiles;
 CompareList   tex_sRGBcolorspace;
 bool          tex_forceBestPSNR;
 bool          tex_detectBinaryAlpha;
+bool          tex_keepOpaqueAlpha;
+bool          tex_noFastPath;
 byte          tex_binaryAlphaMin;
 byte          tex_binaryAlphaMax;
 byte          tex_binaryAlphaCenter;
 float         tex_binaryAlphaThreshold;
+int           tex_alphaBleedDistance;
 CompareList   tex_archiveFiles;
 string        tex_addPath;
 int           tex_zipInMemory;
 int           tex_zipCompression;
+int           tex_zstdLevel;
+int           tex_zstdThreads;
 CompareList   tex_zipAddFiles;
 CompareList   tex_scale2xFiles;
 CompareList   tex_scale4xFiles;
@@ -65,6 +70,30 @@ bool          tex_testCompresion_keepSize = false;
 bool          tex_testCompresionError = false;
 bool          tex_testCompresionAllErrors = false;
 char          tex_statsFile[MAX_FPATH];
+char          tex_traceFile[MAX_FPATH];
+int           tex_memBudget;
+double        tex_deadline;
+double        tex_targetPSNR;
+double        tex_targetRMS;
+texescalate   tex_targetEscalate;
+vector<TexTargetRule*> tex_targetRules;
+bool          tex_autoFormat;
+bool          tex_prescreen;
+double        tex_prescreenMargin;
+bool          tex_tournament;
+double        tex_tournamentEpsilon;
+char          tex_tournamentFile[MAX_FPATH];
+char          tex_scheduleFile[MAX_FPATH];
+bool          tex_scheduleOrder;
+bool          tex_bench;
+char          tex_benchFilter[256];
+char          tex_benchOutput[MAX_FPATH];
+int           tex_benchWarmup;
+int           tex_benchReps;
+bool          tex_verify;
+char          tex_verifySource[MAX_FPATH];
+char          tex_verifyReport[MAX_FPATH];
+bool          tex_verifyTGA;
 
 TexErrorMetric tex_errorMetric = ERRORMETRIC_PERCEPTURAL;
 TexContainer *tex_container = NULL;
@@ -361,22 +390,37 @@ void RegisterFormat(TexFormat *format, TexTool *tool)
 	_RegisterFormat(format, tool, NULL);
 }
 
+// size of single compressed mip level as written by tools
+size_t compressedLevelSize(TexFormat *format, int width, int height)
+{
+	TexBlock *b = format->block;
+	size_t x, y;
+
+	// PVRTexTool pads levels to minimal PVRTC texture size
+	if (b == &B_PVRTC_2BPP_RGB || b == &B_PVRTC_2BPP_RGBA)
+		return max(width, 16) * max(height, 8) / 4;
+	if (b == &B_PVRTC_4BPP_RGB || b == &B_PVRTC_4BPP_RGBA)
+		return max(width, 8) * max(height, 8) / 2;
+	if (b == &B_PVRTC2_2BPP)
+		return max(width, 8) * max(height, 4) / 4;
+	if (b == &B_PVRTC2_4BPP)
+		return max(width, 4) * max(height, 4) / 2;
+	x = (width + b->width - 1) / b->width;
+	y = (height + b->height - 1) / b->height;
+	return max(b->blocksize, x*y*b->bitlength/8);
+}
+
 size_t compressedTextureSize(LoadedImage *image, TexFormat *format, TexContainer *container, bool baseTex, bool mipLevels)
 {
 	size_t size = 0, s;
-	TexBlock *b;
-	int x, y;
 
-	b = format->block;
 	// base layer
 	if (baseTex)
 	{
 		size += container->mipHeaderSize;
-		x = (int)ceil((float)image->width / (float)b->width);
-		y = (int)ceil((float)image->height / (float)b->height);
-		s = max(b->blocksize, x*y*b->bitlength/8);
+		s = compressedLevelSize(format, image->width, image->height);
 		if (container->mipDataPadding)
-			size += s + ((s/container->mipDataPadding)*container->mipDataPadding - s);
+			size += (s + container->mipDataPadding - 1) / container->mipDataPadding * container->mipDataPadding;
 		else
 			size += s;
 	}
@@ -386,11 +430,9 @@ size_t compressedTextureSize(LoadedImage *image, TexFormat *format, TexContainer
 		for (ImageMap *map = image->maps->next; map; map = map->next)
 		{
 			size += container->mipHeaderSize;
-			x = (int)ceil((float)map->width / (float)b->width);
-			y = (int)ceil((float)map->height / (float)b->height);
-			s = max(b->blocksize, x*y*b->bitlength/8);
+			s = compressedLevelSize(format, map->width, map->height);
 			if (container->mipDataPadding)
-				size += s + ((s/container->mipDataPadding)*container->mipDataPadding - s);
+				size += (s + container->mipDataPadding - 1) / container->mipDataPadding * container->mipDataPadding;
 			else
 				size += s;
 		}
@@ -626,6 +668,10 @@ void CommandLineOptions(void)
 	if (CheckParm("-npot"))       tex_allowNPOT = true;
 	// COMMANDLINEPARM: -nomip: do not generate maps
 	if (CheckParm("-nomip"))      tex_noMipmaps = true;
+	// COMMANDLINEPARM: -keepalpha: keep alpha channel of images where all pixels are opaque
+	if (CheckParm("-keepalpha"))  tex_keepOpaqueAlpha = true;
+	// COMMANDLINEPARM: -nofastpath: always run compression tool, even for solid color and tiny textures
+	if (CheckParm("-nofastpath")) tex_noFastPath = true;
 	// COMMANDLINEPARM: -noavgcolor: do not generate average color informatiom
 	if (CheckParm("-noavgcolor")) tex_noAvgColor = true;
 	// COMMANDLINEPARM: -nosrgb: disable sRGB texture support (all sRGB images will be converted to linear space)
@@ -690,6 +736,14 @@ void CommandLineOptions(void)
 	if (CheckParm("-tk"))     { tex_testCompresion = true; tex_testCompresion_keepSize = true; if (!tex_useSuffix) tex_useSuffix = TEXSUFF_TOOL | TEXSUFF_FORMAT; }
 	if (CheckParm("-tek"))    { tex_testCompresion = true; tex_testCompresion_keepSize = true; if (!tex_useSuffix) tex_useSuffix = TEXSUFF_TOOL | TEXSUFF_FORMAT; tex_testCompresionError = true; }
 	if (CheckParm("-tak"))    { tex_testCompresion = true; tex_testCompresion_keepSize = true; if (!tex_useSuffix) tex_useSuffix = TEXSUFF_TOOL | TEXSUFF_FORMAT; tex_testCompresionError = true;  tex_testCompresionAllErrors = true; }
+	// COMMANDLINEPARM: -noschedule: process files in order they was found instead of largest first
+	if (CheckParm("-noschedule")) tex_scheduleOrder = false;
+	// COMMANDLINEPARM: -autoformat: pick smallest format meeting quality target by trial encoding of sampled blocks
+	if (CheckParm("-autoformat")) tex_autoFormat = true;
+	// COMMANDLINEPARM: -noprescreen: always check error control rules on full image
+	if (CheckParm("-noprescreen")) tex_prescreen = false;
+	// COMMANDLINEPARM: -tournament: pick fastest tool per texture among ones giving best quality on sampled blocks
+	if (CheckParm("-tournament")) tex_tournament = true;
 	// string parameters
 	for (int i = 1; i < myargc; i++) 
 	{
@@ -724,6 +778,22 @@ void CommandLineOptions(void)
 				tex_zipCompression = 9;
 			continue;
 		}
+		// COMMANDLINEPARM: -zstd: KTX2 zstd supercompression level (0 disables supercompression)
+		if (!stricmp(myargv[i], "-zstd"))
+		{
+			i++;
+			if (i < myargc)
+				tex_zstdLevel = max(0, min(atoi(myargv[i]), 22));
+			continue;
+		}
+		// COMMANDLINEPARM: -zstdthreads: number of zstd worker threads per texture (0 compresses in calling thread)
+		if (!stricmp(myargv[i], "-zstdthreads"))
+		{
+			i++;
+			if (i < myargc)
+				tex_zstdThreads = max(0, atoi(myargv[i]));
+			continue;
+		}
 		// COMMANDLINEPARM: -zipadd path internal_path: add external file to ZIP archive
 		if (!stricmp(myargv[i], "-zipadd"))
 		{
@@ -762,7 +832,7 @@ void CommandLineOptions(void)
 				tex_errorMetric = (TexErrorMetric)OptionEnum(myargv[i], tex_error_metrics, ERRORMETRIC_PERCEPTURAL);
 			continue;
 		}
-		// COMMANDLINEPARM: -stats: write statistics to CSV file
+		// COMMANDLINEPARM: -stats: write statistics to CSV or JSON file (by extension)
 		if (!stricmp(myargv[i], "-stats"))
 		{
 			i++;
@@ -770,6 +840,160 @@ void CommandLineOptions(void)
 				strlcpy(tex_statsFile, myargv[i], sizeof(tex_statsFile));
 			continue;
 		}
+		// COMMANDLINEPARM: -bench: benchmark tools on input files instead of compressing (optional tool:format filter)
+		if (!stricmp(myargv[i], "-bench"))
+		{
+			tex_bench = true;
+			if (i + 1 < myargc && myargv[i + 1][0] != '-')
+			{
+				i++;
+				strlcpy(tex_benchFilter, myargv[i], sizeof(tex_benchFilter));
+			}
+			continue;
+		}
+		// COMMANDLINEPARM: -benchjson: write benchmark results to JSON file
+		if (!stricmp(myargv[i], "-benchjson"))
+		{
+			i++;
+			if (i < myargc)
+				strlcpy(tex_benchOutput, myargv[i], sizeof(tex_benchOutput));
+			continue;
+		}
+		// COMMANDLINEPARM: -benchreps: benchmark repetitions
+		if (!stricmp(myargv[i], "-benchreps"))
+		{
+			i++;
+			if (i < myargc)
+				tex_benchReps = max(1, atoi(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -benchwarmup: benchmark warm-up runs (not measured)
+		if (!stricmp(myargv[i], "-benchwarmup"))
+		{
+			i++;
+			if (i < myargc)
+				tex_benchWarmup = max(0, atoi(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -verify: decode compressed files in parallel and write a verification report
+		if (!stricmp(myargv[i], "-verify"))
+		{
+			tex_verify = true;
+			continue;
+		}
+		// COMMANDLINEPARM: -verifysrc: pair compressed files with source images from this directory
+		if (!stricmp(myargv[i], "-verifysrc"))
+		{
+			i++;
+			if (i < myargc)
+			{
+				strlcpy(tex_verifySource, myargv[i], sizeof(tex_verifySource));
+				AddSlash(tex_verifySource);
+			}
+			continue;
+		}
+		// COMMANDLINEPARM: -verifyreport: write verification report to CSV or JSON file (by extension)
+		if (!stricmp(myargv[i], "-verifyreport"))
+		{
+			i++;
+			if (i < myargc)
+				strlcpy(tex_verifyReport, myargv[i], sizeof(tex_verifyReport));
+			continue;
+		}
+		// COMMANDLINEPARM: -verifytga: export decoded mip levels of verified files as TGA
+		if (!stricmp(myargv[i], "-verifytga"))
+		{
+			tex_verifyTGA = true;
+			continue;
+		}
+		// COMMANDLINEPARM: -trace: write Chrome/Perfetto timing trace and print per-stage timings
+		if (!stricmp(myargv[i], "-trace"))
+		{
+			i++;
+			if (i < myargc)
+				strlcpy(tex_traceFile, myargv[i], sizeof(tex_traceFile));
+			continue;
+		}
+		// COMMANDLINEPARM: -membudget: limit estimated memory of textures processed at once (megabytes)
+		if (!stricmp(myargv[i], "-membudget"))
+		{
+			i++;
+			if (i < myargc)
+				tex_memBudget = max(0, atoi(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -deadline: time budget (seconds or m:ss), remaining files are switched to faster profiles to meet it
+		if (!stricmp(myargv[i], "-deadline"))
+		{
+			i++;
+			if (i < myargc)
+				tex_deadline = TexSchedule_ParseTime(myargv[i]);
+			continue;
+		}
+		// COMMANDLINEPARM: -targetpsnr: per-texture quality target, profile is escalated from fastest one until it is met
+		if (!stricmp(myargv[i], "-targetpsnr"))
+		{
+			i++;
+			if (i < myargc)
+				tex_targetPSNR = max(0.0, atof(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -targetrms: per-texture quality target (max rms error)
+		if (!stricmp(myargv[i], "-targetrms"))
+		{
+			i++;
+			if (i < myargc)
+				tex_targetRMS = max(0.0, atof(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -targetescalate: what is changed when quality target is missed (profile, tool, format)
+		if (!stricmp(myargv[i], "-targetescalate"))
+		{
+			i++;
+			if (i < myargc)
+				tex_targetEscalate = (texescalate)OptionEnum(myargv[i], tex_escalations, ESCALATE_PROFILE);
+			continue;
+		}
+		// COMMANDLINEPARM: -prescreenmargin: relative error margin for error control decisions made on sampled blocks
+		if (!stricmp(myargv[i], "-prescreenmargin"))
+		{
+			i++;
+			if (i < myargc)
+				tex_prescreenMargin = max(0.0, atof(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -tournamenteps: psnr (dB) tool may lose to best one and still be picked for speed
+		if (!stricmp(myargv[i], "-tournamenteps"))
+		{
+			i++;
+			if (i < myargc)
+				tex_tournamentEpsilon = max(0.0, atof(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -toolsfile: file to keep tool tournament results in
+		if (!stricmp(myargv[i], "-toolsfile"))
+		{
+			i++;
+			if (i < myargc)
+				strlcpy(tex_tournamentFile, myargv[i], sizeof(tex_tournamentFile));
+			continue;
+		}
+		// COMMANDLINEPARM: -alphableed: max distance (pixels) transparent pixels gets color from when scaling (0 is unlimited)
+		if (!stricmp(myargv[i], "-alphableed"))
+		{
+			i++;
+			if (i < myargc)
+				tex_alphaBleedDistance = max(0, atoi(myargv[i]));
+			continue;
+		}
+		// COMMANDLINEPARM: -costs: file to keep learned processing speeds in
+		if (!stricmp(myargv[i], "-costs"))
+		{
+			i++;
+			if (i < myargc)
+				strlcpy(tex_scheduleFile, myargv[i], sizeof(tex_scheduleFile));
+			continue;
+		}
 	}
 	// auto-enable codecs 
 	for (TexCodec *c = tex_active_codecs; c; c = c->next)
@@ -825,6 +1049,9 @@ void Tex_Init(void)
 	RegisterCodec(&CODEC_BGRA);
 	RegisterContainer(&CONTAINER_DDS);
 	RegisterContainer(&CONTAINER_KTX);
+	RegisterContainer(&CONTAINER_KTX2);
+	RegisterContainer(&CONTAINER_CRN);
+	KTX2_LoadZstd();
 	Tex_LinkTools();
 
 	// determine active codecs
@@ -845,10 +1072,13 @@ void Tex_Init(void)
 
 	// set default options
 	tex_detectBinaryAlpha = false;
+	tex_keepOpaqueAlpha = false;
+	tex_noFastPath = false;
 	tex_binaryAlphaMin = 0;
 	tex_binaryAlphaMax = 255;
 	tex_binaryAlphaCenter = 180;
 	tex_binaryAlphaThreshold = 99.0f;
+	tex_alphaBleedDistance = 0;
 	tex_includeFiles.items.clear();
 	tex_noMipFiles.items.clear();
 	tex_sRGBcolorspace.items.clear();
@@ -877,11 +1107,41 @@ void Tex_Init(void)
 	tex_zipInMemory = 0;
 	tex_zipCompression = 8;
 	tex_zipAddFiles.items.clear();
+	tex_zstdLevel = 12;
+	tex_zstdThreads = 0;
 	tex_useSuffix = 0;
 	tex_testCompresion = false;
 	tex_testCompresion_keepSize = false;
 	tex_container = findContainer("DDS", false);
 	strcpy(tex_statsFile, "");
+	strcpy(tex_traceFile, "");
+	tex_memBudget = 0;
+	tex_deadline = 0;
+	tex_targetPSNR = 0;
+	tex_targetRMS = 0;
+	tex_targetEscalate = ESCALATE_PROFILE;
+	for (vector<TexTargetRule*>::iterator i = tex_targetRules.begin(); i < tex_targetRules.end(); i++)
+		delete *i;
+	tex_targetRules.clear();
+	tex_autoFormat = false;
+	tex_prescreen = true;
+	tex_prescreenMargin = 0.25;
+	tex_tournament = false;
+	tex_tournamentEpsilon = 0.5;
+	strcpy(tex_tournamentFile, "");
+	strcpy(tex_scheduleFile, "");
+	tex_scheduleOrder = true;
+	tex_bench = false;
+	strcpy(tex_benchFilter, "");
+	strcpy(tex_benchOutput, "");
+	tex_benchWarmup = 1;
+	tex_benchReps = 3;
+	tex_verify = false;
+	strcpy(tex_verifySource, "");
+	strcpy(tex_verifyReport, "rwgtex_verify.csv");
+	tex_verifyTGA = false;
+	TexCompress_Init();
+	TexFastPath_Init();
 }
 
 void Tex_Shutdown(void)
@@ -890,6 +1150,7 @@ void Tex_Shutdown(void)
 	FreeTools();
 	FreeFormats();
 	FreeContainers();
+	KTX2_UnloadZstd();
 }
 
 /*
@@ -944,12 +1205,39 @@ void Tex_Help(void)
 	"Codec general options:\n"
 	"      -npot: allow non-power-of-two textures\n"
 	"     -nomip: dont generate maps\n"
+	" -keepalpha: dont drop alpha channel which is fully opaque\n"
+	"-nofastpath: dont encode solid color and tiny textures directly\n"
 	"        -2x: apply 2x scale (Scale2X)\n"
 	"        -4x: apply 4x scale (2 pass scale)\n"
 	"  -scaler X: set a filter to be used for scaling\n"
 	" -scaler2 X: set a filter to be used for second scale pass\n"
+	"-alphableed X: max distance of color bleeding into transparent pixels\n"
 	"        -ap: additional archive path\n"
 	"  -zipmem X: speeds up compression by generating ZIP in memory\n"
+	"      -ktx2: write KTX2 files (levels supercompressed with zstd if libzstd is found)\n"
+	"    -zstd X: KTX2 zstd level, 0 disables supercompression (default 12)\n"
+	"-zstdthreads X: zstd worker threads for each texture\n"
+	"       -crn: write Crunch .crn files (DXT1/DXT5, made with crunch)\n"
+	"-crnquality X: crunch quality 0-255, lower gives clustered DXT or smaller .crn\n"
+	"-crnbitrate X: crunch target bits per texel (overrides quality)\n"
+	"-membudget X: limit memory of textures processed at once (MB)\n"
+	"-deadline X: time budget (seconds or m:ss), lowers profile of remaining files\n"
+	"-targetpsnr X: encode with fastest profile first, escalate until psnr is met\n"
+	" -targetrms X: same for rms error\n"
+	" -autoformat: pick smallest format meeting target by sampled blocks\n"
+	" -targetescalate X: profile, tool or format - what is changed to meet target\n"
+	"-noprescreen: check error control rules on full image only\n"
+	"-prescreenmargin X: error margin of sampled error control (0.25)\n"
+	" -tournament: per texture pick fastest tool close to best on sampled blocks\n"
+	" -tournamenteps X: psnr (dB) fastest tool may lose to best one (0.5)\n"
+	" -toolsfile X: keep tournament results in file X (not kept by default)\n"
+	"  -trace X: write timing trace (chrome://tracing or Perfetto)\n"
+	"-bench [tool:format]: benchmark compression tools on input files\n"
+	"   -verify: decode compressed files and write a report (no compression)\n"
+	"-verifysrc X: pair verified files with source images from X and measure error\n"
+	"-verifytga: export decoded files as TGA (use with -verify)\n"
+	"-noschedule: process files in scan order instead of largest first\n"
+	"  -costs X: keep learned processing speeds in file X (not kept by default)\n"
 	"         -t: compress and decompress to a new file to inspect compression\n"
 	"       -stf: add Compressor tool/Format suffix to generated files\n"
 	"        -st: add Compressor tool suffix to generated files\n"
@@ -1135,6 +1423,17 @@ int TexMain(int argc, char **argv)
 		return 0;
 	}
 
+	// verify
+	if (tex_verify)
+		return TexVerify(textures);
+
+	// benchmark
+	if (tex_bench)
+	{
+		TexCompress_Load();
+		return TexBench(textures);
+	}
+
 	// decompress
 	if (tex_srcFile[0] && textures.size() == 1)
 	{
@@ -1147,15 +1446,19 @@ int TexMain(int argc, char **argv)
 	// run conversion
 	Print("%i files to encode\n", textures.size());
 	TexCompress_Load();
+	TexSchedule_Load();
+	TexSample_LoadTools();
+	TexSchedule_Order(textures, numthreads);
 	TexCompressData SharedData;
 	memset(&SharedData, 0, sizeof(TexCompressData));
-	timeelapsed = ParallelThreads(numthreads, textures.size(), &SharedData, TexCompress_WorkerThread, TexCompress_MainThread);
+	timeelapsed = ParallelThreads(numthreads, textures.size(), &SharedData, TexCompress_WorkerThread, TexCompress_MainThread, (size_t)tex_memBudget * 1048576);
 
 	// show stats
 	Print("Conversion finished!\n");
 	Print("--------\n");
 	Print("  files exported: %i\n", SharedData.num_exported_files);
 	Print("    time elapsed: %i:%02.1f\n", (int)(timeelapsed / 60), (double)(timeelapsed - ((int)(timeelapsed / 60)*60)));
+	TexSchedule_Report(timeelapsed);
 	Print("     input files: %.2f mb\n", SharedData.size_original_files);
 	for (TexCodec *codec = tex_codecs; codec; codec = codec->next)
 	{
@@ -1167,5 +1470,14 @@ int TexMain(int argc, char **argv)
 	}
 	if (SharedData.zip_len)
 		Print("    archive size: %.2f mb\n", SharedData.zip_len / 1048576.0f);
+	TexSchedule_Save();
+	TexSample_SaveTools();
+	TexStats_Flush();
+	if (trace_enabled)
+	{
+		TexStats_PrintTimings();
+		Trace_Write(tex_traceFile);
+		Trace_Shutdown();
+	}
 	return 0; 
 }
\ No newline at end of file
@@ -45,6 +45,25 @@ enum texprofile
 	extern OptionList tex_profiles[];
 #endif
 
+// what is changed when texture misses quality target, each step includes previous ones
+enum texescalate
+{
+	ESCALATE_PROFILE,      // slower profiles, up to the selected one
+	ESCALATE_TOOL,         // other tools supporting the format
+	ESCALATE_FORMAT,       // bigger formats of the codec
+}; 
+#ifdef F_TEX_C
+	OptionList tex_escalations[] = 
+	{ 
+		{ "profile", ESCALATE_PROFILE }, 
+		{ "tool", ESCALATE_TOOL }, 
+		{ "format", ESCALATE_FORMAT },
+		{ 0 }
+	};
+#else
+	extern OptionList tex_escalations[];
+#endif
+
 // compression block
 typedef struct TexBlock_s
 {
@@ -161,6 +180,7 @@ typedef struct TexContainer_s
 	byte            *(*fCreateHeader)(LoadedImage *image, TexFormat *format, size_t *headersize);
 	size_t           (*fWriteMipHeader)(byte *stream, size_t width, size_t height, size_t pixeldatasize);
 	bool             (*fReadHeader)(struct TexDecodeTask_s *task);
+	void             (*fPackStream)(struct TexEncodeTask_s *task); // called after compression, may reallocate stream (optional)
 	// system fields
 	char              *cmdParm;
 	TexContainer_s    *next;
@@ -172,6 +192,13 @@ typedef struct TexContainer_s
 #include "tex_compress.h"
 #include "tex_decompress.h"
 #include "tex_calcerror.h"
+#include "tex_schedule.h"
+#include "tex_stats.h"
+#include "tex_bench.h"
+#include "tex_fastpath.h"
+#include "tex_verify.h"
+#include "tex_blockdecode.h"
+#include "tex_sample.h"
 
 //
 // compression codecs
@@ -205,6 +232,8 @@ typedef struct TexContainer_s
 //
 #include "file_dds.h"
 #include "file_ktx.h"
+#include "file_ktx2.h"
+#include "file_crn.h"
 
 //
 // Generic
@@ -237,6 +266,7 @@ TexContainer *findContainerForFile(char *filename, byte *data, size_t datasize);
 void          FreeContainers(void);
 
 // main
+size_t        compressedLevelSize(TexFormat *format, int width, int height);
 size_t        compressedTextureSize(LoadedImage *image, TexFormat *format, TexContainer *container, bool baseTex, bool mipLevels);
 size_t        compressedTextureBPP(LoadedImage *image, TexFormat *format, TexContainer *container);
 void          Tex_PrintCodecs(void);
@@ -289,14 +319,19 @@ extern CompareList   tex_glowMapFiles;
 extern CompareList   tex_sRGBcolorspace;
 extern bool          tex_forceBestPSNR;
 extern bool          tex_detectBinaryAlpha;
+extern bool          tex_keepOpaqueAlpha;
+extern bool          tex_noFastPath;
 extern byte          tex_binaryAlphaMin;
 extern byte          tex_binaryAlphaMax;
 extern byte          tex_binaryAlphaCenter;
 extern float         tex_binaryAlphaThreshold;
+extern int           tex_alphaBleedDistance;
 extern CompareList   tex_archiveFiles;
 extern string        tex_addPath;
 extern int           tex_zipInMemory;
 extern int           tex_zipCompression;
+extern int           tex_zstdLevel;
+extern int           tex_zstdThreads;
 extern CompareList   tex_zipAddFiles;
 extern CompareList   tex_scale2xFiles;
 extern CompareList   tex_scale4xFiles;
@@ -308,6 +343,30 @@ extern bool          tex_testCompresion_keepSize;
 extern bool          tex_testCompresionError;
 extern bool          tex_testCompresionAllErrors;
 extern char          tex_statsFile[MAX_FPATH];
+extern char          tex_traceFile[MAX_FPATH];
+extern int           tex_memBudget;
+extern double        tex_deadline;
+extern double        tex_targetPSNR;
+extern double        tex_targetRMS;
+extern texescalate   tex_targetEscalate;
+extern vector<TexTargetRule*> tex_targetRules;
+extern bool          tex_autoFormat;
+extern bool          tex_prescreen;
+extern double        tex_prescreenMargin;
+extern bool          tex_tournament;
+extern double        tex_tournamentEpsilon;
+extern char          tex_tournamentFile[MAX_FPATH];
+extern char          tex_scheduleFile[MAX_FPATH];
+extern bool          tex_scheduleOrder;
+extern bool          tex_bench;
+extern char          tex_benchFilter[256];
+extern char          tex_benchOutput[MAX_FPATH];
+extern int           tex_benchWarmup;
+extern int           tex_benchReps;
+extern bool          tex_verify;
+extern char          tex_verifySource[MAX_FPATH];
+extern char          tex_verifyReport[MAX_FPATH];
+extern bool          tex_verifyTGA;
 
 extern TexErrorMetric tex_errorMetric;
 extern TexContainer *tex_container;
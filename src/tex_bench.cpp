@@ -0,0 +1,561 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / compression tools benchmark
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "tex.h"
+#include "freeimage.h"
+#include "scale2x.h"
+
+// check if tool:format pair passes -benchfilter
+bool BenchFilterMatch(TexTool *tool, TexFormat *format)
+{
+	char filter[256], *fmt;
+
+	if (!tex_benchFilter[0])
+		return true;
+	strlcpy(filter, tex_benchFilter, sizeof(filter));
+	fmt = strchr(filter, ':');
+	if (fmt)
+		*fmt++ = 0;
+	if (filter[0] && strcmp(filter, "*") && stricmp(filter, tool->parmName) && stricmp(filter, tool->name))
+		return false;
+	if (fmt && fmt[0] && strcmp(fmt, "*") && stricmp(fmt, format->parmName) && stricmp(fmt, format->name))
+		return false;
+	return true;
+}
+
+bool BenchCodecActive(TexCodec *codec)
+{
+	for (TexCodec *c = tex_active_codecs; c; c = c->nextActive)
+		if (c == codec)
+			return true;
+	return false;
+}
+
+// psnr of averaged error metrics, 0 if nothing was measured
+double BenchPSNR(TexBenchResult *r)
+{
+	if (!r->errors)
+		return 0;
+	return ErrorPSNR(r->average / r->errors);
+}
+
+// time native block decoders against encoder library decoders on base level
+void BenchDecode(TexEncodeTask *task, TexBenchResult *r)
+{
+	TexDecodeTask decode[2];
+	byte *data[2];
+	size_t size[2];
+	bool allocated[2];
+	double start;
+	int library, i;
+
+	if (!task->container || !task->codec->fDecode)
+		return;
+	for (library = 0; library < 2; library++)
+	{
+		memset(&decode[library], 0, sizeof(TexDecodeTask));
+		DecodeFromEncode(&decode[library], task, (char *)task->file->name.c_str());
+		decode[library].libraryDecode = library ? true : false;
+		if (!decode[library].container->fReadHeader(&decode[library]))
+			Error("BenchDecode(%s): %s\n", decode[library].filename, decode[library].errorMessage);
+		for (i = 0; i < tex_benchWarmup + tex_benchReps; i++)
+		{
+			if (decode[library].image && decode[library].image->bitmap)
+			{
+				fiFree(decode[library].image->bitmap);
+				decode[library].image->bitmap = NULL;
+			}
+			start = I_DoubleTime();
+			DecompressImage(&decode[library]);
+			if (i >= tex_benchWarmup)
+				r->decodeSeconds[library] += I_DoubleTime() - start;
+		}
+	}
+	r->decodeMpix += (double)decode[0].image->width * decode[0].image->height / 1000000.0;
+
+	// native decoders should give same pixels
+	data[0] = Image_GetUnalignedData(decode[0].image, &size[0], &allocated[0], false);
+	data[1] = Image_GetUnalignedData(decode[1].image, &size[1], &allocated[1], false);
+	if (size[0] != size[1] || decode[0].image->colorSwap != decode[1].image->colorSwap || memcmp(data[0], data[1], size[0]))
+		r->decodeMismatch++;
+	Image_FreeUnalignedData(data[0], allocated[0]);
+	Image_FreeUnalignedData(data[1], allocated[1]);
+	Image_Delete(decode[0].image);
+	Image_Delete(decode[1].image);
+	FreeDecodeTask(&decode[0]);
+	FreeDecodeTask(&decode[1]);
+}
+
+// separable filter rounds in float, generic one in double
+#define BENCH_FILTER_TOLERANCE 1
+
+// time separable filter pass against generic one on blur kernel
+// and check that both give same pixels within tolerance
+void BenchFilter(LoadedImage *image, TexBenchFilter *r)
+{
+	double m[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 }, start;
+	byte *source, *data[2];
+	int width, height, bpp, separable, i, x;
+	bool allocated;
+	size_t size;
+	float v[3], h[3];
+
+	bpp = FreeImage_GetBPP(image->bitmap) / 8;
+	if (bpp != 1 && bpp != 3 && bpp != 4)
+		return;
+	width = FreeImage_GetWidth(image->bitmap);
+	height = FreeImage_GetHeight(image->bitmap);
+	if (!fiFilterSeparable(m, 16, v, h))
+		Error("BenchFilter: blur kernel is not separable\n");
+	size = (size_t)width*height*bpp;
+	source = fiGetUnalignedData(image->bitmap, &allocated, false);
+	for (separable = 0; separable < 2; separable++)
+	{
+		data[separable] = (byte *)mem_alloc(size);
+		for (i = 0; i < tex_benchWarmup + tex_benchReps; i++)
+		{
+			// separable pass is done in place, so every repetition starts from source pixels
+			if (separable)
+				memcpy(data[separable], source, size);
+			start = I_DoubleTime();
+			if (separable)
+				fiFilterSeparablePass(data[separable], width*bpp, width, height, bpp, v, h, 0);
+			else
+				fiFilterGenericPass(source, data[separable], width, height, bpp, m, 16, 0);
+			if (i >= tex_benchWarmup)
+				r->seconds[separable] += I_DoubleTime() - start;
+		}
+	}
+	for (x = 0; x < (int)size; x++)
+		r->maxDiff = max(r->maxDiff, abs((int)data[0][x] - (int)data[1][x]));
+	r->mpix += (double)width * height / 1000000.0;
+	r->images++;
+	mem_free(data[0]);
+	mem_free(data[1]);
+	fiFreeUnalignedData(source, allocated);
+}
+
+// scale2x rows are limited, so big images do not need huge scale4x buffers
+#define BENCH_SCALE_MAX_WIDTH  1024
+#define BENCH_SCALE_MAX_HEIGHT 256
+
+// run scale2x, scale3x and scale4x with SIMD row functions and C implementation
+// on 8 and 32 bit versions of image, output should be bit-exact
+// a copy with low bits cleared has more equal neighbours, so all rules are exercised
+void BenchScale(LoadedImage *image, TexBenchSIMD *r)
+{
+	static const int scales[3] = { 2, 3, 4 };
+	FIBITMAP *bitmap;
+	byte *data, *out[2];
+	int bpp, width, height, pitch, quantize, s, simd, i;
+	bool allocated;
+	size_t size;
+
+	if (!sxSetSIMD(1))
+		return;
+	for (bpp = 1; bpp <= 4; bpp += 3)
+	{
+		bitmap = fiConvertBPP(fiClone(image->bitmap), bpp, 0, NULL);
+		width = min((int)FreeImage_GetWidth(bitmap), BENCH_SCALE_MAX_WIDTH);
+		height = min((int)FreeImage_GetHeight(bitmap), BENCH_SCALE_MAX_HEIGHT);
+		data = fiGetUnalignedData(bitmap, &allocated, false);
+		pitch = FreeImage_GetWidth(bitmap) * bpp;
+		for (quantize = 0; quantize < 2; quantize++)
+		{
+			if (quantize)
+				for (i = 0; i < pitch * height; i++)
+					data[i] &= 0xE0;
+			for (s = 0; s < 3; s++)
+			{
+				if (sxCheck(scales[s], bpp, width, height) != SCALEX_OK)
+					continue;
+				size = (size_t)width*scales[s]*bpp*height*scales[s];
+				for (simd = 0; simd < 2; simd++)
+				{
+					out[simd] = (byte *)mem_alloc(size);
+					sxSetSIMD(simd);
+					sxScale(scales[s], out[simd], width*scales[s]*bpp, data, pitch, bpp, width, height);
+				}
+				r->scaleRuns++;
+				if (memcmp(out[0], out[1], size))
+					r->scaleMismatch++;
+				mem_free(out[0]);
+				mem_free(out[1]);
+			}
+		}
+		fiFreeUnalignedData(data, allocated);
+		fiFree(bitmap);
+	}
+	sxSetSIMD(1);
+}
+
+// run ImageData kernel k on data (and source for copies), false if there is no such kernel
+bool BenchKernel(int k, byte *data, byte *source, int width, int height, int pitch)
+{
+	static const int orders[3][4] = { { 2, 1, 0, 3 }, { 3, 1, 2, 0 }, { 0, 1, 2, -1 } };
+
+	switch(k)
+	{
+		case 0:
+		case 1:
+		case 2:
+			ImageData_Shuffle(data, width, height, pitch, orders[k]);
+			break;
+		case 3:
+			ImageData_SwapRB(data, width, height, pitch, 4);
+			break;
+		case 4:
+			ImageData_SwapRB(data, width, height, pitch, 3);
+			break;
+		case 5:
+		case 6:
+		case 7:
+		case 8:
+			ImageData_EncodeYCoCg(data, width, height, pitch, (k - 5) & 1 ? true : false, (k - 5) & 2 ? true : false);
+			break;
+		case 9:
+			ImageData_Premultiply(data, width, height, pitch);
+			break;
+		case 10:
+		case 11:
+			ImageData_CopyPixels(data, 4, source, 4, width*height, k == 11);
+			break;
+		case 12:
+			ImageData_CopyPixels(data, 4, source, 3, width*height, false);
+			break;
+		case 13:
+			ImageData_CopyPixels(data, 3, source, 4, width*height, false);
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+// run ImageData kernels with SSSE3 and scalar loops on random buffers, output should be bit-exact
+// widths are around vector sizes and rows have padding, so tails and pitch handling are covered
+void BenchImageData(TexBenchSIMD *r)
+{
+	static const int widths[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 23, 31, 32, 33, 63, 65, 100, 257 };
+	static const int heights[] = { 1, 2, 5 };
+	byte *source, *out[2];
+	int w, h, pad, width, height, pitch, k, simd, i;
+	unsigned int seed;
+	size_t size;
+
+	if (!ImageData_SetSSSE3(true))
+		return;
+	seed = 1;
+	for (w = 0; w < (int)(sizeof(widths) / sizeof(widths[0])); w++)
+	{
+		for (h = 0; h < (int)(sizeof(heights) / sizeof(heights[0])); h++)
+		{
+			for (pad = 0; pad <= 5; pad += 5)
+			{
+				width = widths[w];
+				height = heights[h];
+				pitch = width*4 + pad;
+				size = (size_t)pitch*height;
+				source = (byte *)mem_alloc(size);
+				out[0] = (byte *)mem_alloc(size);
+				out[1] = (byte *)mem_alloc(size);
+				for (i = 0; i < (int)size; i++)
+				{
+					seed = seed * 1103515245 + 12345;
+					source[i] = (byte)(seed >> 16);
+				}
+				for (k = 0; ; k++)
+				{
+					for (simd = 0; simd < 2; simd++)
+					{
+						memcpy(out[simd], source, size);
+						ImageData_SetSSSE3(simd ? true : false);
+						if (!BenchKernel(k, out[simd], source, width, height, pitch))
+							break;
+					}
+					if (simd < 2)
+						break;
+					r->kernelRuns++;
+					if (memcmp(out[0], out[1], size))
+						r->kernelMismatch++;
+				}
+				mem_free(source);
+				mem_free(out[0]);
+				mem_free(out[1]);
+			}
+		}
+	}
+	ImageData_SetSSSE3(true);
+}
+
+// encode prepared image for all profiles
+void BenchTask(TexEncodeTask *task, vector<TexBenchResult> &results, size_t first)
+{
+	TexBenchResult *r;
+	TexCalcErrors *calc;
+	double mpix, blocks, start;
+	int p, i;
+
+	// workload per repetition
+	mpix = blocks = 0;
+	for (ImageMap *map = task->image->maps; map; map = map->next)
+	{
+		mpix += (double)map->width * map->height / 1000000.0;
+		blocks += ceil((double)map->width / task->format->block->width) * ceil((double)map->height / task->format->block->height);
+	}
+
+	for (p = 0; p < NUM_PROFILES; p++)
+	{
+		r = &results[first + p];
+		task->profile = (texprofile)p;
+
+		// warmup
+		for (i = 0; i < tex_benchWarmup; i++)
+		{
+			CompressStream(task);
+			mem_free(task->stream);
+		}
+
+		// measure
+		start = I_DoubleTime();
+		for (i = 0; i < tex_benchReps; i++)
+		{
+			CompressStream(task);
+			if (i < tex_benchReps - 1)
+				mem_free(task->stream);
+		}
+		r->seconds += I_DoubleTime() - start;
+		r->reps = tex_benchReps;
+		r->images++;
+		r->mpix += mpix;
+		r->blocks += blocks;
+		r->bytes += task->streamLen;
+
+		// compression errors of last repetition
+		calc = TexCompressionError((char *)task->file->name.c_str(), task, ERRORMETRIC_AUTO);
+		if (calc)
+		{
+			r->average += calc->average;
+			r->rms += calc->rms;
+			r->errors++;
+			FreeErrorCalc(calc);
+		}
+		BenchDecode(task, r);
+		mem_free(task->stream);
+		task->streamLen = 0;
+	}
+}
+
+// time fused map preprocessing against sequential passes on base level
+void BenchPreprocess(TexEncodeTask *task, TexBenchResult *r)
+{
+	MapProcessParms parms;
+	ImageMap map;
+	byte *source;
+	size_t size;
+	bool allocated;
+	double start;
+	int i, fused;
+
+	PreprocessParms(task, task->image->maps->sRGB, &parms);
+	source = Image_GetUnalignedData(task->image, &size, &allocated, false);
+	memset(&map, 0, sizeof(map));
+	map.width = task->image->width;
+	map.height = task->image->height;
+	map.datasize = size;
+	map.data = (byte *)mem_alloc(size);
+	for (fused = 0; fused < 2; fused++)
+	{
+		for (i = 0; i < tex_benchWarmup + tex_benchReps; i++)
+		{
+			memcpy(map.data, source, size);
+			map.sRGB = task->image->sRGB;
+			start = I_DoubleTime();
+			r->prepPasses[fused] = PreprocessMap(&map, &parms, task->image->bpp, task->image->colorSwap, fused ? true : false);
+			if (i >= tex_benchWarmup)
+				r->prepSeconds[fused] += I_DoubleTime() - start;
+		}
+	}
+	mem_free(map.data);
+	Image_FreeUnalignedData(source, allocated);
+}
+
+void BenchWriteJSON(char *filename, vector<TexBenchResult> &results, TexBenchFilter *filter, TexBenchSIMD *simd)
+{
+	TexBenchResult *r, *p;
+	FILE *f;
+
+	f = SafeOpenWrite(filename);
+	fprintf(f, "{\n  \"version\": \"%s.%s\",\n  \"warmup\": %i,\n  \"reps\": %i,\n", RWGTEX_VERSION_MAJOR, RWGTEX_VERSION_MINOR, tex_benchWarmup, tex_benchReps);
+	fprintf(f, "  \"filter\": { \"images\": %i, \"generic_mpix_per_sec\": %.4f, \"separable_mpix_per_sec\": %.4f, \"max_diff\": %i, \"tolerance\": %i },\n", filter->images, filter->seconds[0] > 0 ? filter->mpix * tex_benchReps / filter->seconds[0] : 0, filter->seconds[1] > 0 ? filter->mpix * tex_benchReps / filter->seconds[1] : 0, filter->maxDiff, BENCH_FILTER_TOLERANCE);
+	fprintf(f, "  \"simd\": { \"scale_runs\": %i, \"scale_mismatch\": %i, \"kernel_runs\": %i, \"kernel_mismatch\": %i },\n", simd->scaleRuns, simd->scaleMismatch, simd->kernelRuns, simd->kernelMismatch);
+	fprintf(f, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		r = &results[i];
+		fprintf(f, "    { \"tool\": \"%s\", \"format\": \"%s\", \"profile\": \"%s\", \"images\": %i, ", r->tool->parmName, r->format->name, OptionEnumName(r->profile, tex_profiles), r->images);
+		fprintf(f, "\"mpix_per_sec\": %.4f, \"blocks_per_sec\": %.1f, \"seconds\": %.6f, \"bytes\": %llu, ", r->seconds > 0 ? r->mpix * r->reps / r->seconds : 0, r->seconds > 0 ? r->blocks * r->reps / r->seconds : 0, r->seconds, (unsigned long long)r->bytes);
+		p = &results[i - i % NUM_PROFILES];
+		fprintf(f, "\"prep_sequential_ms\": %.4f, \"prep_fused_ms\": %.4f, \"prep_passes\": [%i, %i], ", p->images ? p->prepSeconds[0] * 1000.0 / (p->images * p->reps) : 0, p->images ? p->prepSeconds[1] * 1000.0 / (p->images * p->reps) : 0, p->prepPasses[0], p->prepPasses[1]);
+		fprintf(f, "\"decode_native_mpix_per_sec\": %.4f, \"decode_library_mpix_per_sec\": %.4f, \"decode_mismatch\": %i, ", r->decodeSeconds[0] > 0 ? r->decodeMpix * r->reps / r->decodeSeconds[0] : 0, r->decodeSeconds[1] > 0 ? r->decodeMpix * r->reps / r->decodeSeconds[1] : 0, r->decodeMismatch);
+		fprintf(f, "\"rms\": %.4f, \"psnr\": %.4f }%s\n", r->errors ? r->rms / r->errors : 0, BenchPSNR(r), (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	fclose(f);
+}
+
+// run every registered tool on every supported format and profile
+// on a fixed set of images, measure throughput and quality
+int TexBench(vector<FS_File> &files)
+{
+	vector<TexBenchResult> results;
+	TexBenchResult result;
+	TexBenchFilter filter;
+	TexBenchSIMD simd;
+	TexEncodeTask task;
+	LoadedImage *image;
+	bool savefastpath, failed;
+	size_t first;
+
+	// tool:format pairs
+	for (TexTool *tool = tex_tools; tool; tool = tool->next)
+	{
+		for (vector<TexFormat*>::iterator f = tool->formats.begin(); f < tool->formats.end(); f++)
+		{
+			if (!BenchCodecActive((*f)->codec) || !BenchFilterMatch(tool, *f))
+				continue;
+			for (int p = 0; p < NUM_PROFILES; p++)
+			{
+				memset(&result, 0, sizeof(result));
+				result.tool = tool;
+				result.format = *f;
+				result.profile = (texprofile)p;
+				results.push_back(result);
+			}
+		}
+	}
+	if (!results.size())
+	{
+		Print("No tools to benchmark (filter \"%s\")\n", tex_benchFilter);
+		return 1;
+	}
+	Print("Benchmarking %i tool/format pairs on %i files (%i warmup, %i repetitions)\n", results.size() / NUM_PROFILES, files.size(), tex_benchWarmup, tex_benchReps);
+
+	// run
+	// preparation (conversion, mipmaps) is not measured, so each pair gets freshly loaded image
+	// tools are always run, even for solid color images
+	savefastpath = tex_noFastPath;
+	tex_noFastPath = true;
+	image = Image_Create();
+	memset(&filter, 0, sizeof(filter));
+	memset(&simd, 0, sizeof(simd));
+	Pacifier(" filter and SIMD kernels");
+	BenchImageData(&simd);
+	for (vector<FS_File>::iterator file = files.begin(); file < files.end(); file++)
+	{
+		Image_Load(&(*file), image);
+		if (image->bitmap == NULL)
+			continue;
+		BenchFilter(image, &filter);
+		BenchScale(image, &simd);
+		Image_Unload(image);
+	}
+	for (first = 0; first < results.size(); first += NUM_PROFILES)
+	{
+		Pacifier(" %s:%s", results[first].tool->parmName, results[first].format->name);
+		for (vector<FS_File>::iterator file = files.begin(); file < files.end(); file++)
+		{
+			Image_Load(&(*file), image);
+			if (image->bitmap == NULL)
+				continue;
+			memset(&task, 0, sizeof(task));
+			task.file = &(*file);
+			task.image = image;
+			task.container = tex_container;
+			task.codec = results[first].format->codec;
+			task.tool = results[first].tool;
+			task.format = results[first].format;
+			image->datatype = IMAGE_COLOR;
+			if (FS_FileMatchList(task.file, image, tex_normalMapFiles.items))
+				image->datatype = IMAGE_NORMALMAP;
+			CompressPrepare(&task);
+			BenchPreprocess(&task, &results[first]);
+			BenchTask(&task, results, first);
+			Image_Unload(image);
+		}
+	}
+	Image_Delete(image);
+	PacifierEnd();
+	tex_noFastPath = savefastpath;
+
+	// show results
+	Print("%-24s %-8s %10s %12s %12s %8s %8s\n", "tool:format", "profile", "MPix/s", "blocks/s", "bytes", "rms", "psnr");
+	for (vector<TexBenchResult>::iterator r = results.begin(); r < results.end(); r++)
+	{
+		char name[256];
+		if (!r->images)
+			continue;
+		sprintf_s(name, sizeof(name), "%s:%s", r->tool->parmName, r->format->name);
+		Print("%-24s %-8s %10.3f %12.0f %12i %8.3f %8.2f\n", name, OptionEnumName(r->profile, tex_profiles), r->seconds > 0 ? r->mpix * r->reps / r->seconds : 0, r->seconds > 0 ? r->blocks * r->reps / r->seconds : 0, (int)r->bytes, r->errors ? r->rms / r->errors : 0, BenchPSNR(&(*r)));
+	}
+	Print("%-24s %14s %14s %8s\n", "map preprocessing", "sequential", "fused", "passes");
+	for (first = 0; first < results.size(); first += NUM_PROFILES)
+	{
+		char name[256];
+		TexBenchResult *r = &results[first];
+		if (!r->images || !r->prepPasses[0])
+			continue;
+		sprintf_s(name, sizeof(name), "%s:%s", r->tool->parmName, r->format->name);
+		Print("%-24s %12.3fms %12.3fms %5i->%i\n", name, r->prepSeconds[0] * 1000.0 / (r->images * r->reps), r->prepSeconds[1] * 1000.0 / (r->images * r->reps), r->prepPasses[0], r->prepPasses[1]);
+	}
+	Print("%-24s %-8s %10s %10s %10s\n", "decoding", "profile", "native", "library", "mismatch");
+	for (vector<TexBenchResult>::iterator r = results.begin(); r < results.end(); r++)
+	{
+		char name[256];
+		if (!r->images || r->decodeMpix <= 0)
+			continue;
+		sprintf_s(name, sizeof(name), "%s:%s", r->tool->parmName, r->format->name);
+		Print("%-24s %-8s %10.3f %10.3f %10i\n", name, OptionEnumName(r->profile, tex_profiles), r->decodeSeconds[0] > 0 ? r->decodeMpix * r->reps / r->decodeSeconds[0] : 0, r->decodeSeconds[1] > 0 ? r->decodeMpix * r->reps / r->decodeSeconds[1] : 0, r->decodeMismatch);
+	}
+	if (filter.images)
+	{
+		Print("%-24s %10s %10s %10s\n", "filter", "generic", "separable", "maxdiff");
+		Print("%-24s %10.3f %10.3f %10i\n", "blur", filter.seconds[0] > 0 ? filter.mpix * tex_benchReps / filter.seconds[0] : 0, filter.seconds[1] > 0 ? filter.mpix * tex_benchReps / filter.seconds[1] : 0, filter.maxDiff);
+	}
+	if (simd.scaleRuns || simd.kernelRuns)
+	{
+		Print("%-24s %10s %10s\n", "SIMD against C", "runs", "mismatch");
+		Print("%-24s %10i %10i\n", "scale2x/3x/4x", simd.scaleRuns, simd.scaleMismatch);
+		Print("%-24s %10i %10i\n", "image data kernels", simd.kernelRuns, simd.kernelMismatch);
+	}
+	if (tex_benchOutput[0])
+	{
+		BenchWriteJSON(tex_benchOutput, results, &filter, &simd);
+		Print("Benchmark results written to \"%s\"\n", tex_benchOutput);
+	}
+
+	// self-checks
+	failed = false;
+	if (filter.maxDiff > BENCH_FILTER_TOLERANCE)
+	{
+		Warning("separable filter differs from generic one by %i (tolerance is %i)", filter.maxDiff, BENCH_FILTER_TOLERANCE);
+		failed = true;
+	}
+	if (simd.scaleMismatch)
+	{
+		Warning("SIMD scale2x differs from C implementation in %i of %i runs", simd.scaleMismatch, simd.scaleRuns);
+		failed = true;
+	}
+	if (simd.kernelMismatch)
+	{
+		Warning("SSSE3 image data kernels differ from scalar loops in %i of %i runs", simd.kernelMismatch, simd.kernelRuns);
+		failed = true;
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+// tex_bench.h
+#ifndef H_TEX_BENCH_H
+#define H_TEX_BENCH_H
+
+#include "tex.h"
+
+// benchmark result for tool:format:profile
+typedef struct
+{
+	TexTool    *tool;
+	TexFormat  *format;
+	texprofile  profile;
+	int         images;
+	double      mpix;     // megapixels per repetition (all mip levels)
+	double      blocks;   // blocks per repetition
+	double      seconds;  // total time of all repetitions
+	int         reps;
+	size_t      bytes;    // output bytes per repetition
+	double      average;  // summed error metrics
+	double      rms;
+	int         errors;   // number of error measurements
+	double      prepSeconds[2]; // map preprocessing time, sequential and fused (first profile only)
+	int         prepPasses[2];
+	double      decodeSeconds[2]; // base level decoding time, native and library decoders
+	double      decodeMpix;       // decoded megapixels per repetition
+	int         decodeMismatch;   // images where native decoder output differs from library
+} TexBenchResult;
+
+// separable filter against generic one
+typedef struct
+{
+	int         images;
+	double      mpix;       // megapixels per repetition
+	double      seconds[2]; // total time, generic and separable pass
+	int         maxDiff;    // max per-channel difference between passes
+} TexBenchFilter;
+
+// SIMD kernels against scalar code, any difference fails the benchmark
+typedef struct
+{
+	int         scaleRuns;      // scale2x/3x/4x runs compared
+	int         scaleMismatch;  // runs where SIMD output differs from C implementation
+	int         kernelRuns;     // ImageData kernel runs compared
+	int         kernelMismatch; // runs where SSSE3 output differs from scalar loops
+} TexBenchSIMD;
+
+// generic
+int TexBench(vector<FS_File> &files);
+
+#endif
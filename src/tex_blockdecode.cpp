@@ -0,0 +1,717 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / native block decoders
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "tex.h"
+
+// decoded block is 16 RGBA pixels, little-endian words
+#define BLOCK_RGBA(r,g,b,a) ((unsigned int)(r) | ((unsigned int)(g) << 8) | ((unsigned int)(b) << 16) | ((unsigned int)(a) << 24))
+#define BLOCK_CLAMP(x) ((x) < 0 ? 0 : ((x) > 255 ? 255 : (x)))
+
+static const byte blockdecode_expand5[32] =
+{
+	0, 8, 16, 24, 33, 41, 49, 57, 66, 74, 82, 90, 99, 107, 115, 123,
+	132, 140, 148, 156, 165, 173, 181, 189, 198, 206, 214, 222, 231, 239, 247, 255
+};
+
+static const byte blockdecode_expand6[64] =
+{
+	0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60,
+	65, 69, 73, 77, 81, 85, 89, 93, 97, 101, 105, 109, 113, 117, 121, 125,
+	130, 134, 138, 142, 146, 150, 154, 158, 162, 166, 170, 174, 178, 182, 186, 190,
+	195, 199, 203, 207, 211, 215, 219, 223, 227, 231, 235, 239, 243, 247, 251, 255
+};
+
+// ETC1 modifiers by stored pixel index
+static const int blockdecode_etcModifiers[8][4] =
+{
+	{ 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+	{ 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 }
+};
+
+// ETC2 T/H mode distances
+static const int blockdecode_etcDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+// EAC modifiers
+static const int blockdecode_eacModifiers[16][8] =
+{
+	{ -3, -6,  -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5,  -8, -13, 1, 4, 7, 12 }, { -2, -4,  -6, -13, 1, 3, 5, 12 },
+	{ -3, -6,  -8, -12, 2, 5, 7, 11 }, { -3, -7,  -9, -11, 2, 6, 8, 10 },
+	{ -4, -7,  -8, -11, 3, 6, 7, 10 }, { -3, -5,  -8, -11, 2, 4, 7, 10 },
+	{ -2, -6,  -8, -10, 1, 5, 7,  9 }, { -2, -5,  -8, -10, 1, 4, 7,  9 },
+	{ -2, -4,  -8, -10, 1, 3, 7,  9 }, { -2, -5,  -7, -10, 1, 4, 6,  9 },
+	{ -3, -4,  -7, -10, 2, 3, 6,  9 }, { -1, -2,  -3, -10, 0, 1, 2,  9 },
+	{ -4, -6,  -8,  -9, 3, 5, 7,  8 }, { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+/*
+==========================================================================================
+
+  DXT
+
+==========================================================================================
+*/
+
+// color block, DXT1 gets 3-color mode with transparent black->white, DXT3 gets 3-color mode, DXT5 is always 4-color
+// (same as gimpdds decoder does)
+void BlockDecode_DXTColor(const byte *src, unsigned int *px, bool threeColor, bool punchAlpha)
+{
+	unsigned int pal[4], c0, c1, indexes;
+	int r0, g0, b0, r1, g1, b1, x, y;
+
+	c0 = src[0] | (src[1] << 8);
+	c1 = src[2] | (src[3] << 8);
+	r0 = blockdecode_expand5[c0 >> 11]; g0 = blockdecode_expand6[(c0 >> 5) & 63]; b0 = blockdecode_expand5[c0 & 31];
+	r1 = blockdecode_expand5[c1 >> 11]; g1 = blockdecode_expand6[(c1 >> 5) & 63]; b1 = blockdecode_expand5[c1 & 31];
+	pal[0] = BLOCK_RGBA(r0, g0, b0, 255);
+	pal[1] = BLOCK_RGBA(r1, g1, b1, 255);
+	if (c0 > c1 || !threeColor)
+	{
+		pal[2] = BLOCK_RGBA((2*r0 + r1) / 3, (2*g0 + g1) / 3, (2*b0 + b1) / 3, 255);
+		pal[3] = BLOCK_RGBA((r0 + 2*r1) / 3, (g0 + 2*g1) / 3, (b0 + 2*b1) / 3, 255);
+	}
+	else
+	{
+		pal[2] = BLOCK_RGBA((r0 + r1 + 1) >> 1, (g0 + g1 + 1) >> 1, (b0 + b1 + 1) >> 1, 255);
+		pal[3] = BLOCK_RGBA(255, 255, 255, punchAlpha ? 0 : 255);
+	}
+	for (y = 0; y < 4; y++)
+	{
+		indexes = src[4 + y];
+		for (x = 0; x < 4; x++, indexes >>= 2)
+			px[y*4 + x] = pal[indexes & 3];
+	}
+}
+
+void BlockDecode_DXT3Alpha(const byte *src, unsigned int *px)
+{
+	for (int i = 0; i < 16; i++)
+		px[i] = (px[i] & 0x00FFFFFF) | ((unsigned int)(((src[i >> 1] >> ((i & 1) * 4)) & 15) * 17) << 24);
+}
+
+void BlockDecode_DXT5Alpha(const byte *src, unsigned int *px)
+{
+	unsigned int pal[8];
+	unsigned long long bits;
+	int a0, a1, i;
+
+	a0 = src[0];
+	a1 = src[1];
+	pal[0] = a0;
+	pal[1] = a1;
+	if (a0 > a1)
+	{
+		for (i = 2; i < 8; i++)
+			pal[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+	}
+	else
+	{
+		for (i = 2; i < 6; i++)
+			pal[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+	bits = 0;
+	for (i = 7; i >= 2; i--)
+		bits = (bits << 8) | src[i];
+	for (i = 0; i < 16; i++, bits >>= 3)
+		px[i] = (px[i] & 0x00FFFFFF) | (pal[bits & 7] << 24);
+}
+
+/*
+==========================================================================================
+
+  ETC1/ETC2
+
+==========================================================================================
+*/
+
+// individual/differential mode
+void BlockDecode_ETCSubblocks(unsigned int hi, unsigned int lo, int *c1, int *c2, unsigned int *px, bool punchThrough)
+{
+	const int *mod1, *mod2, *c, *mod;
+	int x, y, i, index, m;
+	bool flip;
+
+	mod1 = blockdecode_etcModifiers[(hi >> 5) & 7];
+	mod2 = blockdecode_etcModifiers[(hi >> 2) & 7];
+	flip = (hi & 1) ? true : false;
+	for (x = 0; x < 4; x++)
+	{
+		for (y = 0; y < 4; y++)
+		{
+			i = x*4 + y;
+			index = (((lo >> (i + 16)) & 1) << 1) | ((lo >> i) & 1);
+			if ((flip ? y : x) < 2)
+			{
+				c = c1;
+				mod = mod1;
+			}
+			else
+			{
+				c = c2;
+				mod = mod2;
+			}
+			m = mod[index];
+			if (punchThrough)
+			{
+				if (index == 2)
+				{
+					px[y*4 + x] = 0;
+					continue;
+				}
+				if (index == 0)
+					m = 0;
+			}
+			px[y*4 + x] = BLOCK_RGBA(BLOCK_CLAMP(c[0] + m), BLOCK_CLAMP(c[1] + m), BLOCK_CLAMP(c[2] + m), 255);
+		}
+	}
+}
+
+// T and H modes, 4 paint colors
+void BlockDecode_ETCPaint(unsigned int lo, int paint[4][3], unsigned int *px, bool punchThrough)
+{
+	int x, y, i, index;
+
+	for (x = 0; x < 4; x++)
+	{
+		for (y = 0; y < 4; y++)
+		{
+			i = x*4 + y;
+			index = (((lo >> (i + 16)) & 1) << 1) | ((lo >> i) & 1);
+			if (punchThrough && index == 2)
+				px[y*4 + x] = 0;
+			else
+				px[y*4 + x] = BLOCK_RGBA(paint[index][0], paint[index][1], paint[index][2], 255);
+		}
+	}
+}
+
+void BlockDecode_ETCSetPaint(int *paint, int *c, int d)
+{
+	paint[0] = BLOCK_CLAMP(c[0] + d);
+	paint[1] = BLOCK_CLAMP(c[1] + d);
+	paint[2] = BLOCK_CLAMP(c[2] + d);
+}
+
+// ETC1 and ETC2 RGB block, punch-through alpha is used if opaque bit is not set
+void BlockDecode_ETC2Color(const byte *src, unsigned int *px, bool punchThroughAlpha)
+{
+	unsigned int hi, lo;
+	int c1[3], c2[3], paint[4][3], r, g, b, d, x, y;
+	bool punchThrough;
+
+	hi = (src[0] << 24) | (src[1] << 16) | (src[2] << 8) | src[3];
+	lo = (src[4] << 24) | (src[5] << 16) | (src[6] << 8) | src[7];
+
+	// individual mode (no punch-through blocks have it, diff bit is opaque flag there)
+	punchThrough = punchThroughAlpha && !(hi & 2);
+	if (!punchThroughAlpha && !(hi & 2))
+	{
+		c1[0] = ((hi >> 28) & 15) * 17; c1[1] = ((hi >> 20) & 15) * 17; c1[2] = ((hi >> 12) & 15) * 17;
+		c2[0] = ((hi >> 24) & 15) * 17; c2[1] = ((hi >> 16) & 15) * 17; c2[2] = ((hi >> 8) & 15) * 17;
+		BlockDecode_ETCSubblocks(hi, lo, c1, c2, px, false);
+		return;
+	}
+
+	// differential mode, overflowed colors select ETC2 modes
+	r = (hi >> 27) & 31;
+	g = (hi >> 19) & 31;
+	b = (hi >> 11) & 31;
+	r += ((int)((hi >> 24) & 7) ^ 4) - 4;
+	g += ((int)((hi >> 16) & 7) ^ 4) - 4;
+	b += ((int)((hi >> 8) & 7) ^ 4) - 4;
+	if (r < 0 || r > 31)
+	{
+		// T mode
+		c1[0] = ((((hi >> 27) & 3) << 2) | ((hi >> 24) & 3)) * 17;
+		c1[1] = ((hi >> 20) & 15) * 17;
+		c1[2] = ((hi >> 16) & 15) * 17;
+		c2[0] = ((hi >> 12) & 15) * 17;
+		c2[1] = ((hi >> 8) & 15) * 17;
+		c2[2] = ((hi >> 4) & 15) * 17;
+		d = blockdecode_etcDistances[((hi >> 1) & 6) | (hi & 1)];
+		BlockDecode_ETCSetPaint(paint[0], c1, 0);
+		BlockDecode_ETCSetPaint(paint[1], c2, d);
+		BlockDecode_ETCSetPaint(paint[2], c2, 0);
+		BlockDecode_ETCSetPaint(paint[3], c2, -d);
+		BlockDecode_ETCPaint(lo, paint, px, punchThrough);
+	}
+	else if (g < 0 || g > 31)
+	{
+		// H mode
+		r = (hi >> 27) & 15;
+		g = (((hi >> 24) & 7) << 1) | ((hi >> 20) & 1);
+		b = (((hi >> 19) & 1) << 3) | ((hi >> 15) & 7);
+		c1[0] = r * 17; c1[1] = g * 17; c1[2] = b * 17;
+		c2[0] = ((hi >> 11) & 15) * 17;
+		c2[1] = ((hi >> 7) & 15) * 17;
+		c2[2] = ((hi >> 3) & 15) * 17;
+		d = (((hi >> 2) & 1) << 2) | ((hi & 1) << 1);
+		if (((r << 8) | (g << 4) | b) >= (int)((((hi >> 11) & 15) << 8) | (((hi >> 7) & 15) << 4) | ((hi >> 3) & 15)))
+			d |= 1;
+		d = blockdecode_etcDistances[d];
+		BlockDecode_ETCSetPaint(paint[0], c1, d);
+		BlockDecode_ETCSetPaint(paint[1], c1, -d);
+		BlockDecode_ETCSetPaint(paint[2], c2, d);
+		BlockDecode_ETCSetPaint(paint[3], c2, -d);
+		BlockDecode_ETCPaint(lo, paint, px, punchThrough);
+	}
+	else if (b < 0 || b > 31)
+	{
+		// planar mode (always opaque)
+		int o[3], h[3], v[3];
+		o[0] = (hi >> 25) & 63;
+		o[1] = (((hi >> 24) & 1) << 6) | ((hi >> 17) & 63);
+		o[2] = (((hi >> 16) & 1) << 5) | (((hi >> 11) & 3) << 3) | ((hi >> 7) & 7);
+		h[0] = (((hi >> 2) & 31) << 1) | (hi & 1);
+		h[1] = (lo >> 25) & 127;
+		h[2] = (lo >> 19) & 63;
+		v[0] = (lo >> 13) & 63;
+		v[1] = (lo >> 6) & 127;
+		v[2] = lo & 63;
+		o[0] = (o[0] << 2) | (o[0] >> 4); o[1] = (o[1] << 1) | (o[1] >> 6); o[2] = (o[2] << 2) | (o[2] >> 4);
+		h[0] = (h[0] << 2) | (h[0] >> 4); h[1] = (h[1] << 1) | (h[1] >> 6); h[2] = (h[2] << 2) | (h[2] >> 4);
+		v[0] = (v[0] << 2) | (v[0] >> 4); v[1] = (v[1] << 1) | (v[1] >> 6); v[2] = (v[2] << 2) | (v[2] >> 4);
+		for (y = 0; y < 4; y++)
+		{
+			for (x = 0; x < 4; x++)
+			{
+				r = (x*(h[0] - o[0]) + y*(v[0] - o[0]) + 4*o[0] + 2) >> 2;
+				g = (x*(h[1] - o[1]) + y*(v[1] - o[1]) + 4*o[1] + 2) >> 2;
+				b = (x*(h[2] - o[2]) + y*(v[2] - o[2]) + 4*o[2] + 2) >> 2;
+				px[y*4 + x] = BLOCK_RGBA(BLOCK_CLAMP(r), BLOCK_CLAMP(g), BLOCK_CLAMP(b), 255);
+			}
+		}
+	}
+	else
+	{
+		c1[0] = blockdecode_expand5[(hi >> 27) & 31]; c1[1] = blockdecode_expand5[(hi >> 19) & 31]; c1[2] = blockdecode_expand5[(hi >> 11) & 31];
+		c2[0] = blockdecode_expand5[r]; c2[1] = blockdecode_expand5[g]; c2[2] = blockdecode_expand5[b];
+		BlockDecode_ETCSubblocks(hi, lo, c1, c2, px, punchThrough);
+	}
+}
+
+// ETC2 EAC alpha block (pixels are stored in columns)
+void BlockDecode_EACAlpha(const byte *src, unsigned int *px)
+{
+	unsigned long long bits;
+	const int *mod;
+	int base, mul, i, a;
+
+	base = src[0];
+	mul = src[1] >> 4;
+	mod = blockdecode_eacModifiers[src[1] & 15];
+	bits = 0;
+	for (i = 2; i < 8; i++)
+		bits = (bits << 8) | src[i];
+	for (i = 0; i < 16; i++)
+	{
+		a = base + mod[(bits >> (45 - i*3)) & 7] * mul;
+		px[(i & 3)*4 + (i >> 2)] = (px[(i & 3)*4 + (i >> 2)] & 0x00FFFFFF) | ((unsigned int)BLOCK_CLAMP(a) << 24);
+	}
+}
+
+/*
+==========================================================================================
+
+  Block rows
+
+==========================================================================================
+*/
+
+typedef struct
+{
+	TexBlock *block;
+	byte     *data;
+	byte     *out;
+	int       width;
+	int       height;
+	int       bpp;
+	int       blocksX;
+	size_t    blockBytes;
+}BlockDecodeRows;
+
+void BlockDecode_Rows(void *data, int yFirst, int yLast)
+{
+	BlockDecodeRows *rows = (BlockDecodeRows *)data;
+	unsigned int px[16];
+	TexBlock *block = rows->block;
+	byte *src, *dst, *in;
+	int bx, by, x, y, w, h, pitch;
+
+	pitch = rows->width * rows->bpp;
+	for (by = yFirst; by < yLast; by++)
+	{
+		src = rows->data + (size_t)by * rows->blocksX * rows->blockBytes;
+		h = min(4, rows->height - by*4);
+		for (bx = 0; bx < rows->blocksX; bx++, src += rows->blockBytes)
+		{
+			// decode
+			if (block == &B_DXT1)
+				BlockDecode_DXTColor(src, px, true, true);
+			else if (block == &B_DXT2 || block == &B_DXT3)
+			{
+				BlockDecode_DXTColor(src + 8, px, true, false);
+				BlockDecode_DXT3Alpha(src, px);
+			}
+			else if (block == &B_DXT4 || block == &B_DXT5)
+			{
+				BlockDecode_DXTColor(src + 8, px, false, false);
+				BlockDecode_DXT5Alpha(src, px);
+			}
+			else if (block == &B_ETC1 || block == &B_ETC2)
+				BlockDecode_ETC2Color(src, px, false);
+			else if (block == &B_ETC2A)
+			{
+				BlockDecode_ETC2Color(src + 8, px, false);
+				BlockDecode_EACAlpha(src, px);
+			}
+			else if (block == &B_ETC2A1)
+				BlockDecode_ETC2Color(src, px, true);
+
+			// store, edge blocks are clipped
+			w = min(4, rows->width - bx*4);
+			dst = rows->out + (size_t)by*4*pitch + bx*4*rows->bpp;
+			if (rows->bpp == 4)
+			{
+				for (y = 0; y < h; y++, dst += pitch)
+					memcpy(dst, px + y*4, w*4);
+				continue;
+			}
+			for (y = 0; y < h; y++, dst += pitch)
+			{
+				in = (byte *)(px + y*4);
+				for (x = 0; x < w; x++, in += 4)
+				{
+					dst[x*3 + 0] = in[0];
+					dst[x*3 + 1] = in[1];
+					dst[x*3 + 2] = in[2];
+				}
+			}
+		}
+	}
+}
+
+bool BlockDecode_Supported(TexBlock *block)
+{
+	if (block == &B_DXT1 || block == &B_DXT2 || block == &B_DXT3 || block == &B_DXT4 || block == &B_DXT5)
+		return true;
+	if (block == &B_ETC1 || block == &B_ETC2 || block == &B_ETC2A || block == &B_ETC2A1)
+		return true;
+	return false;
+}
+
+// decode DXT or ETC image, rows of blocks are split into bands on big images
+bool BlockDecode(TexBlock *block, byte *data, size_t datasize, byte *out, int width, int height, int bpp)
+{
+	BlockDecodeRows rows;
+	int blocksY;
+
+	if (!BlockDecode_Supported(block) || (bpp != 3 && bpp != 4))
+		return false;
+	rows.block = block;
+	rows.data = data;
+	rows.out = out;
+	rows.width = width;
+	rows.height = height;
+	rows.bpp = bpp;
+	rows.blocksX = (width + 3) / 4;
+	rows.blockBytes = block->bitlength / 8;
+	blocksY = (height + 3) / 4;
+	if ((size_t)rows.blocksX * blocksY * rows.blockBytes > datasize)
+		return false;
+	ParallelRows(blocksY, (size_t)width * height, &rows, BlockDecode_Rows);
+	return true;
+}
+
+/*
+==========================================================================================
+
+  PVRTC
+
+==========================================================================================
+*/
+
+// unpacked PVRTC word, colors are kept in 5554 precision
+typedef struct
+{
+	int       colorA[4];
+	int       colorB[4];
+	int       mode;      // modulation mode (2bpp: 0 - direct, 1 - 4-way, 2 - horizontal, 3 - vertical)
+}PVRTCWord;
+
+typedef struct
+{
+	byte      *data;
+	PVRTCWord *words;
+	byte      *mod;        // per-pixel modulation (4bpp: weight, +10 for punch-through, 2bpp: stored value)
+	byte      *out;
+	int        width;
+	int        height;
+	int        trueWidth;
+	int        trueHeight;
+	int        wordWidth;
+	int        wordsX;
+	int        wordsY;
+	bool       do2bit;
+}PVRTCRows;
+
+static const int blockdecode_pvrtcRepVals[4] = { 0, 3, 5, 8 };
+
+// words are stored in morton order
+unsigned int BlockDecode_TwiddleUV(unsigned int xSize, unsigned int ySize, unsigned int xPos, unsigned int yPos)
+{
+	unsigned int minDimension, maxValue, twiddled, srcBit, dstBit;
+	int shift;
+
+	minDimension = xSize;
+	maxValue = yPos;
+	if (ySize < xSize)
+	{
+		minDimension = ySize;
+		maxValue = xPos;
+	}
+	twiddled = 0;
+	shift = 0;
+	for (srcBit = 1, dstBit = 1; srcBit < minDimension; srcBit <<= 1, dstBit <<= 2, shift++)
+	{
+		if (yPos & srcBit)
+			twiddled |= dstBit;
+		if (xPos & srcBit)
+			twiddled |= (dstBit << 1);
+	}
+	return twiddled | ((maxValue >> shift) << (2 * shift));
+}
+
+void BlockDecode_PVRTCColors(unsigned int color, PVRTCWord *word)
+{
+	// color A: opaque RGB554, translucent ARGB3443
+	if (color & 0x8000)
+	{
+		word->colorA[0] = (color & 0x7c00) >> 10;
+		word->colorA[1] = (color & 0x3e0) >> 5;
+		word->colorA[2] = (color & 0x1e) | ((color & 0x1e) >> 4);
+		word->colorA[3] = 0xf;
+	}
+	else
+	{
+		word->colorA[0] = ((color & 0xf00) >> 7) | ((color & 0xf00) >> 11);
+		word->colorA[1] = ((color & 0xf0) >> 3) | ((color & 0xf0) >> 7);
+		word->colorA[2] = ((color & 0xe) << 1) | ((color & 0xe) >> 2);
+		word->colorA[3] = (color & 0x7000) >> 11;
+	}
+	// color B: opaque RGB555, translucent ARGB3444
+	if (color & 0x80000000)
+	{
+		word->colorB[0] = (color & 0x7c000000) >> 26;
+		word->colorB[1] = (color & 0x3e00000) >> 21;
+		word->colorB[2] = (color & 0x1f0000) >> 16;
+		word->colorB[3] = 0xf;
+	}
+	else
+	{
+		word->colorB[0] = ((color & 0xf000000) >> 23) | ((color & 0xf000000) >> 27);
+		word->colorB[1] = ((color & 0xf00000) >> 19) | ((color & 0xf00000) >> 23);
+		word->colorB[2] = ((color & 0xf0000) >> 15) | ((color & 0xf0000) >> 19);
+		word->colorB[3] = (color & 0x70000000) >> 27;
+	}
+}
+
+// unpack colors and modulation of word rows
+void BlockDecode_PVRTCWordRows(void *data, int yFirst, int yLast)
+{
+	PVRTCRows *rows = (PVRTCRows *)data;
+	unsigned int *src, bits, color;
+	PVRTCWord *word;
+	byte *mod;
+	int wx, wy, x, y, v, pitch;
+
+	pitch = rows->trueWidth;
+	for (wy = yFirst; wy < yLast; wy++)
+	{
+		for (wx = 0; wx < rows->wordsX; wx++)
+		{
+			src = (unsigned int *)rows->data + BlockDecode_TwiddleUV(rows->wordsX, rows->wordsY, wx, wy) * 2;
+			bits = src[0];
+			color = src[1];
+			word = &rows->words[wy * rows->wordsX + wx];
+			BlockDecode_PVRTCColors(color, word);
+			word->mode = color & 1;
+			mod = rows->mod + (size_t)wy * 4 * pitch + wx * rows->wordWidth;
+			if (!rows->do2bit)
+			{
+				// 4bpp: 0, 3/8, 5/8, 1 or 0, 1/2, 1/2 (punch-through), 1
+				for (y = 0; y < 4; y++, mod += pitch)
+				{
+					for (x = 0; x < 4; x++, bits >>= 2)
+					{
+						v = bits & 3;
+						if (word->mode)
+							mod[x] = (v == 1) ? 4 : ((v == 2) ? 14 : ((v == 3) ? 8 : 0));
+						else
+							mod[x] = (v == 3) ? 8 : ((v == 2) ? 5 : v * 3);
+					}
+				}
+				continue;
+			}
+			// 2bpp: 1 bit for every pixel
+			if (!word->mode)
+			{
+				for (y = 0; y < 4; y++, mod += pitch)
+					for (x = 0; x < 8; x++, bits >>= 1)
+						mod[x] = (bits & 1) ? 3 : 0;
+				continue;
+			}
+			// 2bpp: 2 bits for every second pixel, others are interpolated
+			if (bits & 1)
+			{
+				word->mode = (bits & (1 << 20)) ? 3 : 2;
+				if (bits & (1 << 21))
+					bits |= (1 << 20);
+				else
+					bits &= ~(1 << 20);
+			}
+			if (bits & 2)
+				bits |= 1;
+			else
+				bits &= ~1;
+			for (y = 0; y < 4; y++, mod += pitch)
+			{
+				for (x = 0; x < 8; x++)
+				{
+					mod[x] = 0;
+					if (((x ^ y) & 1) == 0)
+					{
+						mod[x] = bits & 3;
+						bits >>= 2;
+					}
+				}
+			}
+		}
+	}
+}
+
+// bilinear colors and modulation of pixel rows
+void BlockDecode_PVRTCPixelRows(void *data, int yFirst, int yLast)
+{
+	PVRTCRows *rows = (PVRTCRows *)data;
+	PVRTCWord *p, *q, *r, *s, *own;
+	int x, y, gx, gy, wx0, wx1, wy0, wy1, fx, fy, wp, wq, wr, ws, c, m, tw, th, i;
+	int a[4], b[4];
+	byte *mod, *out;
+	bool punch;
+
+	tw = rows->trueWidth;
+	th = rows->trueHeight;
+	for (y = yFirst; y < yLast; y++)
+	{
+		gy = y + th - 2;
+		wy0 = (gy / 4) % rows->wordsY;
+		wy1 = (wy0 + 1) % rows->wordsY;
+		fy = gy % 4;
+		mod = rows->mod + (size_t)y * tw;
+		out = rows->out + (size_t)y * rows->width * 4;
+		for (x = 0; x < rows->width; x++, out += 4)
+		{
+			gx = x + tw - rows->wordWidth / 2;
+			wx0 = (gx / rows->wordWidth) % rows->wordsX;
+			wx1 = (wx0 + 1) % rows->wordsX;
+			fx = gx % rows->wordWidth;
+			p = &rows->words[wy0 * rows->wordsX + wx0];
+			q = &rows->words[wy0 * rows->wordsX + wx1];
+			r = &rows->words[wy1 * rows->wordsX + wx0];
+			s = &rows->words[wy1 * rows->wordsX + wx1];
+			wp = (rows->wordWidth - fx) * (4 - fy);
+			wq = fx * (4 - fy);
+			wr = (rows->wordWidth - fx) * fy;
+			ws = fx * fy;
+			for (i = 0; i < 4; i++)
+			{
+				a[i] = p->colorA[i] * wp + q->colorA[i] * wq + r->colorA[i] * wr + s->colorA[i] * ws;
+				b[i] = p->colorB[i] * wp + q->colorB[i] * wq + r->colorB[i] * wr + s->colorB[i] * ws;
+			}
+			// expand to 8 bits
+			if (rows->do2bit)
+			{
+				for (i = 0; i < 3; i++)
+				{
+					a[i] = (a[i] >> 7) + (a[i] >> 2);
+					b[i] = (b[i] >> 7) + (b[i] >> 2);
+				}
+				a[3] = (a[3] >> 5) + (a[3] >> 1);
+				b[3] = (b[3] >> 5) + (b[3] >> 1);
+			}
+			else
+			{
+				for (i = 0; i < 3; i++)
+				{
+					a[i] = (a[i] >> 6) + (a[i] >> 1);
+					b[i] = (b[i] >> 6) + (b[i] >> 1);
+				}
+				a[3] = (a[3] >> 4) + a[3];
+				b[3] = (b[3] >> 4) + b[3];
+			}
+			// modulation
+			if (!rows->do2bit)
+				m = mod[x];
+			else
+			{
+				own = &rows->words[(y / 4) * rows->wordsX + x / rows->wordWidth];
+				if (!own->mode || ((x ^ y) & 1) == 0)
+					m = blockdecode_pvrtcRepVals[mod[x]];
+				else
+				{
+					c = blockdecode_pvrtcRepVals[rows->mod[(size_t)y * tw + (x + tw - 1) % tw]] + blockdecode_pvrtcRepVals[rows->mod[(size_t)y * tw + (x + 1) % tw]];
+					i = blockdecode_pvrtcRepVals[rows->mod[(size_t)((y + th - 1) % th) * tw + x]] + blockdecode_pvrtcRepVals[rows->mod[(size_t)((y + 1) % th) * tw + x]];
+					if (own->mode == 1)
+						m = (c + i + 2) / 4;
+					else if (own->mode == 2)
+						m = (c + 1) / 2;
+					else
+						m = (i + 1) / 2;
+				}
+			}
+			punch = false;
+			if (m > 10)
+			{
+				punch = true;
+				m -= 10;
+			}
+			out[0] = (byte)((a[0] * (8 - m) + b[0] * m) / 8);
+			out[1] = (byte)((a[1] * (8 - m) + b[1] * m) / 8);
+			out[2] = (byte)((a[2] * (8 - m) + b[2] * m) / 8);
+			out[3] = punch ? 0 : (byte)((a[3] * (8 - m) + b[3] * m) / 8);
+		}
+	}
+}
+
+// decode PVRTC image to RGBA, same as PVRTDecompress does but pixel by pixel
+// and without upscaling of small images
+void BlockDecode_PVRTC(byte *data, byte *out, int width, int height, bool do2bit)
+{
+	PVRTCRows rows;
+
+	rows.data = data;
+	rows.out = out;
+	rows.width = width;
+	rows.height = height;
+	rows.do2bit = do2bit;
+	rows.wordWidth = do2bit ? 8 : 4;
+	rows.trueWidth = max(width, do2bit ? 16 : 8);
+	rows.trueHeight = max(height, 8);
+	rows.wordsX = rows.trueWidth / rows.wordWidth;
+	rows.wordsY = rows.trueHeight / 4;
+	rows.words = (PVRTCWord *)mem_alloc(sizeof(PVRTCWord) * rows.wordsX * rows.wordsY);
+	rows.mod = (byte *)mem_alloc((size_t)rows.trueWidth * rows.trueHeight);
+	ParallelRows(rows.wordsY, (size_t)rows.trueWidth * rows.trueHeight, &rows, BlockDecode_PVRTCWordRows);
+	ParallelRows(height, (size_t)width * height, &rows, BlockDecode_PVRTCPixelRows);
+	mem_free(rows.words);
+	mem_free(rows.mod);
+}
@@ -0,0 +1,13 @@
+// tex_blockdecode.h
+#ifndef H_TEX_BLOCKDECODE_H
+#define H_TEX_BLOCKDECODE_H
+
+#include "tex.h"
+
+// native block decoders
+// output is RGB/RGBA (red first), pitch is width * bpp
+bool BlockDecode_Supported(TexBlock *block);
+bool BlockDecode(TexBlock *block, byte *data, size_t datasize, byte *out, int width, int height, int bpp);
+void BlockDecode_PVRTC(byte *data, byte *out, int width, int height, bool do2bit);
+
+#endif
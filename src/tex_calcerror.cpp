@@ -105,6 +105,23 @@ void FreeErrorCalc(TexCalcErrors *calc, bool keepBitmap)
 	mem_free(calc);
 }
 
+// error calc average is a sum of per-channel mean square errors scaled by 255
+// lossless result gives 99.99 so it could be printed and sorted
+double ErrorPSNR(double average)
+{
+	double mse;
+
+	mse = average / 255.0 / 3.0;
+	if (mse <= 0)
+		return 99.99;
+	return 10.0 * log10(1.0 / mse);
+}
+
+double ErrorCalcPSNR(TexCalcErrors *calc)
+{
+	return ErrorPSNR(calc->average);
+}
+
 // TexCalcErrors
 // calculate compression error and store in image
 TexCalcErrors *TexCompressionError(TexFormat *format, LoadedImage *compressed, LoadedImage *original, TexErrorMetric metric, bool generateImage)
@@ -372,12 +389,13 @@ TexCalcErrors *TexCompressionError(char *filename, TexEncodeTask *encodetask, Te
 			Error("TexCompressionError(%s): %s\n", task.filename, task.errorMessage);
 		}
 		DecompressImage(&task); // only use first level, ignore mipmaps
-		Image_LoadFinish(task.image);
+		Image_LoadFinish(task.image, false);
 		// calc error
 		calc = TexCompressionError(task.format, task.image, encodetask->image, metric, false);
 		// cleanup
 		if (task.image != NULL)
 			Image_Delete(task.image);
+		FreeDecodeTask(&task);
 	}	
 	return calc;
 }
\ No newline at end of file
@@ -37,6 +37,8 @@ typedef struct TexCalcErrors_s
 // util
 TexCalcErrors *AllocErrorCalc();
 void FreeErrorCalc(TexCalcErrors *calc, bool keepBitmap = false);
+double ErrorPSNR(double average);
+double ErrorCalcPSNR(TexCalcErrors *calc);
 
 // generic
 TexCalcErrors *TexCompressionError(TexFormat *format, LoadedImage *compressed, LoadedImage *original, TexErrorMetric metric, bool generateImage);
@@ -17,41 +17,123 @@
 ==========================================================================================
 */
 
-typedef struct
+// sRGB conversion tables, same formula as ImageData_ConvertSRGB
+byte preprocess_toSRGB[256];
+byte preprocess_toLinear[256];
+
+void TexCompress_Init(void)
 {
-	bool   BinaryAlpha;
-	bool   ConvertTosRGB;
-	bool   ConvertToLinear;
-	bool   SwapColors;
-	void (*ColorSwizzle)(byte *data, int width, int height, int pitch, int bpp, bool rgbSwap, bool sRGB, bool decode);
-} MapProcessParms;
-
-void PreprocessMap(ImageMap *map, MapProcessParms *parms, int bpp, bool rgbSwap)
+	for (int i = 0; i < 256; i++)
+	{
+		preprocess_toSRGB[i] = (byte)floor(linear_to_srgb((float)i / 255.0f) * 255.0f + 0.5f);
+		preprocess_toLinear[i] = (byte)floor(srgb_to_linear((float)i / 255.0f) * 255.0f + 0.5f);
+	}
+}
+
+// conversions needed to turn image data into tool input
+void PreprocessParms(TexEncodeTask *task, bool sRGB, MapProcessParms *parms)
+{
+	LoadedImage *image = task->image;
+
+	memset(parms, 0, sizeof(MapProcessParms));
+	parms->ConvertTosRGB = (image->sRGB != sRGB && sRGB == true);
+	parms->ConvertToLinear = (image->sRGB != sRGB && sRGB == false);
+	parms->BinaryAlpha = (task->format->features & FF_PUNCH_THROUGH_ALPHA && image->hasAlpha) ? true : false;
+	parms->ColorSwizzle = task->format->colorSwizzle;
+	parms->SwapColors = ((image->colorSwap == true && !(task->tool->inputflags & (TEXINPUT_BGR|TEXINPUT_BGRA))) || (image->colorSwap == false && !(task->tool->inputflags & (TEXINPUT_RGB|TEXINPUT_RGBA)))) ? true : false;
+}
+
+// binary alpha, sRGB table and RB swap in one walk over pixels
+void PreprocessPixels(byte *data, size_t pixels, int bpp, bool binaryAlpha, byte *table, bool swap)
 {
-	if (parms->BinaryAlpha)
+	byte *in, *end, saved;
+
+	in = data;
+	end = in + pixels * bpp;
+	while(in < end)
 	{
-		byte *in = map->data;
-		byte *end = in + map->width * map->height * bpp;
-		while(in < end)
-		{
+		if (binaryAlpha)
 			in[3] = (in[3] < tex_binaryAlphaCenter) ? 0 : 255;
-			in += bpp;
+		if (table)
+		{
+			in[0] = table[in[0]];
+			in[1] = table[in[1]];
+			in[2] = table[in[2]];
 		}
+		if (swap)
+		{
+			saved = in[0];
+			in[0] = in[2];
+			in[2] = saved;
+		}
+		in += bpp;
 	}
+}
+
+// apply conversions to map, returns number of passes made over map data
+// fused mode processes map in strips small enough to stay in cache, each strip goes through all steps
+// otherwise each step is a separate pass over the whole map
+int PreprocessMap(ImageMap *map, MapProcessParms *parms, int bpp, bool rgbSwap, bool fused)
+{
+	int y, rows, strip, passes, pitch;
+	bool sRGB, pixelSwap;
+	byte *data, *table;
+
+	sRGB = map->sRGB;
 	if (parms->ConvertTosRGB)
+		sRGB = true;
+	if (parms->ConvertToLinear)
+		sRGB = false;
+	table = parms->ConvertTosRGB ? preprocess_toSRGB : (parms->ConvertToLinear ? preprocess_toLinear : NULL);
+	pitch = map->width*bpp;
+
+	// sequential passes
+	if (!fused)
 	{
-		ImageData_ConvertSRGB(map->data, map->width, map->height, map->width*bpp, bpp, false, true);
-		map->sRGB = true;
+		passes = 0;
+		if (parms->BinaryAlpha)
+		{
+			PreprocessPixels(map->data, map->width * map->height, bpp, true, NULL, false);
+			passes++;
+		}
+		if (parms->ConvertTosRGB || parms->ConvertToLinear)
+		{
+			ImageData_ConvertSRGB(map->data, map->width, map->height, pitch, bpp, map->sRGB, sRGB);
+			passes++;
+		}
+		map->sRGB = sRGB;
+		if (parms->ColorSwizzle)
+		{
+			parms->ColorSwizzle(map->data, map->width, map->height, pitch, bpp, rgbSwap, map->sRGB, false);
+			passes++;
+		}
+		if (parms->SwapColors)
+		{
+			ImageData_SwapRB(map->data, map->width, map->height, pitch, bpp);
+			passes++;
+		}
+		return passes;
 	}
-	if (parms->ConvertToLinear)
+
+	// fused strips
+	map->sRGB = sRGB;
+	if (!parms->BinaryAlpha && !table && !parms->ColorSwizzle && !parms->SwapColors)
+		return 0;
+	// swap is done per pixel unless swizzle comes in between
+	pixelSwap = (parms->SwapColors && !parms->ColorSwizzle && (parms->BinaryAlpha || table)) ? true : false;
+	strip = max(1, PREPROCESS_STRIP_BYTES / pitch);
+	for (y = 0; y < map->height; y += strip)
 	{
-		ImageData_ConvertSRGB(map->data, map->width, map->height, map->width*bpp, bpp, true, false);
-		map->sRGB = false;
+		rows = min(strip, map->height - y);
+		data = map->data + y*pitch;
+		if (parms->BinaryAlpha || table)
+			PreprocessPixels(data, map->width * rows, bpp, parms->BinaryAlpha, table, pixelSwap);
+		if (parms->ColorSwizzle)
+			parms->ColorSwizzle(data, map->width, rows, pitch, bpp, rgbSwap, sRGB, false);
+		if (parms->SwapColors && !pixelSwap)
+			ImageData_SwapRB(data, map->width, rows, pitch, bpp);
 	}
-	if (parms->ColorSwizzle)
-		parms->ColorSwizzle(map->data, map->width, map->height, map->width*bpp, bpp, rgbSwap, map->sRGB, false);
-	if (parms->SwapColors)
-		ImageData_SwapRB(map->data, map->width, map->height, map->width*bpp, bpp);
+	return 1;
 }
 
 void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
@@ -61,6 +143,7 @@ void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
 	int s, w, h, l, pitch, y;
 	bool data_allocated, any_conversions, mipLevels;
 	MapProcessParms conversions = { 0 };
+	FREE_IMAGE_FILTER filter;
 	FIBITMAP *mipbitmap;
 
 	// cleanup
@@ -69,11 +152,8 @@ void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
 
 	// conversions needed
 	mipLevels = (!tex_noMipmaps && !FS_FileMatchList(task->file, image, tex_noMipFiles.items) && !(task->format->features & FF_NOMIP)) ? true : false;
-	conversions.ConvertTosRGB = (image->sRGB != sRGB && sRGB == true);
-	conversions.ConvertToLinear = (image->sRGB != sRGB && sRGB == false);
-	conversions.BinaryAlpha = (task->format->features & FF_PUNCH_THROUGH_ALPHA && image->hasAlpha) ? true : false;
-	conversions.ColorSwizzle = task->format->colorSwizzle;
-	conversions.SwapColors = ((image->colorSwap == true && !(task->tool->inputflags & (TEXINPUT_BGR|TEXINPUT_BGRA))) || (image->colorSwap == false && !(task->tool->inputflags & (TEXINPUT_RGB|TEXINPUT_RGBA)))) ? true : false;
+	PreprocessParms(task, sRGB, &conversions);
+	task->preprocessPasses = 0;
 	any_conversions = (conversions.BinaryAlpha || conversions.ConvertTosRGB || conversions.ConvertToLinear || conversions.SwapColors || conversions.ColorSwizzle != NULL) ? true : false;
 
 	// create base map
@@ -81,15 +161,17 @@ void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
 	map->width = image->width;
 	map->height = image->height;
 	map->data = Image_GetUnalignedData(image, &map->datasize, &data_allocated, any_conversions );
-	map->sRGB = sRGB;
-	PreprocessMap(map, &conversions, image->bpp, image->colorSwap);
+	map->sRGB = image->sRGB;
+	task->preprocessPasses += PreprocessMap(map, &conversions, image->bpp, image->colorSwap, true);
 	if (data_allocated == false)
 		map->external = true;
 	image->maps = map;
 
 	// create miplevels
+	// solid color image does not need expensive filter
 	if (mipLevels)
 	{
+		filter = TexFastPath_IsConstant(image) ? FILTER_BOX : FILTER_LANCZOS3;
 		s = min(image->width, image->height);
 		w = image->width;
 		h = image->height;
@@ -107,9 +189,9 @@ void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
 			map->height = h;
 			map->datasize = map->width*map->height*image->bpp;
 			map->data = (byte *)mem_alloc(map->datasize);
-			map->sRGB = sRGB;
+			map->sRGB = image->sRGB;
 			// create mip
-			mipbitmap = fiRescale(image->bitmap, w, h, FILTER_LANCZOS3, false);
+			mipbitmap = fiRescale(image->bitmap, w, h, filter, false);
 			byte *in = fiGetData(mipbitmap, &pitch);
 			byte *out = map->data;
 			for (y = 0; y < h; y++)
@@ -120,7 +202,7 @@ void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
 			}
 			if (mipbitmap != image->bitmap)
 				fiFree(mipbitmap);
-			PreprocessMap(map, &conversions, image->bpp, image->colorSwap);
+			task->preprocessPasses += PreprocessMap(map, &conversions, image->bpp, image->colorSwap, true);
 		}
 	}
 }
@@ -128,50 +210,106 @@ void GenerateMipMaps(TexEncodeTask *task, bool sRGB)
 /*
 ==========================================================================================
 
-Writing statistics
+  Memory budget
 
 ==========================================================================================
 */
 
-void InitStats()
+// largest texture stream codec (or it's fallback) could produce for image dimensions
+size_t EstimateStreamSize(TexCodec *codec, LoadedImage *dims)
 {
-	FILE *f;
-	f = SafeOpenWrite(tex_statsFile);
-	SafePuts(f, "FileName;Event;ImageType;Format;Block;AverageError;Dispersion;RootMeanSquare;\n");
-	fclose(f);
+	TexCodec *codecs[2] = { codec, codec->fallback };
+	size_t size, best = 0;
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (!codecs[i])
+			continue;
+		for (vector<TexFormat*>::iterator fmt = codecs[i]->formats.begin(); fmt < codecs[i]->formats.end(); fmt++)
+		{
+			size = tex_container->headerSize + compressedTextureSize(dims, *fmt, tex_container, true, false);
+			best = max(best, size);
+		}
+	}
+	return best;
 }
 
-void WriteStats(char *outfile, char *event, TexEncodeTask *task, TexCalcErrors *calc)
+// images that cannot be probed are assumed to be square with this many pixels per byte of file,
+// so formats packing 32-bit pixels up to 16:1 are not underestimated
+#define ESTIMATE_UNPROBED_PIXELS_PER_BYTE 4
+
+// estimate peak memory footprint of a work item by it's dimensions and pipeline settings
+// (decoded source + scaled copy + mip chain + output stream + error buffers)
+size_t TexCompress_EstimateMemory(FS_File *file)
 {
-	char buf[8192], num[128];
-
-	FILE *f;
-	f = SafeOpen(tex_statsFile, "a");
-	sprintf_s(buf, sizeof(buf), "\"%s\";\"%s\";\"%s\";\"%s\";\"%s\";", outfile, event,
-		task->image != NULL ? OptionEnumName((int)task->image->datatype, ImageTypes, "unknown", "bad") : "",
-		(task != NULL && task->format != NULL) ? task->format->name : "", (task != NULL && task->format != NULL) ? task->format->block->name : "");
-	// error calc
-	if (calc != NULL)
-	{
-		// average
-		sprintf_s(num, sizeof(num), "%f", calc->average);
-		Conv(num, '.', ',');
-		strcat_s(buf, sizeof(buf), num);
-		strcat_s(buf, sizeof(buf), ";");
-		// dispersion
-		sprintf_s(num, sizeof(num), "%f", calc->dispersion);
-		Conv(num, '.', ',');
-		strcat_s(buf, sizeof(buf), num);
-		strcat_s(buf, sizeof(buf), ";");
-		// rms
-		sprintf_s(num, sizeof(num), "%f", calc->rms);
-		Conv(num, '.', ',');
-		strcat_s(buf, sizeof(buf), num);
-		strcat_s(buf, sizeof(buf), ";");
-	}
-	SafePuts(f, buf);
-	SafePuts(f, "\n");
-	fclose(f);
+	LoadedImage dims;
+	size_t source, scaled, stream, errors, filesize;
+	int width, height, scale;
+
+	width = file->width;
+	height = file->height;
+	if (width <= 0 || height <= 0)
+	{
+		filesize = FS_FileSize(file);
+		if (!filesize)
+			return 0;
+		width = height = (int)ceil(sqrt((double)filesize * ESTIMATE_UNPROBED_PIXELS_PER_BYTE));
+	}
+
+	// decoded source
+	source = (size_t)width*height*4;
+
+	// scaled copy, scalers keep source and destination bitmaps
+	scale = 1;
+	if (FS_FileMatchList(file, tex_scale4xFiles.items) || tex_forceScale4x)
+		scale = 4;
+	else if (FS_FileMatchList(file, tex_scale2xFiles.items) || tex_forceScale2x)
+		scale = 2;
+	memset(&dims, 0, sizeof(dims));
+	dims.width = width*scale;
+	dims.height = height*scale;
+	if (!tex_allowNPOT)
+	{
+		dims.width = NextPowerOfTwo(dims.width);
+		dims.height = NextPowerOfTwo(dims.height);
+	}
+	scaled = (size_t)dims.width*dims.height*4;
+	if (scale > 1)
+	{
+		scaled *= 2;
+		// super2x/sbrz go through 4x intermediate and backscale
+		if (tex_firstScaler == IMAGE_SCALER_SUPER2X || tex_firstScaler == IMAGE_SCALER_SBRZ || tex_secondScaler == IMAGE_SCALER_SUPER2X || tex_secondScaler == IMAGE_SCALER_SBRZ)
+			scaled += (size_t)dims.width*dims.height*4*4;
+		// super2x fixes transparent pixels with jump flood, two int seed buffers
+		if (tex_firstScaler == IMAGE_SCALER_SUPER2X || tex_secondScaler == IMAGE_SCALER_SUPER2X)
+			scaled += (size_t)dims.width*dims.height*sizeof(int)*2;
+	}
+
+	// mip chain is a copy of base image plus 1/3 for levels
+	if (!tex_noMipmaps)
+		scaled += (size_t)dims.width*dims.height*4*4/3;
+
+	// output stream of biggest active codec
+	stream = 0;
+	for (TexCodec *codec = tex_active_codecs; codec; codec = codec->nextActive)
+		stream = max(stream, EstimateStreamSize(codec, &dims));
+	if (!tex_noMipmaps)
+		stream = stream*4/3;
+	// best stream is kept while other tools and formats are tried
+	if (CompressTargetEnabled() && tex_targetEscalate != ESCALATE_PROFILE)
+		stream *= 2;
+
+	// error control decodes compressed image and compares against original
+	errors = 0;
+	if (tex_statsFile[0] || tex_testCompresion || CompressTargetEnabled())
+		errors = (size_t)dims.width*dims.height*4*2;
+	else
+	{
+		for (TexCodec *codec = tex_active_codecs; codec; codec = codec->nextActive)
+			if (codec->discardList.errorControl)
+				errors = (size_t)dims.width*dims.height*4*2;
+	}
+	return source + scaled + stream + errors;
 }
 
 /*
@@ -184,9 +322,8 @@ void WriteStats(char *outfile, char *event, TexEncodeTask *task, TexCalcErrors *
 
 void Compress(TexEncodeTask *task)
 {
-	bool sRGB, powerOfTwo, squareSize;
-
 	// force tool
+	task->toolSelect = NULL;
 	if (task->codec->forceTool)
 		task->tool = task->codec->forceTool;
 	else
@@ -200,6 +337,7 @@ void Compress(TexEncodeTask *task)
 			}
 		}
 	}
+	task->toolForced = (task->tool != NULL);
 
 	// force format
 	if (task->codec->forceFormat)
@@ -216,6 +354,15 @@ void Compress(TexEncodeTask *task)
 		}
 	}
 
+	task->formatForced = (task->format != NULL);
+
+	// pick format by quality target
+	if (!task->format && tex_autoFormat && CompressTargetEnabled(task))
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_SAMPLE), &task->times[TEX_STAGE_SAMPLE], task->file->name.c_str());
+		TexSample_SelectFormat(task);
+	}
+
 	// run codec (select tool and format)
 	if (task->codec->fEncode)
 		task->codec->fEncode(task);
@@ -226,7 +373,32 @@ void Compress(TexEncodeTask *task)
 	if (!task->tool)
 		Error("%s: uninitialized texture tool for image '%s", task->codec->name, task->file->fullpath.c_str());
 
-	// determine if we should to compress as sRGB
+	// tool tournament
+	if (tex_tournament && !task->toolForced)
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_SAMPLE), &task->times[TEX_STAGE_SAMPLE], task->file->name.c_str());
+		TexSample_Tournament(task);
+	}
+
+	// error control on sampled blocks, no need to encode texture that is going to be discarded
+	if (task->prescreen == PRESCREEN_PENDING)
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_SAMPLE), &task->times[TEX_STAGE_SAMPLE], task->file->name.c_str());
+		task->prescreen = TexSample_Prescreen(task);
+		if (task->prescreen == PRESCREEN_REJECT)
+			return;
+	}
+
+	// run
+	CompressPrepare(task);
+	CompressStream(task);
+}
+
+// determine if we should to compress as sRGB
+bool CompressSRGB(TexEncodeTask *task)
+{
+	bool sRGB;
+
 	sRGB = false;
 	if (tex_sRGB_allow && (task->format->features & (FF_SRGB|FF_SWIZZLE_INTERNAL_SRGB)))
 	{
@@ -238,9 +410,12 @@ void Compress(TexEncodeTask *task)
 			sRGB = ImageData_ProbeLinearToSRGB_16bit(data, task->image->width, task->image->height, pitch, task->image->bpp, task->image->colorSwap);
 		}
 	}
-	Verbose("Compressing %s as %s:%s (%s%s/%s)\n", task->file->fullpath.c_str(), task->tool->name, task->format->name, (sRGB == true) ? "sRGB_" : "", task->format->block->name, OptionEnumName(tex_profile, tex_profiles));
+	return sRGB;
+}
 
-	// prepare image for tool/format
+// bpp of image data tool and format takes
+int CompressInputBPP(TexEncodeTask *task)
+{
 	int dest_bpp = task->image->bpp;
 	if (!(task->tool->inputflags & (TEXINPUT_BGR|TEXINPUT_RGB)))
 		dest_bpp = 4;
@@ -248,21 +423,82 @@ void Compress(TexEncodeTask *task)
 		dest_bpp = 3;
 	if (task->format->features & FF_SWIZZLE_RESERVED_ALPHA)
 		dest_bpp = 4;
-	Image_ConvertBPP(task->image, dest_bpp);
+	return dest_bpp;
+}
+
+// prepare image for selected tool and format (convert, scale, make dimensions and mipmaps)
+void CompressPrepare(TexEncodeTask *task)
+{
+	bool sRGB, powerOfTwo, squareSize;
+	ImageScaler firstScaler, secondScaler;
+	const char *name;
+	double mpix;
+
+	sRGB = CompressSRGB(task);
+	Verbose("Compressing %s as %s:%s (%s%s/%s)\n", task->file->fullpath.c_str(), task->tool->name, task->format->name, (sRGB == true) ? "sRGB_" : "", task->format->block->name, OptionEnumName(task->profile, tex_profiles));
+
+	// prepare image for tool/format
+	name = task->file->name.c_str();
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_CONVERT), &task->times[TEX_STAGE_CONVERT], name);
+		Image_ConvertBPP(task->image, CompressInputBPP(task));
+	}
 
 	// apply scalers
 	powerOfTwo = (tex_allowNPOT && !(task->format->features & FF_POT)) ? false : true;
+	firstScaler = tex_firstScaler;
+	secondScaler = tex_secondScaler;
+	if (TexFastPath_IsConstant(task->image))
+		firstScaler = secondScaler = IMAGE_SCALER_BOX;
+	mpix = (double)task->image->width * task->image->height / 1000000.0;
 	if (FS_FileMatchList(task->file, task->image, tex_scale4xFiles.items) || tex_forceScale4x)
-		Image_ScaleBy4(task->image, tex_firstScaler, tex_secondScaler, powerOfTwo);
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_SCALE), &task->times[TEX_STAGE_SCALE], name);
+		Image_ScaleBy4(task->image, firstScaler, secondScaler, powerOfTwo);
+		TexSchedule_RecordScale(firstScaler, secondScaler, 4, mpix, timer.Elapsed());
+	}
 	else if (FS_FileMatchList(task->file, task->image, tex_scale2xFiles.items) || tex_forceScale2x)
-		Image_ScaleBy2(task->image, tex_firstScaler, powerOfTwo);
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_SCALE), &task->times[TEX_STAGE_SCALE], name);
+		Image_ScaleBy2(task->image, firstScaler, powerOfTwo);
+		TexSchedule_RecordScale(firstScaler, firstScaler, 2, mpix, timer.Elapsed());
+	}
 
 	// apply dimensions
 	squareSize = (task->format->features & FF_SQUARE) ? true : false;
-	Image_MakeDimensions(task->image, powerOfTwo, squareSize);
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_DIMENSIONS), &task->times[TEX_STAGE_DIMENSIONS], name);
+		Image_MakeDimensions(task->image, powerOfTwo, squareSize);
+	}
 
 	// generate mipmaps
-	GenerateMipMaps(task, sRGB);
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_MIPMAPS), &task->times[TEX_STAGE_MIPMAPS], name);
+		GenerateMipMaps(task, sRGB);
+	}
+}
+
+// redo conversion and mipmaps of already prepared image for other tool or format
+// scaling and dimensions are kept, so format should have same FF_POT and FF_SQUARE
+void CompressPrepareMaps(TexEncodeTask *task)
+{
+	const char *name = task->file->name.c_str();
+	bool sRGB = CompressSRGB(task);
+
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_CONVERT), &task->times[TEX_STAGE_CONVERT], name);
+		Image_ConvertBPP(task->image, CompressInputBPP(task));
+	}
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_MIPMAPS), &task->times[TEX_STAGE_MIPMAPS], name);
+		GenerateMipMaps(task, sRGB);
+	}
+}
+
+// run tool on prepared image, allocates stream (header and compressed data)
+void CompressStream(TexEncodeTask *task)
+{
+	const char *name = task->file->name.c_str();
 
 	// allocate memory for destination file
 	size_t headersize;
@@ -274,8 +510,273 @@ void Compress(TexEncodeTask *task)
 	mem_free(header);
 
 	// compress
-	task->tool->fCompress(task);
-	task->stream = stream;
+	// solid color and tiny textures are encoded directly and dont count in tool costs
+	{
+		TraceScope timer(TexStats_StageName(TEX_STAGE_COMPRESS), &task->times[TEX_STAGE_COMPRESS], name);
+		task->fastpath = TexFastPath_Compress(task);
+		if (!task->fastpath)
+			task->tool->fCompress(task);
+		task->stream = stream;
+		// container post-processing (level headers, supercompression, .crn) counts as encoding
+		if (task->container->fPackStream)
+			task->container->fPackStream(task);
+		if (!task->fastpath)
+			TexSchedule_RecordEncode(task, timer.Elapsed());
+	}
+}
+
+// per-texture quality target
+bool CompressTargetEnabled(void)
+{
+	if (tex_targetPSNR > 0 || tex_targetRMS > 0)
+		return true;
+	for (vector<TexTargetRule*>::iterator i = tex_targetRules.begin(); i < tex_targetRules.end(); i++)
+		if ((*i)->value > 0)
+			return true;
+	return false;
+}
+
+bool CompressTargetEnabled(TexEncodeTask *task)
+{
+	return (task->targetPSNR > 0 || task->targetRMS > 0);
+}
+
+// global target, first matching rule of each metric overrides it
+void CompressTargetSet(TexEncodeTask *task)
+{
+	bool psnrSet = false, rmsSet = false;
+
+	task->targetPSNR = tex_targetPSNR;
+	task->targetRMS = tex_targetRMS;
+	for (vector<TexTargetRule*>::iterator i = tex_targetRules.begin(); i < tex_targetRules.end(); i++)
+	{
+		if ((*i)->rms ? rmsSet : psnrSet)
+			continue;
+		if (!FS_FileMatchList(task->file, task->image, (*i)->files.items))
+			continue;
+		if ((*i)->rms)
+		{
+			task->targetRMS = (*i)->value;
+			rmsSet = true;
+		}
+		else
+		{
+			task->targetPSNR = (*i)->value;
+			psnrSet = true;
+		}
+	}
+}
+
+bool CompressTargetMet(TexEncodeTask *task, TexCalcErrors *calc)
+{
+	if (task->targetRMS > 0 && calc->rms > task->targetRMS)
+		return false;
+	if (task->targetPSNR > 0 && ErrorCalcPSNR(calc) < task->targetPSNR)
+		return false;
+	return true;
+}
+
+// rule for [targetpsnr:X] or [targetrms:X] group
+TexTargetRule *CompressTargetRule(const char *group)
+{
+	TexTargetRule *rule;
+	double value;
+	bool rms;
+
+	rms = strnicmp(group, "targetrms:", 10) ? false : true;
+	value = max(0.0, atof(group + (rms ? 10 : 11)));
+	for (vector<TexTargetRule*>::iterator i = tex_targetRules.begin(); i < tex_targetRules.end(); i++)
+		if ((*i)->rms == rms && (*i)->value == value)
+			return *i;
+	rule = new TexTargetRule();
+	rule->rms = rms;
+	rule->value = value;
+	tex_targetRules.push_back(rule);
+	return rule;
+}
+
+TexCalcErrors *CompressMeasure(TexEncodeTask *task, char *outfile)
+{
+	TraceScope timer(TexStats_StageName(TEX_STAGE_ERRORCALC), &task->times[TEX_STAGE_ERRORCALC], task->file->name.c_str());
+	return TexCompressionError(outfile, task, ERRORMETRIC_AUTO);
+}
+
+bool CompareTargetBPP(const TexSampleResult &a, const TexSampleResult &b)
+{
+	return a.bpp < b.bpp;
+}
+
+// tools and formats tried when slowest profile misses quality target, smallest first
+// formats are only those of same codec that keep image dimensions
+void CompressTargetCandidates(TexEncodeTask *task, vector<TexSampleResult> &candidates)
+{
+	vector<TexFormat*> formats;
+	vector<TexSampleResult>::iterator c;
+	TexSampleResult candidate;
+	TexEncodeTask select;
+
+	formats.push_back(task->format);
+	if (tex_targetEscalate >= ESCALATE_FORMAT && !task->formatForced)
+	{
+		for (vector<TexFormat*>::iterator f = task->codec->formats.begin(); f < task->codec->formats.end(); f++)
+		{
+			if ((*f)->colorSwizzle || ((*f)->features & (FF_POT|FF_SQUARE)) != (task->format->features & (FF_POT|FF_SQUARE)))
+				continue;
+			select = *task;
+			select.format = *f;
+			task->codec->fEncode(&select);
+			if (!select.format || find(formats.begin(), formats.end(), select.format) != formats.end())
+				continue;
+			if (select.format->block->bitlength * task->format->block->width * task->format->block->height <= task->format->block->bitlength * select.format->block->width * select.format->block->height)
+				continue;
+			if (task->image->hasAlpha && (!(select.format->features & FF_ALPHA) || (task->image->hasGradientAlpha && (select.format->features & FF_PUNCH_THROUGH_ALPHA))))
+				continue;
+			formats.push_back(select.format);
+		}
+	}
+	for (vector<TexFormat*>::iterator f = formats.begin(); f < formats.end(); f++)
+	{
+		for (vector<TexTool*>::iterator t = task->codec->tools.begin(); t < task->codec->tools.end(); t++)
+		{
+			if (!(*t)->fCompress || find((*t)->formats.begin(), (*t)->formats.end(), *f) == (*t)->formats.end())
+				continue;
+			if ((*f == task->format && *t == task->tool) || (task->toolForced && *t != task->tool))
+				continue;
+			// candidates share image, converting it to rgb would lose alpha for next ones
+			select = *task;
+			select.format = *f;
+			select.tool = *t;
+			if (task->image->hasAlpha && CompressInputBPP(&select) < 4)
+				continue;
+			memset(&candidate, 0, sizeof(candidate));
+			candidate.format = *f;
+			candidate.tool = *t;
+			candidate.bpp = (double)(*f)->block->bitlength / ((*f)->block->width * (*f)->block->height);
+			candidates.push_back(candidate);
+		}
+	}
+	stable_sort(candidates.begin(), candidates.end(), CompareTargetBPP);
+}
+
+// texture is encoded with fastest profile first, measured and re-encoded with slower profiles
+// until quality target is met or maxprofile is reached, then other tools and bigger formats
+// are tried if -targetescalate allows, returns errors of final stream
+TexCalcErrors *CompressToTarget(TexEncodeTask *task, char *outfile, texprofile maxprofile)
+{
+	vector<TexSampleResult> candidates;
+	TexCalcErrors *calc, *best;
+	TexFormat *bestFormat;
+	TexTool *bestTool;
+	const char *bestSelect;
+	byte *bestStream;
+	size_t bestLen;
+
+	// slower profiles
+	while(1)
+	{
+		calc = CompressMeasure(task, outfile);
+		if (!calc || task->fastpath || CompressTargetMet(task, calc))
+			return calc;
+		if (task->profile >= maxprofile)
+			break;
+		Verbose("%s: missed quality target with %s profile (psnr %.2f, rms %.2f)\n", outfile, OptionEnumName(task->profile, tex_profiles), ErrorCalcPSNR(calc), calc->rms);
+		FreeErrorCalc(calc);
+		mem_free(task->stream);
+		task->stream = NULL;
+		task->streamLen = 0;
+		task->profile = (texprofile)(task->profile + 1);
+		CompressStream(task);
+	}
+	if (tex_targetEscalate == ESCALATE_PROFILE)
+		return calc;
+
+	// other tools and formats with final profile, best looking one is kept
+	CompressTargetCandidates(task, candidates);
+	best = calc;
+	bestFormat = task->format;
+	bestTool = task->tool;
+	bestSelect = task->toolSelect;
+	bestStream = task->stream;
+	bestLen = task->streamLen;
+	for (vector<TexSampleResult>::iterator c = candidates.begin(); c < candidates.end(); c++)
+	{
+		Verbose("%s: missed quality target with %s:%s (psnr %.2f, rms %.2f), trying %s:%s\n", outfile, bestTool->name, bestFormat->name, ErrorCalcPSNR(best), best->rms, c->tool->name, c->format->name);
+		task->format = c->format;
+		task->tool = c->tool;
+		task->toolSelect = "target";
+		task->stream = NULL;
+		task->streamLen = 0;
+		CompressPrepareMaps(task);
+		CompressStream(task);
+		calc = CompressMeasure(task, outfile);
+		if (!calc)
+		{
+			mem_free(task->stream);
+			continue;
+		}
+		if (ErrorCalcPSNR(calc) > ErrorCalcPSNR(best) || CompressTargetMet(task, calc))
+		{
+			FreeErrorCalc(best);
+			mem_free(bestStream);
+			best = calc;
+			bestFormat = task->format;
+			bestTool = task->tool;
+			bestSelect = task->toolSelect;
+			bestStream = task->stream;
+			bestLen = task->streamLen;
+			if (CompressTargetMet(task, best))
+				break;
+		}
+		else
+		{
+			FreeErrorCalc(calc);
+			mem_free(task->stream);
+		}
+	}
+
+	// maps were made for last tried candidate
+	if (task->format != bestFormat || task->tool != bestTool)
+	{
+		task->format = bestFormat;
+		task->tool = bestTool;
+		CompressPrepareMaps(task);
+	}
+	task->toolSelect = bestSelect;
+	task->stream = bestStream;
+	task->streamLen = bestLen;
+	return best;
+}
+
+// output file path of compressed frame
+void CompressOutputPath(TexEncodeTask *task, TexCodec *codec, char *outfile)
+{
+	char *ext;
+
+	strcpy(outfile, "");
+	sprintf(outfile, "%s%s%s%s%s", tex_generateArchive ? "" : tex_destPath,
+		(!tex_testCompresion && tex_destPathUseCodecDir) ? codec->destDir : "",
+		tex_addPath.c_str(),
+		task->file->path.c_str(),
+		task->image->useTexname ? task->image->texname : task->file->name.c_str());
+	if (tex_useSuffix & TEXSUFF_FORMAT)
+	{
+		strcat(outfile, task->format->suffix);
+		if (task->image->maps->sRGB)
+			strcat(outfile, "_sRGB");
+	}
+	if (tex_useSuffix & TEXSUFF_TOOL)
+		strcat(outfile, task->tool->suffix);
+	// requested profile, so files degraded by deadline are replaced when upgraded
+	if (tex_useSuffix & TEXSUFF_PROFILE)
+	{
+		strcat(outfile, "-");
+		strcat(outfile, OptionEnumName(tex_profile, tex_profiles));
+	}
+	ext = task->container->extensionName;
+	if (tex_testCompresion)
+		ext = "tga";
+	strcat(outfile, ".");
+	strcat(outfile, ext);
 }
 
 void TexCompress_WorkerThread(ThreadData *thread)
@@ -286,9 +787,11 @@ void TexCompress_WorkerThread(ThreadData *thread)
 	TexEncodeTask task = { 0 };
 	TexCodec *codec;
 	TexCalcErrors *calc;
-	char *ext, outfile[MAX_FPATH];
+	char outfile[MAX_FPATH];
 	int work, disabled_jumpcount;
-	bool disabled_by_error_control;
+	bool disabled_by_error_control, probed;
+	double loadtime, workstart;
+	texprofile workprofile;
 
 	SharedData = (TexCompressData *)thread->data;
 
@@ -300,24 +803,60 @@ void TexCompress_WorkerThread(ThreadData *thread)
 			break; 
 
 		memset(&task, 0, sizeof(task));
+		task.threadnum = thread->num;
 		task.file = &textures[work];
 		task.container = tex_container;
 		task.image = image;
+		loadtime = 0;
 		if (!task.container)
 			Error("TexCompress_WorkerThread: no container specified\n");
+
+		// admit work by memory budget
+		if (thread->pool->mem_budget)
+		{
+			// dimensions of images that cannot be probed are guessed from file size until image is loaded
+			probed = Image_Probe(task.file);
+			AcquireMemoryForThread(thread, TexCompress_EstimateMemory(task.file));
+			if (!probed)
+			{
+				{
+					TraceScope timer(TexStats_StageName(TEX_STAGE_LOAD), &loadtime, task.file->name.c_str());
+					Image_Load(task.file, image);
+				}
+				if (image->bitmap != NULL)
+				{
+					task.file->width = image->width;
+					task.file->height = image->height;
+				}
+				AdjustMemoryForThread(thread, TexCompress_EstimateMemory(task.file));
+			}
+		}
+
+		// pick quality profile, it may be lowered to meet deadline
+		workprofile = TexSchedule_BeginWork(task.file);
+		workstart = I_DoubleTime();
 		
 		// cycle all active codecs
 		for (codec = tex_active_codecs; codec; codec = codec->nextActive)
 		{
 			// load image
 			if (image->bitmap == NULL)
+			{
+				TraceScope timer(TexStats_StageName(TEX_STAGE_LOAD), &loadtime, task.file->name.c_str());
+				loadtime = 0;
 				Image_Load(task.file, image);
+			}
 			if (image->bitmap == NULL)
 			{
 				if (tex_statsFile[0])
-					WriteStats(outfile, "SkipNotLoaded", &task, NULL);
+					TexStats_Add(&task, NULL, "SkipNotLoaded", NULL);
 				continue;
 			}
+			if (task.file->width <= 0 || task.file->height <= 0)
+			{
+				task.file->width = image->width;
+				task.file->height = image->height;
+			}
 			
 			// check if codec accepts task
 			// discarded files get fallback codec
@@ -331,7 +870,7 @@ tryagain:
 				if (task.codec->disabled)
 				{
 					if (tex_statsFile[0])
-						WriteStats(outfile, "CodecDisabled", &task, NULL);
+						TexStats_Add(&task, NULL, "CodecDisabled", NULL);
 					continue;
 				}
 				if (!task.codec->fAccept(&task) || FS_FileMatchList(task.file, task.image, task.codec->discardList.items) || disabled_by_error_control)
@@ -340,13 +879,13 @@ tryagain:
 					if (!task.codec)
 					{
 						if (tex_statsFile[0])
-							WriteStats(outfile, "CodecNoFallback", &task, NULL);
+							TexStats_Add(&task, NULL, "CodecNoFallback", NULL);
 						continue;
 					}
 					if (task.codec->disabled)
 					{
 						if (tex_statsFile[0])
-							WriteStats(outfile, "CodecFallbackDisabled", &task, NULL);
+							TexStats_Add(&task, NULL, "CodecFallbackDisabled", NULL);
 						continue;
 					}
 				}
@@ -402,68 +941,74 @@ tryagain:
 				task.streamLen = 0;
 				task.tool = NULL;
 				task.format = NULL;
+				task.inputBytes = frame->width*frame->height*frame->bpp;
+				memset(task.times, 0, sizeof(task.times));
+				task.times[TEX_STAGE_LOAD] = loadtime;
+				// with quality target, profile is escalated from the fastest one up to work profile
+				CompressTargetSet(&task);
+				task.profile = CompressTargetEnabled(&task) ? PROFILE_FAST : workprofile;
+				// with quality target full image is measured anyway
+				task.prescreen = PRESCREEN_NONE;
+				if (tex_prescreen && codec->discardList.errorControl && !CompressTargetEnabled(&task) && disabled_jumpcount <= 16)
+					task.prescreen = PRESCREEN_PENDING;
 				Compress(&task);
 
-				// make output file path
-				strcpy(outfile, "");
-				sprintf(outfile, "%s%s%s%s%s", tex_generateArchive ? "" : tex_destPath,
-					(!tex_testCompresion && tex_destPathUseCodecDir) ? codec->destDir : "",
-					tex_addPath.c_str(),
-					task.file->path.c_str(),
-					frame->useTexname ? frame->texname : task.file->name.c_str());
-				if (tex_useSuffix & TEXSUFF_FORMAT)
+				// discarded by sampled error control, was not encoded
+				if (task.prescreen == PRESCREEN_REJECT)
 				{
-					strcat(outfile, task.format->suffix);
-					if (task.image->maps->sRGB)
-						strcat(outfile, "_sRGB");
-				}
-				if (tex_useSuffix & TEXSUFF_TOOL)
-					strcat(outfile, task.tool->suffix);
-				if (tex_useSuffix & TEXSUFF_PROFILE)
-				{
-					strcat(outfile, "-");
-					strcat(outfile, OptionEnumName(tex_profile, tex_profiles));
+					if (tex_statsFile[0])
+						TexStats_Add(&task, NULL, "CodecPrescreenDiscard", NULL);
+					disabled_jumpcount++;
+					disabled_by_error_control = true;
+					goto tryagain;
 				}
-				ext = task.container->extensionName;
-				if (tex_testCompresion)
-					ext = "tga";
-				strcat(outfile, ".");
-				strcat(outfile, ext);
+
+				// make output file path
+				CompressOutputPath(&task, codec, outfile);
 
 				// calculate compression errors
+				// quality target may change tool and format, which are in file suffix
 				calc = NULL;
-				if (tex_statsFile[0] > 0 || codec->discardList.errorControl)
+				if (CompressTargetEnabled(&task))
+				{
+					calc = CompressToTarget(&task, outfile, workprofile);
+					CompressOutputPath(&task, codec, outfile);
+				}
+				else if (tex_statsFile[0] > 0 || (codec->discardList.errorControl && task.prescreen != PRESCREEN_ACCEPT))
 				{
+					TraceScope timer(TexStats_StageName(TEX_STAGE_ERRORCALC), &task.times[TEX_STAGE_ERRORCALC], task.file->name.c_str());
 					calc = TexCompressionError(outfile, &task, ERRORMETRIC_AUTO);
-					// check if we need to discard it
-					if (codec->discardList.errorControl)
+				}
+				task.degraded = (workprofile < tex_profile && task.profile == workprofile);
+
+				// check if we need to discard it
+				if (calc && codec->discardList.errorControl)
+				{
+					if (FS_FileMatchList(task.file, task.image, calc, task.codec->discardList.items))
 					{
-						if (FS_FileMatchList(task.file, task.image, calc, task.codec->discardList.items))
+						// discard current codec
+						if (disabled_jumpcount > 16)
+							Warning("%s: cannot fallback by error control - infinite loop in codec fallback\n", outfile);
+						else
 						{
-							// discard current codec
-							if (disabled_jumpcount > 16)
-								Warning("%s: cannot fallback by error control - infinite loop in codec fallback\n", outfile);
-							else
-							{
-								if (tex_statsFile[0])
-									WriteStats(outfile, "CodecErrorControlDiscard", &task, calc);
-								mem_free(calc);
-								calc = NULL;
-								if (task.stream != NULL)
-									mem_free(task.stream);
-								task.stream = NULL;
-								task.streamLen = 0;
-								disabled_jumpcount++;
-								disabled_by_error_control = true;
-								goto tryagain;
-							}
+							if (tex_statsFile[0])
+								TexStats_Add(&task, outfile, "CodecErrorControlDiscard", calc);
+							mem_free(calc);
+							calc = NULL;
+							if (task.stream != NULL)
+								mem_free(task.stream);
+							task.stream = NULL;
+							task.streamLen = 0;
+							disabled_jumpcount++;
+							disabled_by_error_control = true;
+							goto tryagain;
 						}
 					}
 				}
 
 				// output stats
 				task.codec->stat_outputDiskMB += (float)task.streamLen / 1048576.0f;
-				task.codec->stat_outputRamMB += (float)(task.streamLen - task.container->headerSize) / 1048576.0f;
+				task.codec->stat_outputRamMB += (float)compressedTextureSize(task.image, task.format, task.container, true, true) / 1048576.0f;
 				task.codec->stat_numTextures++;
 				task.codec->stat_numImages++;
 				for (ImageMap *map = frame->maps; map; map = map->next)
@@ -473,13 +1018,18 @@ tryagain:
 				if (tex_testCompresion)
 				{
 					byte *oldstream = task.stream;
-					task.stream = TexDecompress(outfile, &task, &task.streamLen);
+					{
+						TraceScope timer(TexStats_StageName(TEX_STAGE_DECOMPRESS), &task.times[TEX_STAGE_DECOMPRESS], task.file->name.c_str());
+						task.stream = TexDecompress(outfile, &task, &task.streamLen);
+					}
 					mem_free(oldstream);
 				}
 
 				// write stats
 				if (tex_statsFile[0])
-					WriteStats(outfile, "compressed", &task, calc);
+					TexStats_Add(&task, outfile, "compressed", calc);
+				if (trace_enabled)
+					TexStats_AddTimings(&task);
 
 				// do not need this anymore
 				if (calc != NULL)
@@ -523,7 +1073,9 @@ tryagain:
 		}
 
 		// we are finished with this image
+		TexSchedule_EndWork(task.file, workprofile, I_DoubleTime() - workstart);
 		Image_Unload(image);
+		ReleaseMemoryForThread(thread);
 	}
 	Image_Delete(image);
 }
@@ -644,10 +1196,14 @@ void TexCompress_MainThread(ThreadData *thread)
 
 			// write
 			if (outzip)
+			{
+				TraceScope timer("zipadd", NULL, WriteData->outfile);
 				TexAddZipFile(SharedData, outzip, WriteData->outfile, WriteData->data, WriteData->datasize);
+			}
 			else
 			{
 				// write file
+				TraceScope timer("write", NULL, WriteData->outfile);
 				CreatePath(WriteData->outfile);
 				FILE *f = fopen(WriteData->outfile, "wb");
 				if (!f)
@@ -710,6 +1266,17 @@ void TexCompress_Option(const char *section, const char *group, const char *key,
 			tex_gameDir = val;
 		else if (!stricmp(key, "binaryalpha"))
 			tex_detectBinaryAlpha = OptionBoolean(val);
+		else if (!stricmp(key, "keepopaquealpha"))
+			tex_keepOpaqueAlpha = OptionBoolean(val);
+		else if (!stricmp(key, "fastpath"))
+			tex_noFastPath = !OptionBoolean(val);
+		else if (!stricmp(key, "verifysource"))
+		{
+			strlcpy(tex_verifySource, val, sizeof(tex_verifySource));
+			AddSlash(tex_verifySource);
+		}
+		else if (!stricmp(key, "verifyreport"))
+			strlcpy(tex_verifyReport, val, sizeof(tex_verifyReport));
 		else if (!stricmp(key, "addpath"))
 			tex_addPath = val;
 		else if (!stricmp(key, "nonpoweroftwotextures"))
@@ -732,6 +1299,8 @@ void TexCompress_Option(const char *section, const char *group, const char *key,
 			tex_binaryAlphaCenter = (byte)(min(max(0, atoi(val)), 255));
 		else if (!stricmp(key, "binaryalpha_threshold"))
 			tex_binaryAlphaThreshold = min(max(0.0f, (float)atof(val)), 99.9999f);
+		else if (!stricmp(key, "alphableed"))
+			tex_alphaBleedDistance = max(0, atoi(val));
 		else if (!stricmp(key, "scaler"))
 			tex_firstScaler = tex_secondScaler = (ImageScaler)OptionEnum(val, ImageScalers, IMAGE_SCALER_SUPER2X);
 		else if (!stricmp(key, "scaler2"))
@@ -744,6 +1313,38 @@ void TexCompress_Option(const char *section, const char *group, const char *key,
 			tex_signVersion = FOURCC(strlen(val) < 1 ? 0 : val[0], strlen(val) < 2 ? 0 : val[1], strlen(val) < 3 ? 0 : val[2], strlen(val) < 4 ? 0 : val[3]);
 		else if (!stricmp(key, "statsfile"))
 			strlcpy(tex_statsFile, val, sizeof(tex_statsFile));
+		else if (!stricmp(key, "zstdlevel"))
+			tex_zstdLevel = max(0, min(atoi(val), 22));
+		else if (!stricmp(key, "zstdthreads"))
+			tex_zstdThreads = max(0, atoi(val));
+		else if (!stricmp(key, "membudget"))
+			tex_memBudget = max(0, atoi(val));
+		else if (!stricmp(key, "deadline"))
+			tex_deadline = TexSchedule_ParseTime(val);
+		else if (!stricmp(key, "targetpsnr"))
+			tex_targetPSNR = max(0.0, atof(val));
+		else if (!stricmp(key, "targetrms"))
+			tex_targetRMS = max(0.0, atof(val));
+		else if (!stricmp(key, "targetescalate"))
+			tex_targetEscalate = (texescalate)OptionEnum(val, tex_escalations, ESCALATE_PROFILE);
+		else if (!stricmp(key, "autoformat"))
+			tex_autoFormat = OptionBoolean(val);
+		else if (!stricmp(key, "prescreen"))
+			tex_prescreen = OptionBoolean(val);
+		else if (!stricmp(key, "prescreenmargin"))
+			tex_prescreenMargin = max(0.0, atof(val));
+		else if (!stricmp(key, "tournament"))
+			tex_tournament = OptionBoolean(val);
+		else if (!stricmp(key, "tournamenteps"))
+			tex_tournamentEpsilon = max(0.0, atof(val));
+		else if (!stricmp(key, "toolsfile"))
+			strlcpy(tex_tournamentFile, val, sizeof(tex_tournamentFile));
+		else if (!stricmp(key, "tracefile"))
+			strlcpy(tex_traceFile, val, sizeof(tex_traceFile));
+		else if (!stricmp(key, "costsfile"))
+			strlcpy(tex_scheduleFile, val, sizeof(tex_scheduleFile));
+		else if (!stricmp(key, "schedule"))
+			tex_scheduleOrder = OptionBoolean(val);
 		else
 			Warning("%s:%i: unknown key '%s'", filename, linenum, key);
 		return;
@@ -758,6 +1359,7 @@ void TexCompress_Option(const char *section, const char *group, const char *key,
 	if (!stricmp(group, "scale") || !stricmp(group, "scale_2x")) { OptionFCList(&tex_scale2xFiles, key, val); return; }
 	if (!stricmp(group, "scale_4x")) { OptionFCList(&tex_scale2xFiles, key, val); return; }
 	if (!stricmp(group, "srgb")) { OptionFCList(&tex_sRGBcolorspace, key, val); return; }
+	if (!strnicmp(group, "targetpsnr:", 11) || !strnicmp(group, "targetrms:", 10)) { OptionFCList(&CompressTargetRule(group)->files, key, val); return; }
 	Warning("%s:%i: unknown group '%s'", filename, linenum, group);
 }
 
@@ -896,6 +1498,10 @@ void TexCompress_Load(void)
 		}
 	}
 
+	// .crn files are made only by crunch
+	if (tex_container == &CONTAINER_CRN)
+		CODEC_DXT.forceTool = &TOOL_CRUNCH;
+
 	// print active codecs
 	TexCodec *active = tex_active_codecs;
 	if (!active)
@@ -959,11 +1565,50 @@ void TexCompress_Load(void)
 		if (tex_testCompresion_keepSize)
 			Print("Keeping original image dimensions\n");
 	}
-	if (strlen(tex_statsFile) > 0)
+	if (tex_memBudget > 0)
+		Print("Limiting memory of textures in flight to %i MB\n", tex_memBudget);
+	if (CompressTargetEnabled())
+	{
+		Print("Quality target:");
+		if (tex_targetPSNR > 0)
+			Print(" psnr %.2f", tex_targetPSNR);
+		if (tex_targetRMS > 0)
+			Print(" rms %.2f", tex_targetRMS);
+		if (tex_targetRules.size())
+			Print(" (%i file rules)", (int)tex_targetRules.size());
+		Print(", textures are encoded with fastest profile first\n");
+		if (tex_targetEscalate != ESCALATE_PROFILE)
+			Print("Textures missing quality target are re-encoded with other tools%s\n", (tex_targetEscalate == ESCALATE_FORMAT) ? " and bigger formats" : "");
+		if (tex_autoFormat)
+			Print("Format is selected by trial encoding of sampled blocks\n");
+	}
+	else if (tex_autoFormat)
+		Warning("-autoformat requires -targetpsnr or -targetrms, ignored");
+	if (tex_tournament)
 	{
+		Print("Tool tournament: fastest tool within %.2f dB of best on sampled blocks is used\n", tex_tournamentEpsilon);
+		if (tex_tournamentFile[0])
+			Print("Keeping tournament results in \"%s\"\n", tex_tournamentFile);
+	}
+	if (tex_scheduleFile[0])
+		Print("Keeping processing speeds in \"%s\"\n", tex_scheduleFile);
+	if (tex_deadline > 0)
+		Print("Deadline %i:%02i, profile is lowered for remaining files if it cannot be met\n", (int)(tex_deadline / 60), (int)tex_deadline % 60);
+	if (tex_container == &CONTAINER_KTX2 && tex_zstdLevel > 0)
+	{
+		if (KTX2_ZstdLoaded())
+			Print("Supercompressing KTX2 levels with zstd (level %i)\n", tex_zstdLevel);
+		else
+			Warning("zstd library not found, KTX2 levels will not be supercompressed");
+	}
+	if (strlen(tex_statsFile) > 0)
 		Print("Writing compression statistics to \"%s\"\n", tex_statsFile);
-		InitStats();
+	if (tex_traceFile[0])
+	{
+		Print("Writing timing trace to \"%s\"\n", tex_traceFile);
+		Trace_Start();
 	}
+	TexStats_Init();
 
 	// load codecs
 	for (TexCodec *codec = tex_active_codecs; codec; codec = codec->nextActive)
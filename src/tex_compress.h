@@ -4,6 +4,39 @@
 
 #include "tex.h"
 
+// pipeline stages timed for statistics
+typedef enum
+{
+	TEX_STAGE_LOAD,
+	TEX_STAGE_CONVERT,
+	TEX_STAGE_SCALE,
+	TEX_STAGE_DIMENSIONS,
+	TEX_STAGE_MIPMAPS,
+	TEX_STAGE_COMPRESS,
+	TEX_STAGE_ERRORCALC,
+	TEX_STAGE_DECOMPRESS,
+	TEX_STAGE_SAMPLE,
+	NUM_TEX_STAGES,
+}TexStage;
+
+// sampled error control result
+typedef enum
+{
+	PRESCREEN_NONE,      // not used
+	PRESCREEN_PENDING,   // requested, run after format and tool are selected
+	PRESCREEN_AMBIGUOUS, // full image check is needed
+	PRESCREEN_ACCEPT,    // error control would pass
+	PRESCREEN_REJECT     // error control would discard, texture was not encoded
+}TexPrescreen;
+
+// per-file quality target, files matching [targetpsnr:X] or [targetrms:X] group get target X (0 disables it)
+typedef struct
+{
+	bool        rms;   // false - psnr target
+	double      value;
+	CompareList files;
+}TexTargetRule;
+
 // a task that is shipped to codec
 // codec should fill it's own values (format type, colorSwizzle etc.)
 // and then task is get executed
@@ -13,15 +46,42 @@ typedef struct TexEncodeTask_s
 	FS_File          *file;
 	LoadedImage      *image;
 	TexContainer     *container;
+	texprofile        profile; // quality profile, may differ from tex_profile (deadline)
+	double            targetPSNR; // quality target of this file (tex_targetPSNR or target rule), 0 if not used
+	double            targetRMS;
 	// initialized by codec
 	TexCodec         *codec; // if discarded, redirect to fallback codec
 	TexFormat        *format;
 	TexTool          *tool;
+	bool              formatForced; // set by codec option or force_ rules, not changed to meet quality target
+	bool              toolForced;
 	// initialized right before shipping task to the tool
 	byte             *stream;
 	size_t            streamLen;
+	// statistics
+	int               threadnum;
+	bool              fastpath;               // encoded directly, tool was not run
+	bool              degraded;               // profile was lowered to meet deadline
+	TexPrescreen      prescreen;              // sampled error control
+	const char       *toolSelect;             // how tool was picked ("sampled", "cached" by tournament, "target" by quality target escalation), NULL if not used
+	size_t            inputBytes;             // decoded source image size
+	int               preprocessPasses;       // passes over map data made by map preprocessing
+	double            times[NUM_TEX_STAGES];  // seconds spent in pipeline stages
 } TexEncodeTask;
 
+// conversions applied to each map before it is passed to tool
+typedef struct
+{
+	bool   BinaryAlpha;
+	bool   ConvertTosRGB;
+	bool   ConvertToLinear;
+	bool   SwapColors;
+	void (*ColorSwizzle)(byte *data, int width, int height, int pitch, int bpp, bool rgbSwap, bool sRGB, bool decode);
+} MapProcessParms;
+
+// fused map preprocessing works on strips of this size
+#define PREPROCESS_STRIP_BYTES (128*1024)
+
 // multithreaded write stuff
 typedef struct TexWriteData_s
 {
@@ -47,7 +107,21 @@ typedef struct
 	TexWriteData *writeData;
 } TexCompressData;
 
+// util
+void  PreprocessParms(TexEncodeTask *task, bool sRGB, MapProcessParms *parms);
+int   PreprocessMap(ImageMap *map, MapProcessParms *parms, int bpp, bool rgbSwap, bool fused);
+void  Compress(TexEncodeTask *task);
+void  CompressPrepare(TexEncodeTask *task);
+void  CompressPrepareMaps(TexEncodeTask *task);
+void  CompressStream(TexEncodeTask *task);
+bool  CompressTargetEnabled(void);
+bool  CompressTargetEnabled(TexEncodeTask *task);
+void  CompressTargetSet(TexEncodeTask *task);
+struct TexCalcErrors_s *CompressToTarget(TexEncodeTask *task, char *outfile, texprofile maxprofile);
+
 // generic
+void  TexCompress_Init(void);
+size_t TexCompress_EstimateMemory(FS_File *file);
 void  TexCompress_WorkerThread(ThreadData *thread);
 void  TexCompress_MainThread(ThreadData *thread);
 void  TexCompress_Option(const char *section, const char *group, const char *key, const char *val, const char *filename, int linenum);
@@ -81,6 +81,21 @@ void UnswizzleImage(TexDecodeTask *task)
 	Image_ConvertBPP(task->image, (task->format->features & FF_ALPHA) ? 4 : 3);
 }
 
+// free data allocated by container loader
+void FreeDecodeTask(TexDecodeTask *task)
+{
+	if (task->comment)
+	{
+		mem_free(task->comment);
+		task->comment = NULL;
+	}
+	if (task->unpacked)
+	{
+		mem_free(task->unpacked);
+		task->unpacked = NULL;
+	}
+}
+
 void Decompress(TexDecodeTask *task, bool exportWholeFileWithMipLevels, LoadedImage *original)
 {
 	char outfile[MAX_FPATH], filepath[MAX_FPATH];
@@ -142,7 +157,7 @@ void Decompress(TexDecodeTask *task, bool exportWholeFileWithMipLevels, LoadedIm
 			UnswizzleImage(task);
 
 		// finished loading
-		Image_LoadFinish(task->image);
+		Image_LoadFinish(task->image, false);
 
 		// export
 		StripFileExtension(task->filename, filepath);
@@ -177,11 +192,7 @@ void Decompress(TexDecodeTask *task, bool exportWholeFileWithMipLevels, LoadedIm
 	// cleanup
 	Image_Delete(task->image);
 	task->image = NULL;
-	if (task->comment)
-	{
-		mem_free(task->comment);
-		task->comment = NULL;
-	}
+	FreeDecodeTask(task);
 }
 
 void DecodeFromEncode(TexDecodeTask *out, TexEncodeTask *in, char *filename)
@@ -12,6 +12,7 @@ typedef struct TexDecodeTask_s
 	byte             *data;
 	size_t            datasize;
 	TexContainer     *container;
+	bool              libraryDecode; // decode with encoder library instead of native block decoder (benchmark)
 	// initialized by container loader
 	TexCodec         *codec;
 	TexFormat        *format;
@@ -21,6 +22,7 @@ typedef struct TexDecodeTask_s
 	byte             *pixeldata;
 	size_t            pixeldatasize;
 	char             *comment;
+	byte             *unpacked; // level data unpacked by container loader (freed by FreeDecodeTask)
 	// image parameters (initialized by container loader)
 	struct
 	{
@@ -41,6 +43,7 @@ typedef struct TexDecodeTask_s
 void DecodeFromEncode(TexDecodeTask *out, TexEncodeTask *in, char *filename);
 size_t DecompressImage(TexDecodeTask *task);
 void UnswizzleImage(TexDecodeTask *task);
+void FreeDecodeTask(TexDecodeTask *task);
 
 // generic
 bool  TexDecompress(char *filename);
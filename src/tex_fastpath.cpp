@@ -0,0 +1,595 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / direct encoding of constant-color and tiny textures
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "tex.h"
+
+// optimal single-color DXT endpoints
+// for each 8-bit value holds best (max, min) pair which 2/3 interpolation gives that value
+byte fastpath_dxtMatch5[256][2];
+byte fastpath_dxtMatch6[256][2];
+
+// ETC1 intensity modifier tables
+static const int fastpath_etcModifiers[8][2] =
+{
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+void FastPath_PrepareMatchTable(byte table[256][2], int size)
+{
+	int i, mn, mx, mine, maxe, err, bestErr, bits;
+
+	bits = (size == 32) ? 5 : 6;
+	for (i = 0; i < 256; i++)
+	{
+		bestErr = 256;
+		for (mn = 0; mn < size; mn++)
+		{
+			for (mx = 0; mx < size; mx++)
+			{
+				mine = (mn << (8 - bits)) | (mn >> (2*bits - 8));
+				maxe = (mx << (8 - bits)) | (mx >> (2*bits - 8));
+				// hardware interpolation is only required to be within 3% of exact result
+				err = abs((2*maxe + mine) / 3 - i) + abs(maxe - mine) * 3 / 100;
+				if (err < bestErr)
+				{
+					table[i][0] = mx;
+					table[i][1] = mn;
+					bestErr = err;
+				}
+			}
+		}
+	}
+}
+
+void TexFastPath_Init(void)
+{
+	FastPath_PrepareMatchTable(fastpath_dxtMatch5, 32);
+	FastPath_PrepareMatchTable(fastpath_dxtMatch6, 64);
+}
+
+// true if loaded image consists of single color, mipmaps and scaling could be done cheaply
+bool TexFastPath_IsConstant(LoadedImage *image)
+{
+	return (image->stats.valid && image->stats.numColors == 1) ? true : false;
+}
+
+/*
+==========================================================================================
+
+  Pixel access
+
+==========================================================================================
+*/
+
+// maps are converted to tool input color order, see GenerateMipMaps
+bool FastPath_MapIsBGR(TexEncodeTask *task)
+{
+	if (task->image->colorSwap)
+		return (task->tool->inputflags & (TEXINPUT_BGR|TEXINPUT_BGRA)) ? true : false;
+	return (task->tool->inputflags & (TEXINPUT_RGB|TEXINPUT_RGBA)) ? false : true;
+}
+
+// fetch RGBA pixel from map data
+void FastPath_GetPixel(byte *out, byte *in, int bpp, bool bgr)
+{
+	out[0] = bgr ? in[2] : in[0];
+	out[1] = in[1];
+	out[2] = bgr ? in[0] : in[2];
+	out[3] = (bpp == 4) ? in[3] : 255;
+}
+
+// check if all pixels of map are the same, returns RGBA color
+bool FastPath_MapColor(ImageMap *map, int bpp, bool bgr, byte *color)
+{
+	byte *in, *end;
+
+	in = map->data;
+	end = in + map->width * map->height * bpp;
+	for (in += bpp; in < end; in += bpp)
+		if (memcmp(in, map->data, bpp))
+			return false;
+	FastPath_GetPixel(color, map->data, bpp, bgr);
+	return true;
+}
+
+// fetch 4x4 RGBA block, pixels outside of map are clamped
+void FastPath_GetBlock(byte block[16][4], ImageMap *map, int bpp, bool bgr, int x, int y)
+{
+	int bx, by, px, py;
+
+	for (by = 0; by < 4; by++)
+	{
+		py = min(y + by, map->height - 1);
+		for (bx = 0; bx < 4; bx++)
+		{
+			px = min(x + bx, map->width - 1);
+			FastPath_GetPixel(block[by*4 + bx], map->data + (py * map->width + px) * bpp, bpp, bgr);
+		}
+	}
+}
+
+/*
+==========================================================================================
+
+  DXT
+
+==========================================================================================
+*/
+
+void FastPath_WriteColorBlockDXT(byte *out, int c0, int c1, unsigned int indices)
+{
+	out[0] = c0 & 0xFF;
+	out[1] = (c0 >> 8) & 0xFF;
+	out[2] = c1 & 0xFF;
+	out[3] = (c1 >> 8) & 0xFF;
+	out[4] = indices & 0xFF;
+	out[5] = (indices >> 8) & 0xFF;
+	out[6] = (indices >> 16) & 0xFF;
+	out[7] = (indices >> 24) & 0xFF;
+}
+
+// single-color block, always decodes same in 3 and 4-color mode
+void FastPath_SolidColorBlockDXT(byte *out, byte *color, bool transparent)
+{
+	unsigned int indices;
+	int c0, c1, t;
+
+	if (transparent)
+	{
+		// 3-color mode, all pixels are index 3 (transparent black)
+		FastPath_WriteColorBlockDXT(out, 0, 0, 0xFFFFFFFF);
+		return;
+	}
+	c0 = (fastpath_dxtMatch5[color[0]][0] << 11) | (fastpath_dxtMatch6[color[1]][0] << 5) | fastpath_dxtMatch5[color[2]][0];
+	c1 = (fastpath_dxtMatch5[color[0]][1] << 11) | (fastpath_dxtMatch6[color[1]][1] << 5) | fastpath_dxtMatch5[color[2]][1];
+	indices = 0xAAAAAAAA;
+	if (c0 < c1)
+	{
+		t = c0; c0 = c1; c1 = t;
+		indices ^= 0x55555555;
+	}
+	FastPath_WriteColorBlockDXT(out, c0, c1, indices);
+}
+
+int FastPath_Pack565(int r, int g, int b)
+{
+	return ((r * 31 + 127) / 255 << 11) | ((g * 63 + 127) / 255 << 5) | ((b * 31 + 127) / 255);
+}
+
+void FastPath_Unpack565(int c, int *out)
+{
+	out[0] = ((c >> 11) & 31) << 3; out[0] |= out[0] >> 5;
+	out[1] = ((c >> 5) & 63) << 2;  out[1] |= out[1] >> 6;
+	out[2] = (c & 31) << 3;         out[2] |= out[2] >> 5;
+}
+
+// simple bounding box color block encoder, used for tiny textures
+// transparent pixels are written as index 3 in 3-color mode if punchThrough is set
+void FastPath_ColorBlockDXT(byte *out, byte block[16][4], bool punchThrough)
+{
+	int i, c, mn[3], mx[3], inset, c0, c1, t, palette[4][3], best, bestErr, err, d;
+	unsigned int indices;
+	bool transparent;
+
+	// bounding box
+	transparent = false;
+	mn[0] = mn[1] = mn[2] = 255;
+	mx[0] = mx[1] = mx[2] = 0;
+	for (i = 0; i < 16; i++)
+	{
+		if (punchThrough && block[i][3] < 128)
+		{
+			transparent = true;
+			continue;
+		}
+		for (c = 0; c < 3; c++)
+		{
+			mn[c] = min(mn[c], block[i][c]);
+			mx[c] = max(mx[c], block[i][c]);
+		}
+	}
+	if (mn[0] > mx[0])
+	{
+		FastPath_WriteColorBlockDXT(out, 0, 0, 0xFFFFFFFF);
+		return;
+	}
+	for (c = 0; c < 3; c++)
+	{
+		inset = (mx[c] - mn[c]) >> 4;
+		mn[c] += inset;
+		mx[c] -= inset;
+	}
+	c0 = FastPath_Pack565(mx[0], mx[1], mx[2]);
+	c1 = FastPath_Pack565(mn[0], mn[1], mn[2]);
+
+	// 4-color mode needs c0 > c1, 3-color mode needs c0 <= c1
+	if ((!transparent && c0 < c1) || (transparent && c0 > c1))
+	{
+		t = c0; c0 = c1; c1 = t;
+	}
+	FastPath_Unpack565(c0, palette[0]);
+	FastPath_Unpack565(c1, palette[1]);
+	for (c = 0; c < 3; c++)
+	{
+		if (transparent)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+		else
+		{
+			palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+		}
+	}
+
+	// indices
+	indices = 0;
+	for (i = 15; i >= 0; i--)
+	{
+		best = 0;
+		if (transparent && block[i][3] < 128)
+			best = 3;
+		else if (c0 != c1)
+		{
+			bestErr = 0x7FFFFFFF;
+			for (t = 0; t < (transparent ? 3 : 4); t++)
+			{
+				err = 0;
+				for (c = 0; c < 3; c++)
+				{
+					d = palette[t][c] - block[i][c];
+					err += d*d;
+				}
+				if (err < bestErr)
+				{
+					bestErr = err;
+					best = t;
+				}
+			}
+		}
+		indices = (indices << 2) | best;
+	}
+	FastPath_WriteColorBlockDXT(out, c0, c1, indices);
+}
+
+// DXT2/3 explicit alpha
+void FastPath_AlphaBlockDXT3(byte *out, byte block[16][4])
+{
+	int i, a0, a1;
+
+	for (i = 0; i < 16; i += 2)
+	{
+		a0 = (block[i][3] * 15 + 127) / 255;
+		a1 = (block[i + 1][3] * 15 + 127) / 255;
+		out[i / 2] = (byte)(a0 | (a1 << 4));
+	}
+}
+
+// DXT4/5 interpolated alpha in 8-alpha mode
+void FastPath_AlphaBlockDXT5(byte *out, byte block[16][4])
+{
+	int i, t, a0, a1, palette[8], best, bestErr, err;
+	unsigned long long indices;
+
+	a0 = 0;
+	a1 = 255;
+	for (i = 0; i < 16; i++)
+	{
+		a0 = max(a0, block[i][3]);
+		a1 = min(a1, block[i][3]);
+	}
+	memset(out, 0, 8);
+	out[0] = (byte)a0;
+	out[1] = (byte)a1;
+	if (a0 == a1)
+		return;
+	palette[0] = a0;
+	palette[1] = a1;
+	for (t = 1; t < 7; t++)
+		palette[t + 1] = ((7 - t) * a0 + t * a1) / 7;
+	indices = 0;
+	for (i = 15; i >= 0; i--)
+	{
+		best = 0;
+		bestErr = 256;
+		for (t = 0; t < 8; t++)
+		{
+			err = abs(palette[t] - block[i][3]);
+			if (err < bestErr)
+			{
+				bestErr = err;
+				best = t;
+			}
+		}
+		indices = (indices << 3) | best;
+	}
+	for (i = 0; i < 6; i++)
+		out[2 + i] = (byte)((indices >> (i * 8)) & 0xFF);
+}
+
+/*
+==========================================================================================
+
+  ETC
+
+==========================================================================================
+*/
+
+// best single-color ETC1 block, differential and individual modes are tried
+// such block is also valid ETC2 block
+void FastPath_SolidColorBlockETC(byte *out, byte *color)
+{
+	int diff, bits, levels, table, sel, c, base, value, err, bestChannelErr, bestBase[3], channelErr;
+	int bestErr, bestDiff, bestTable, bestSel, bestColor[3];
+	unsigned int block1, block2;
+
+	bestErr = 0x7FFFFFFF;
+	bestDiff = bestTable = bestSel = 0;
+	bestColor[0] = bestColor[1] = bestColor[2] = 0;
+	for (diff = 0; diff < 2; diff++)
+	{
+		bits = diff ? 5 : 4;
+		levels = 1 << bits;
+		for (table = 0; table < 8; table++)
+		{
+			for (sel = 0; sel < 4; sel++)
+			{
+				err = 0;
+				for (c = 0; c < 3; c++)
+				{
+					bestChannelErr = 0x7FFFFFFF;
+					for (base = 0; base < levels; base++)
+					{
+						value = diff ? ((base << 3) | (base >> 2)) : (base * 17);
+						value += (sel & 2) ? -fastpath_etcModifiers[table][sel & 1] : fastpath_etcModifiers[table][sel & 1];
+						value = min(255, max(0, value));
+						channelErr = (value - color[c]) * (value - color[c]);
+						if (channelErr < bestChannelErr)
+						{
+							bestChannelErr = channelErr;
+							bestBase[c] = base;
+						}
+					}
+					err += bestChannelErr;
+				}
+				if (err < bestErr)
+				{
+					bestErr = err;
+					bestDiff = diff;
+					bestTable = table;
+					bestSel = sel;
+					bestColor[0] = bestBase[0];
+					bestColor[1] = bestBase[1];
+					bestColor[2] = bestBase[2];
+				}
+			}
+		}
+	}
+
+	// both subblocks are the same, deltas are zero
+	if (bestDiff)
+		block1 = (bestColor[0] << 27) | (bestColor[1] << 19) | (bestColor[2] << 11) | 2;
+	else
+		block1 = (bestColor[0] << 28) | (bestColor[0] << 24) | (bestColor[1] << 20) | (bestColor[1] << 16) | (bestColor[2] << 12) | (bestColor[2] << 8);
+	block1 |= (bestTable << 5) | (bestTable << 2);
+	block2 = ((bestSel & 2) ? 0xFFFF0000 : 0) | ((bestSel & 1) ? 0x0000FFFF : 0);
+	out[0] = (block1 >> 24) & 0xFF;
+	out[1] = (block1 >> 16) & 0xFF;
+	out[2] = (block1 >> 8) & 0xFF;
+	out[3] =  block1 & 0xFF;
+	out[4] = (block2 >> 24) & 0xFF;
+	out[5] = (block2 >> 16) & 0xFF;
+	out[6] = (block2 >> 8) & 0xFF;
+	out[7] =  block2 & 0xFF;
+}
+
+// EAC alpha with zero multiplier decodes to base value exactly
+void FastPath_SolidAlphaBlockEAC(byte *out, byte alpha)
+{
+	memset(out, 0, 8);
+	out[0] = alpha;
+}
+
+/*
+==========================================================================================
+
+  PVRTC
+
+==========================================================================================
+*/
+
+// opaque PVRTC word, color A is used by all pixels (modulation 0)
+// colors of neighbour blocks are the same so bilinear upscale keeps the color
+void FastPath_SolidColorBlockPVRTC(byte *out, byte *color)
+{
+	unsigned int colorA, colorB, r, g, b;
+
+	r = (color[0] * 31 + 127) / 255;
+	g = (color[1] * 31 + 127) / 255;
+	b = (color[2] * 15 + 127) / 255;
+	colorA = 0x8000 | (r << 10) | (g << 5) | (b << 1);
+	colorB = 0x8000 | (r << 10) | (g << 5) | (((b << 1) | (b >> 3)));
+	memset(out, 0, 4);
+	out[4] = colorA & 0xFF;
+	out[5] = (colorA >> 8) & 0xFF;
+	out[6] = colorB & 0xFF;
+	out[7] = (colorB >> 8) & 0xFF;
+}
+
+/*
+==========================================================================================
+
+  Encoding
+
+==========================================================================================
+*/
+
+typedef enum
+{
+	FASTPATH_NONE,
+	FASTPATH_DXT1,
+	FASTPATH_DXT1A,
+	FASTPATH_DXT3,
+	FASTPATH_DXT5,
+	FASTPATH_ETC,
+	FASTPATH_ETC2A,
+	FASTPATH_PVRTC2,
+	FASTPATH_PVRTC4,
+	FASTPATH_BGRA,
+} FastPathType;
+
+FastPathType FastPath_GetType(TexFormat *format)
+{
+	TexBlock *block = format->block;
+
+	if (block == &B_DXT1)
+		return (format->features & FF_PUNCH_THROUGH_ALPHA) ? FASTPATH_DXT1A : FASTPATH_DXT1;
+	if (block == &B_DXT2 || block == &B_DXT3)
+		return FASTPATH_DXT3;
+	if (block == &B_DXT4 || block == &B_DXT5)
+		return FASTPATH_DXT5;
+	if (block == &B_ETC1 || block == &B_ETC2)
+		return FASTPATH_ETC;
+	if (block == &B_ETC2A)
+		return FASTPATH_ETC2A;
+	if (block == &B_PVRTC_2BPP_RGB || block == &B_PVRTC_2BPP_RGBA)
+		return FASTPATH_PVRTC2;
+	if (block == &B_PVRTC_4BPP_RGB || block == &B_PVRTC_4BPP_RGBA)
+		return FASTPATH_PVRTC4;
+	if (block == &B_BGRA)
+		return FASTPATH_BGRA;
+	return FASTPATH_NONE;
+}
+
+// encoded block for constant color, returns block size
+size_t FastPath_SolidBlock(FastPathType type, byte *out, byte *color, bool bgr)
+{
+	switch(type)
+	{
+	case FASTPATH_DXT1:
+		FastPath_SolidColorBlockDXT(out, color, false);
+		return 8;
+	case FASTPATH_DXT1A:
+		FastPath_SolidColorBlockDXT(out, color, color[3] < 128);
+		return 8;
+	case FASTPATH_DXT3:
+		memset(out, (color[3] * 15 + 127) / 255 * 0x11, 8);
+		FastPath_SolidColorBlockDXT(out + 8, color, false);
+		return 16;
+	case FASTPATH_DXT5:
+		memset(out, 0, 8);
+		out[0] = out[1] = color[3];
+		FastPath_SolidColorBlockDXT(out + 8, color, false);
+		return 16;
+	case FASTPATH_ETC:
+		FastPath_SolidColorBlockETC(out, color);
+		return 8;
+	case FASTPATH_ETC2A:
+		FastPath_SolidAlphaBlockEAC(out, color[3]);
+		FastPath_SolidColorBlockETC(out + 8, color);
+		return 16;
+	case FASTPATH_PVRTC2:
+	case FASTPATH_PVRTC4:
+		FastPath_SolidColorBlockPVRTC(out, color);
+		return 8;
+	case FASTPATH_BGRA:
+		// same byte order as rwgtp packer writes
+		out[0] = bgr ? color[2] : color[0];
+		out[1] = color[1];
+		out[2] = bgr ? color[0] : color[2];
+		out[3] = color[3];
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+// encode tiny DXT map block by block
+size_t FastPath_TinyMapDXT(FastPathType type, byte *out, ImageMap *map, int bpp, bool bgr)
+{
+	byte block[16][4], *start;
+	int x, y;
+
+	start = out;
+	for (y = 0; y < map->height; y += 4)
+	{
+		for (x = 0; x < map->width; x += 4)
+		{
+			FastPath_GetBlock(block, map, bpp, bgr, x, y);
+			if (type == FASTPATH_DXT3)
+			{
+				FastPath_AlphaBlockDXT3(out, block);
+				out += 8;
+			}
+			else if (type == FASTPATH_DXT5)
+			{
+				FastPath_AlphaBlockDXT5(out, block);
+				out += 8;
+			}
+			FastPath_ColorBlockDXT(out, block, (type == FASTPATH_DXT1A) ? true : false);
+			out += 8;
+		}
+	}
+	return out - start;
+}
+
+// write compressed data for constant color or tiny textures directly
+// returns false if texture should be passed to the tool
+bool TexFastPath_Compress(TexEncodeTask *task)
+{
+	byte color[4], solid[16], *stream, *out, *end;
+	FastPathType type;
+	size_t size, blocksize;
+	bool bgr, constant, tiny;
+	ImageMap *map;
+	int bpp;
+
+	if (tex_noFastPath)
+		return false;
+	type = FastPath_GetType(task->format);
+	if (type == FASTPATH_NONE)
+		return false;
+
+	// check maps
+	// mipmaps of constant image are constant too, but each level is checked and encoded with it's own color
+	bpp = task->image->bpp;
+	bgr = FastPath_MapIsBGR(task);
+	constant = true;
+	for (map = task->image->maps; map && constant; map = map->next)
+	{
+		if (!FastPath_MapColor(map, bpp, bgr, color))
+			constant = false;
+		// translucent PVRTC words are not handled
+		else if ((type == FASTPATH_PVRTC2 || type == FASTPATH_PVRTC4) && color[3] != 255)
+			constant = false;
+	}
+	tiny = (type >= FASTPATH_DXT1 && type <= FASTPATH_DXT5 && task->image->maps->width <= FASTPATH_TINY_SIZE && task->image->maps->height <= FASTPATH_TINY_SIZE) ? true : false;
+	if (!constant && !tiny)
+		return false;
+
+	// encode
+	stream = task->stream;
+	for (map = task->image->maps; map; map = map->next)
+	{
+		size = compressedLevelSize(task->format, map->width, map->height);
+		if (constant)
+		{
+			FastPath_MapColor(map, bpp, bgr, color);
+			blocksize = FastPath_SolidBlock(type, solid, color, bgr);
+			end = stream + size;
+			for (out = stream; out < end; out += blocksize)
+				memcpy(out, solid, blocksize);
+		}
+		else
+			FastPath_TinyMapDXT(type, stream, map, bpp, bgr);
+		stream += size;
+	}
+	return true;
+}
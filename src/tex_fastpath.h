@@ -0,0 +1,15 @@
+// tex_fastpath.h
+#ifndef H_TEX_FASTPATH_H
+#define H_TEX_FASTPATH_H
+
+#include "tex.h"
+
+// textures this small are encoded directly, skipping tool overhead
+#define FASTPATH_TINY_SIZE  8
+
+// generic
+void TexFastPath_Init(void);
+bool TexFastPath_IsConstant(LoadedImage *image);
+bool TexFastPath_Compress(TexEncodeTask *task);
+
+#endif
@@ -0,0 +1,633 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / sampled blocks trial encoding
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "freeimage.h"
+#include "tex.h"
+#include <algorithm>
+
+vector<TexToolChoice> tex_toolChoices;
+HANDLE                tex_toolChoiceMutex = NULL;
+bool                  tex_toolChoicesPlayed = false;
+
+/*
+==========================================================================================
+
+  Sample
+
+==========================================================================================
+*/
+
+// repeatable random numbers, same image gives same sample
+int SampleRandom(unsigned int *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (*seed >> 16) & 0x7fff;
+}
+
+// formats with independent blocks that fit sample block
+bool TexSample_Supported(TexFormat *format)
+{
+	if (format->codec == &CODEC_PVRTC || format->codec == &CODEC_PVRTC2 || !format->codec->fDecode)
+		return false;
+	return (SAMPLE_BLOCK_SIZE % format->block->width == 0 && SAMPLE_BLOCK_SIZE % format->block->height == 0);
+}
+
+// sum of per-channel variances of a block
+int SampleBlockDetail(byte *in, int pitch, int bpp)
+{
+	int x, y, c, sum[4], sq[4], detail;
+	byte *p;
+
+	memset(sum, 0, sizeof(sum));
+	memset(sq, 0, sizeof(sq));
+	for (y = 0; y < SAMPLE_BLOCK_SIZE; y++)
+	{
+		p = in + y * pitch;
+		for (x = 0; x < SAMPLE_BLOCK_SIZE; x++, p += bpp)
+		{
+			for (c = 0; c < bpp; c++)
+			{
+				sum[c] += p[c];
+				sq[c] += p[c] * p[c];
+			}
+		}
+	}
+	detail = 0;
+	for (c = 0; c < bpp; c++)
+		detail += sq[c] * SAMPLE_BLOCK_SIZE * SAMPLE_BLOCK_SIZE - sum[c] * sum[c];
+	return detail;
+}
+
+// image is split into cells, one random block is taken from each (stratified sample)
+// with picks > 1 most detailed of that many random blocks in cell is taken
+// returns false if image is small enough to be encoded fully
+bool TexSample_Create(TexSample *sample, LoadedImage *image, int picks)
+{
+	byte *in, *out, *data, *sampledata, *pick;
+	int bw, bh, gx, gy, n, cols, rows, cell, cx, cy, x0, x1, y0, y1, bx, by, i, j, y, pitch, samplepitch, rowsize, detail, best;
+	unsigned int seed;
+
+	memset(sample, 0, sizeof(TexSample));
+	bw = image->width / SAMPLE_BLOCK_SIZE;
+	bh = image->height / SAMPLE_BLOCK_SIZE;
+	sample->total = bw * bh;
+	n = max(SAMPLE_MIN_BLOCKS, min((int)(sample->total * SAMPLE_FRACTION), SAMPLE_MAX_BLOCKS));
+	if (!image->bitmap || n * 2 > sample->total)
+		return false;
+
+	// cells follow image aspect
+	gx = max(1, min(bw, (int)(sqrt((double)n * bw / bh) + 0.5)));
+	gy = max(1, min(bh, n / gx));
+	n = gx * gy;
+	cols = (int)ceil(sqrt((double)n));
+	rows = (n + cols - 1) / cols;
+
+	// pack blocks
+	sample->image = Image_Create();
+	sample->image->width = cols * SAMPLE_BLOCK_SIZE;
+	sample->image->height = rows * SAMPLE_BLOCK_SIZE;
+	sample->image->bpp = image->bpp;
+	sample->image->bitmap = fiCreate(sample->image->width, sample->image->height, image->bpp, "TexSample");
+	sample->image->colorSwap = image->colorSwap;
+	sample->image->sRGB = image->sRGB;
+	sample->image->hasAlpha = image->hasAlpha;
+	sample->image->hasGradientAlpha = image->hasGradientAlpha;
+	sample->image->datatype = image->datatype;
+	data = Image_GetData(image, NULL, &pitch);
+	sampledata = Image_GetData(sample->image, NULL, &samplepitch);
+	rowsize = SAMPLE_BLOCK_SIZE * image->bpp;
+	seed = (unsigned int)(image->width * 73856093) ^ (unsigned int)(image->height * 19349663);
+	for (i = 0; i < cols * rows; i++)
+	{
+		// last row is filled by extra random blocks
+		cell = (i < n) ? i : SampleRandom(&seed) % n;
+		cx = cell % gx;
+		cy = cell / gx;
+		x0 = cx * bw / gx;
+		x1 = (cx + 1) * bw / gx;
+		y0 = cy * bh / gy;
+		y1 = (cy + 1) * bh / gy;
+		in = NULL;
+		best = -1;
+		for (j = 0; j < max(1, picks); j++)
+		{
+			bx = x0 + SampleRandom(&seed) % max(1, x1 - x0);
+			by = y0 + SampleRandom(&seed) % max(1, y1 - y0);
+			pick = data + by * SAMPLE_BLOCK_SIZE * pitch + bx * rowsize;
+			detail = (picks > 1) ? SampleBlockDetail(pick, pitch, image->bpp) : 0;
+			if (detail > best)
+			{
+				in = pick;
+				best = detail;
+			}
+		}
+		out = sampledata + (i / cols) * SAMPLE_BLOCK_SIZE * samplepitch + (i % cols) * rowsize;
+		for (y = 0; y < SAMPLE_BLOCK_SIZE; y++)
+			memcpy(out + y * samplepitch, in + y * pitch, rowsize);
+	}
+	sample->blocks = cols * rows;
+	return true;
+}
+
+void TexSample_Free(TexSample *sample)
+{
+	if (sample->image)
+		Image_Delete(sample->image);
+	memset(sample, 0, sizeof(TexSample));
+}
+
+/*
+==========================================================================================
+
+  Trial encoding
+
+==========================================================================================
+*/
+
+// error calculation only looks at color, alpha is compared here
+double SampleAlphaPSNR(LoadedImage *decoded, LoadedImage *original)
+{
+	byte *dec, *org, *d, *o;
+	int decpitch, orgpitch, x, y, a, b;
+	double mse;
+
+	if (decoded->bpp != 4 && original->bpp != 4)
+		return 99.99;
+	dec = Image_GetData(decoded, NULL, &decpitch);
+	org = Image_GetData(original, NULL, &orgpitch);
+	mse = 0;
+	for (y = 0; y < original->height; y++)
+	{
+		d = dec + y * decpitch;
+		o = org + y * orgpitch;
+		for (x = 0; x < original->width; x++, d += decoded->bpp, o += original->bpp)
+		{
+			a = (decoded->bpp == 4) ? d[3] : 255;
+			b = (original->bpp == 4) ? o[3] : 255;
+			mse += (a - b) * (a - b);
+		}
+	}
+	mse = mse / ((double)original->width * original->height * 255.0 * 255.0);
+	if (mse <= 0)
+		return 99.99;
+	return 10.0 * log10(1.0 / mse);
+}
+
+// encode sample with tool and format, decode it same way error control does and measure
+bool TexSample_Encode(TexSample *sample, TexEncodeTask *task, TexFormat *format, TexTool *tool, TexSampleResult *result)
+{
+	TexEncodeTask encode;
+	TexDecodeTask decode;
+	MapProcessParms parms;
+	TexCalcErrors *calc;
+	LoadedImage *image;
+	ImageMap *map;
+	byte *in, *out, *data;
+	int dest_bpp, pitch, x, y;
+	bool sRGB;
+	double start;
+
+	memset(result, 0, sizeof(TexSampleResult));
+	result->format = format;
+	result->tool = tool;
+	result->bpp = (double)format->block->bitlength / (format->block->width * format->block->height);
+	if (!sample->image || !TexSample_Supported(format))
+		return false;
+
+	// tool input, see CompressPrepare
+	dest_bpp = sample->image->bpp;
+	if (!(tool->inputflags & (TEXINPUT_BGR|TEXINPUT_RGB)))
+		dest_bpp = 4;
+	else if (!(tool->inputflags & (TEXINPUT_BGRA|TEXINPUT_RGBA)))
+		dest_bpp = 3;
+	if (format->features & FF_SWIZZLE_RESERVED_ALPHA)
+		dest_bpp = 4;
+	image = Image_Create();
+	image->width = sample->image->width;
+	image->height = sample->image->height;
+	image->bpp = dest_bpp;
+	image->colorSwap = sample->image->colorSwap;
+	image->sRGB = sample->image->sRGB;
+	image->hasAlpha = sample->image->hasAlpha;
+	image->hasGradientAlpha = sample->image->hasGradientAlpha;
+	image->datatype = sample->image->datatype;
+	mem_calloc(&map, sizeof(ImageMap));
+	map->width = image->width;
+	map->height = image->height;
+	map->sRGB = image->sRGB;
+	map->datasize = map->width * map->height * dest_bpp;
+	map->data = (byte *)mem_alloc(map->datasize);
+	data = Image_GetData(sample->image, NULL, &pitch);
+	for (y = 0; y < map->height; y++)
+	{
+		in = data + y * pitch;
+		out = map->data + y * map->width * dest_bpp;
+		for (x = 0; x < map->width; x++, in += sample->image->bpp, out += dest_bpp)
+		{
+			out[0] = in[0];
+			out[1] = in[1];
+			out[2] = in[2];
+			if (dest_bpp == 4)
+				out[3] = (sample->image->bpp == 4) ? in[3] : 255;
+		}
+	}
+	image->maps = map;
+
+	// encode
+	memset(&encode, 0, sizeof(encode));
+	encode.file = task->file;
+	encode.image = image;
+	encode.container = &CONTAINER_DDS;
+	encode.profile = task->profile;
+	encode.codec = format->codec;
+	encode.format = format;
+	encode.tool = tool;
+	encode.threadnum = task->threadnum;
+	sRGB = false;
+	if (tex_sRGB_allow && (format->features & (FF_SRGB|FF_SWIZZLE_INTERNAL_SRGB)))
+		sRGB = (image->sRGB || tex_sRGB_forceconvert || FS_FileMatchList(task->file, task->image, tex_sRGBcolorspace.items));
+	PreprocessParms(&encode, sRGB, &parms);
+	PreprocessMap(map, &parms, dest_bpp, image->colorSwap, true);
+	encode.streamLen = compressedLevelSize(format, map->width, map->height);
+	encode.stream = (byte *)mem_alloc(encode.streamLen);
+	start = I_DoubleTime();
+	tool->fCompress(&encode);
+	result->seconds = I_DoubleTime() - start;
+
+	// decode
+	memset(&decode, 0, sizeof(decode));
+	decode.filename = (char *)task->file->name.c_str();
+	decode.container = &CONTAINER_DDS;
+	decode.codec = format->codec;
+	decode.format = format;
+	decode.width = map->width;
+	decode.height = map->height;
+	decode.pixeldata = encode.stream;
+	decode.pixeldatasize = encode.streamLen;
+	decode.ImageParms.sRGB = map->sRGB;
+	decode.ImageParms.isNormalmap = (image->datatype == IMAGE_NORMALMAP) ? true : false;
+	decode.ImageParms.colorSwap = image->colorSwap;
+	decode.ImageParms.hasAlpha = image->hasAlpha;
+	DecompressImage(&decode);
+
+	// measure
+	calc = TexCompressionError(format, decode.image, sample->image, ERRORMETRIC_AUTO, false);
+	result->rms = calc->rms;
+	result->average = calc->average;
+	result->dispersion = calc->dispersion;
+	result->psnr = min(ErrorCalcPSNR(calc), SampleAlphaPSNR(decode.image, sample->image));
+	FreeErrorCalc(calc);
+
+	// cleanup
+	Image_Delete(decode.image);
+	FreeDecodeTask(&decode);
+	mem_free(encode.stream);
+	Image_Delete(image);
+	return true;
+}
+
+/*
+==========================================================================================
+
+  Format selection
+
+==========================================================================================
+*/
+
+bool SampleTargetMet(TexEncodeTask *task, TexSampleResult *result)
+{
+	if (task->targetRMS > 0 && result->rms > task->targetRMS)
+		return false;
+	if (task->targetPSNR > 0 && result->psnr < task->targetPSNR)
+		return false;
+	return true;
+}
+
+bool CompareSampleBPP(const TexSampleResult &a, const TexSampleResult &b)
+{
+	return a.bpp < b.bpp;
+}
+
+// trial encode formats of codec (and it's fallback) on sampled blocks
+// and pick the smallest one that meets quality target, returns false if codec rules should be used
+bool TexSample_SelectFormat(TexEncodeTask *task)
+{
+	vector<TexSampleResult> candidates;
+	vector<TexSampleResult>::iterator c;
+	TexSampleResult result, *selected;
+	TexEncodeTask select;
+	TexCodec *codecs[2], *codec;
+	TexSample sample;
+	int i, blocks;
+
+	// candidates are formats as codec would adjust them for this image
+	// swizzled formats are only used by explicit rules
+	codecs[0] = task->codec;
+	codecs[1] = (task->codec->fallback && task->codec->fallback != task->codec && !task->codec->fallback->disabled) ? task->codec->fallback : NULL;
+	for (i = 0; i < 2 && codecs[i]; i++)
+	{
+		codec = codecs[i];
+		for (vector<TexFormat*>::iterator f = codec->formats.begin(); f < codec->formats.end(); f++)
+		{
+			if ((*f)->colorSwizzle || !TexSample_Supported(*f))
+				continue;
+			select = *task;
+			select.codec = codec;
+			select.format = *f;
+			select.tool = (codec == task->codec) ? task->tool : codec->forceTool;
+			codec->fEncode(&select);
+			if (!select.format || !select.tool || !TexSample_Supported(select.format))
+				continue;
+			if (find(select.tool->formats.begin(), select.tool->formats.end(), select.format) == select.tool->formats.end())
+				continue;
+			if (task->image->hasAlpha && (!(select.format->features & FF_ALPHA) || (task->image->hasGradientAlpha && (select.format->features & FF_PUNCH_THROUGH_ALPHA))))
+				continue;
+			for (c = candidates.begin(); c < candidates.end(); c++)
+				if (c->format == select.format)
+					break;
+			if (c < candidates.end())
+				continue;
+			memset(&result, 0, sizeof(result));
+			result.format = select.format;
+			result.tool = select.tool;
+			result.bpp = (double)select.format->block->bitlength / (select.format->block->width * select.format->block->height);
+			candidates.push_back(result);
+		}
+	}
+	if (candidates.size() < 2)
+		return false;
+	if (!TexSample_Create(&sample, task->image, 1))
+		return false;
+
+	// smallest first, stop at first one meeting target
+	// if none does, the best looking is taken
+	stable_sort(candidates.begin(), candidates.end(), CompareSampleBPP);
+	selected = NULL;
+	for (c = candidates.begin(); c < candidates.end(); c++)
+	{
+		if (!TexSample_Encode(&sample, task, c->format, c->tool, &(*c)))
+			continue;
+		if (!selected || c->psnr > selected->psnr)
+			selected = &(*c);
+		if (SampleTargetMet(task, &(*c)))
+		{
+			selected = &(*c);
+			break;
+		}
+	}
+	blocks = sample.blocks;
+	TexSample_Free(&sample);
+	if (!selected)
+		return false;
+	Verbose("%s: selected %s:%s by %i sampled blocks (psnr %.2f, rms %.2f)\n", task->file->name.c_str(), selected->tool->name, selected->format->name, blocks, selected->psnr, selected->rms);
+	task->codec = selected->format->codec;
+	task->format = selected->format;
+	task->tool = selected->tool;
+	return true;
+}
+
+/*
+==========================================================================================
+
+  Error control prescreen
+
+==========================================================================================
+*/
+
+// codec discard rules are checked against sampled errors widened by margin both ways
+// sample leans to detailed blocks, so it's errors are rather overestimated and accepts are safe
+// only when both ends agree, the full image check is skipped (or encoding is)
+TexPrescreen TexSample_Prescreen(TexEncodeTask *task)
+{
+	TexCalcErrors low, high;
+	TexSampleResult result;
+	TexSample sample;
+	bool matchLow, matchHigh;
+	int blocks;
+
+	if (!TexSample_Supported(task->format) || !TexSample_Create(&sample, task->image, SAMPLE_DETAIL_PICKS))
+		return PRESCREEN_AMBIGUOUS;
+	TexSample_Encode(&sample, task, task->format, task->tool, &result);
+	blocks = sample.blocks;
+	TexSample_Free(&sample);
+
+	memset(&low, 0, sizeof(low));
+	low.average = result.average * (1.0 - tex_prescreenMargin);
+	low.dispersion = result.dispersion * (1.0 - tex_prescreenMargin);
+	low.rms = result.rms * (1.0 - tex_prescreenMargin);
+	memset(&high, 0, sizeof(high));
+	high.average = result.average * (1.0 + tex_prescreenMargin);
+	high.dispersion = result.dispersion * (1.0 + tex_prescreenMargin);
+	high.rms = result.rms * (1.0 + tex_prescreenMargin);
+	matchLow = FS_FileMatchList(task->file, task->image, &low, task->codec->discardList.items);
+	matchHigh = FS_FileMatchList(task->file, task->image, &high, task->codec->discardList.items);
+	if (matchLow && matchHigh)
+	{
+		Verbose("%s: %s:%s discarded by %i sampled blocks (error %.2f, rms %.2f)\n", task->file->name.c_str(), task->tool->name, task->format->name, blocks, result.average, result.rms);
+		return PRESCREEN_REJECT;
+	}
+	if (!matchLow && !matchHigh)
+		return PRESCREEN_ACCEPT;
+	return PRESCREEN_AMBIGUOUS;
+}
+
+/*
+==========================================================================================
+
+  Tool tournament
+
+==========================================================================================
+*/
+
+// tournament results are kept by sampled blocks, so unchanged textures skip it on next run
+// tournament only sees sampled blocks, so they are all that decides the tool
+void SampleToolKey(char *key, size_t keysize, TexEncodeTask *task, TexSample *sample)
+{
+	byte *data;
+	size_t size;
+	bool allocated;
+	unsigned int hash;
+
+	data = Image_GetUnalignedData(sample->image, &size, &allocated, false);
+	hash = crc32(data, (unsigned int)size);
+	Image_FreeUnalignedData(data, allocated);
+	sprintf_s(key, keysize, "%08x:%ix%ix%i:%s:%s", hash, task->image->width, task->image->height, task->image->bpp, task->format->name, OptionEnumName(task->profile, tex_profiles));
+}
+
+// tool choice index by key, -1 if none
+// tex_toolChoiceMutex should be locked
+int SampleToolChoice(char *key)
+{
+	for (size_t i = 0; i < tex_toolChoices.size(); i++)
+		if (!strcmp(tex_toolChoices[i].key, key))
+			return (int)i;
+	return -1;
+}
+
+// set tool for key, replacing previous choice, so every key is kept once
+// empty tool marks tournament in progress, NULL removes the key
+// tex_toolChoiceMutex should be locked
+void SampleToolChoiceSet(char *key, const char *tool)
+{
+	TexToolChoice choice;
+	int c;
+
+	c = SampleToolChoice(key);
+	if (!tool)
+	{
+		if (c >= 0)
+			tex_toolChoices.erase(tex_toolChoices.begin() + c);
+		return;
+	}
+	memset(&choice, 0, sizeof(choice));
+	strlcpy(choice.key, key, sizeof(choice.key));
+	strlcpy(choice.tool, tool, sizeof(choice.tool));
+	if (c >= 0)
+		tex_toolChoices[c] = choice;
+	else
+		tex_toolChoices.push_back(choice);
+}
+
+// encode sampled blocks with all tools that support format
+// fastest one of those within epsilon of best psnr is used for full encode
+bool TexSample_Tournament(TexEncodeTask *task)
+{
+	vector<TexSampleResult> results;
+	vector<TexSampleResult>::iterator r;
+	vector<TexTool*> tools;
+	TexSampleResult result, *best, *selected;
+	TexSample sample;
+	char key[128];
+	int blocks, c;
+
+	if (!TexSample_Supported(task->format))
+		return false;
+	for (vector<TexTool*>::iterator t = task->codec->tools.begin(); t < task->codec->tools.end(); t++)
+		if ((*t)->fCompress && find((*t)->formats.begin(), (*t)->formats.end(), task->format) != (*t)->formats.end())
+			tools.push_back(*t);
+	if (tools.size() < 2)
+		return false;
+	if (!TexSample_Create(&sample, task->image, 1))
+		return false;
+	blocks = sample.blocks;
+
+	// previous result, same texture may be in tournament on other thread
+	SampleToolKey(key, sizeof(key), task, &sample);
+	while(1)
+	{
+		WaitForSingleObject(tex_toolChoiceMutex, INFINITE);
+		c = SampleToolChoice(key);
+		if (c < 0 || tex_toolChoices[c].tool[0])
+			break;
+		ReleaseMutex(tex_toolChoiceMutex);
+		Sleep(1);
+	}
+	if (c >= 0)
+	{
+		for (vector<TexTool*>::iterator t = tools.begin(); t < tools.end(); t++)
+		{
+			if (!strcmp((*t)->name, tex_toolChoices[c].tool))
+			{
+				task->tool = *t;
+				task->toolSelect = "cached";
+				break;
+			}
+		}
+	}
+	// cached tool may be not available, it's choice is replaced then
+	if (!task->toolSelect)
+		SampleToolChoiceSet(key, "");
+	ReleaseMutex(tex_toolChoiceMutex);
+	if (task->toolSelect)
+	{
+		TexSample_Free(&sample);
+		return true;
+	}
+
+	// play
+	for (vector<TexTool*>::iterator t = tools.begin(); t < tools.end(); t++)
+		if (TexSample_Encode(&sample, task, task->format, *t, &result))
+			results.push_back(result);
+	TexSample_Free(&sample);
+	selected = NULL;
+	if (results.size())
+	{
+		best = &results[0];
+		for (r = results.begin(); r < results.end(); r++)
+			if (r->psnr > best->psnr)
+				best = &(*r);
+		selected = best;
+		for (r = results.begin(); r < results.end(); r++)
+			if (r->psnr >= best->psnr - tex_tournamentEpsilon && r->seconds < selected->seconds)
+				selected = &(*r);
+		for (r = results.begin(); r < results.end(); r++)
+			Verbose("%s: %s:%s on %i sampled blocks: psnr %.2f, %.4fs%s\n", task->file->name.c_str(), r->tool->name, r->format->name, blocks, r->psnr, r->seconds, (&(*r) == selected) ? " (selected)" : "");
+		task->tool = selected->tool;
+		task->toolSelect = "sampled";
+	}
+
+	// remember, failed tournament releases the key
+	WaitForSingleObject(tex_toolChoiceMutex, INFINITE);
+	SampleToolChoiceSet(key, selected ? selected->tool->name : NULL);
+	if (selected)
+		tex_toolChoicesPlayed = true;
+	ReleaseMutex(tex_toolChoiceMutex);
+	return (selected != NULL);
+}
+
+void TexSample_LoadTools(void)
+{
+	char line[1024];
+	TexToolChoice choice;
+	FILE *f;
+
+	if (!tex_toolChoiceMutex)
+		tex_toolChoiceMutex = CreateMutex(NULL, FALSE, NULL);
+	tex_toolChoices.clear();
+	tex_toolChoicesPlayed = false;
+	if (!tex_tournament || !tex_tournamentFile[0])
+		return;
+	f = fopen(tex_tournamentFile, "r");
+	if (!f)
+		return;
+	while(fgets(line, sizeof(line), f) != NULL)
+	{
+		if (line[0] == '#' || (line[0] == '/' && line[1] == '/'))
+			continue;
+		memset(&choice, 0, sizeof(choice));
+		if (sscanf(line, "%127s %63s", choice.key, choice.tool) != 2)
+			continue;
+		// files written before keys were unique may repeat them, last one wins
+		SampleToolChoiceSet(choice.key, choice.tool);
+	}
+	fclose(f);
+	Verbose("Loaded %i tool choices from \"%s\"\n", tex_toolChoices.size(), tex_tournamentFile);
+}
+
+void TexSample_SaveTools(void)
+{
+	FILE *f;
+
+	// nothing new to write when every texture was cached or no tournament ran
+	if (!tex_tournament || !tex_tournamentFile[0] || !tex_toolChoicesPlayed)
+		return;
+	f = fopen(tex_tournamentFile, "w");
+	if (!f)
+	{
+		Warning("TexSample_SaveTools(%s): cannot open file (%s) for writing", tex_tournamentFile, strerror(errno));
+		return;
+	}
+	fprintf(f, "# Tool tournament results (sample hash:size:format:profile, tool)\n");
+	fprintf(f, "# generated automatically, do not modify\n");
+	// keys are unique, tournaments in progress are not written
+	for (vector<TexToolChoice>::iterator c = tex_toolChoices.begin(); c < tex_toolChoices.end(); c++)
+		if (c->tool[0])
+			fprintf(f, "%s %s\n", c->key, c->tool);
+	fclose(f);
+}
@@ -0,0 +1,55 @@
+// tex_sample.h
+#ifndef H_TEX_SAMPLE_H
+#define H_TEX_SAMPLE_H
+
+#include "tex.h"
+
+// sampled blocks
+#define SAMPLE_BLOCK_SIZE   4
+#define SAMPLE_FRACTION     0.03 // share of image blocks to sample
+#define SAMPLE_MIN_BLOCKS   64
+#define SAMPLE_MAX_BLOCKS   4096
+#define SAMPLE_DETAIL_PICKS 2    // prescreen takes most detailed of this many blocks per cell
+
+// blocks picked from image, packed into a small image
+typedef struct
+{
+	LoadedImage *image;  // picked blocks in source color order and colorspace (NULL if image is too small)
+	int          blocks; // number of picked blocks
+	int          total;  // number of blocks in source image
+} TexSample;
+
+// sample encoding result
+typedef struct
+{
+	TexFormat *format;
+	TexTool   *tool;
+	double     psnr;    // lowest of color and alpha psnr
+	double     rms;     // color rms
+	double     average; // color error, as error control sees it
+	double     dispersion;
+	double     bpp;     // bits per pixel of format
+	double     seconds; // encoding time
+} TexSampleResult;
+
+// tool picked by tournament
+typedef struct
+{
+	char key[128]; // content hash, format and profile
+	char tool[64];
+} TexToolChoice;
+
+// util
+bool TexSample_Supported(TexFormat *format);
+bool TexSample_Create(TexSample *sample, LoadedImage *image, int picks);
+void TexSample_Free(TexSample *sample);
+bool TexSample_Encode(TexSample *sample, TexEncodeTask *task, TexFormat *format, TexTool *tool, TexSampleResult *result);
+
+// generic
+bool TexSample_SelectFormat(TexEncodeTask *task);
+TexPrescreen TexSample_Prescreen(TexEncodeTask *task);
+bool TexSample_Tournament(TexEncodeTask *task);
+void TexSample_LoadTools(void);
+void TexSample_SaveTools(void);
+
+#endif
@@ -0,0 +1,453 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / work scheduling
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "tex.h"
+#include <algorithm>
+
+TexSchedule         tex_schedule;
+vector<TexCostRate> tex_costRates;
+HANDLE              tex_costMutex = NULL;
+
+// speeds used until learned from previous runs (megapixels per second)
+#define DEFAULT_LOAD_RATE       50.0
+#define DEFAULT_ENCODE_FAST     10.0
+#define DEFAULT_ENCODE_REGULAR  2.5
+#define DEFAULT_ENCODE_BEST     0.5
+
+// history is faded to this amount of seconds, so table follows tool changes
+#define HISTORY_MAX_SECONDS     3600.0
+
+/*
+==========================================================================================
+
+  Cost rates table
+
+==========================================================================================
+*/
+
+TexCostRate *FindRate(const char *key, bool create)
+{
+	TexCostRate rate;
+
+	for (vector<TexCostRate>::iterator r = tex_costRates.begin(); r < tex_costRates.end(); r++)
+		if (!strcmp(r->key, key))
+			return &(*r);
+	if (!create)
+		return NULL;
+	memset(&rate, 0, sizeof(rate));
+	strlcpy(rate.key, key, sizeof(rate.key));
+	tex_costRates.push_back(rate);
+	return &tex_costRates.back();
+}
+
+void AddRate(const char *key, double mpix, double seconds)
+{
+	TexCostRate *rate;
+
+	if (mpix <= 0 || seconds <= 0)
+		return;
+	WaitForSingleObject(tex_costMutex, INFINITE);
+	rate = FindRate(key, true);
+	rate->mpix += mpix;
+	rate->seconds += seconds;
+	ReleaseMutex(tex_costMutex);
+}
+
+// get speed in megapixels per second
+// keys starting with prefix and ending with suffix are accumulated
+double GetRate(const char *prefix, const char *suffix, double defaultRate)
+{
+	double mpix = 0, seconds = 0;
+	size_t prefixlen, suffixlen, keylen;
+
+	prefixlen = strlen(prefix);
+	suffixlen = suffix ? strlen(suffix) : 0;
+	WaitForSingleObject(tex_costMutex, INFINITE);
+	for (vector<TexCostRate>::iterator r = tex_costRates.begin(); r < tex_costRates.end(); r++)
+	{
+		keylen = strlen(r->key);
+		if (keylen < prefixlen + suffixlen || strncmp(r->key, prefix, prefixlen))
+			continue;
+		if (suffixlen && strcmp(r->key + keylen - suffixlen, suffix))
+			continue;
+		mpix += r->mpix;
+		seconds += r->seconds;
+	}
+	ReleaseMutex(tex_costMutex);
+	if (mpix <= 0 || seconds <= 0)
+		return defaultRate;
+	return mpix / seconds;
+}
+
+double DefaultScaleRate(ImageScaler scaler)
+{
+	if (scaler == IMAGE_SCALER_SUPER2X)
+		return 1.0;
+	if (scaler == IMAGE_SCALER_SBRZ)
+		return 1.5;
+	if (scaler == IMAGE_SCALER_XBRZ)
+		return 3.0;
+	if (scaler == IMAGE_SCALER_SCALE2X)
+		return 25.0;
+	return 15.0;
+}
+
+void ScaleKey(char *key, size_t keysize, ImageScaler scaler, ImageScaler scaler2, int factor)
+{
+	if (factor == 4)
+		sprintf_s(key, keysize, "scale4x:%s:%s", OptionEnumName(scaler, ImageScalers, "unknown"), OptionEnumName(scaler2, ImageScalers, "unknown"));
+	else
+		sprintf_s(key, keysize, "scale2x:%s", OptionEnumName(scaler, ImageScalers, "unknown"));
+}
+
+/*
+==========================================================================================
+
+  Cost model
+
+==========================================================================================
+*/
+
+// predict processing time of a file (seconds), file dimensions should be probed
+double TexSchedule_PredictCost(FS_File *file, texprofile profile)
+{
+	double pixels, scaled, cost, rate;
+	char prefix[128], suffix[128];
+	char *profileName;
+	int scale, w, h;
+
+	if (file->width <= 0 || file->height <= 0)
+		return 0;
+	profileName = OptionEnumName(profile, tex_profiles);
+
+	// scalers
+	scale = 1;
+	if (FS_FileMatchList(file, tex_scale4xFiles.items) || tex_forceScale4x)
+		scale = 4;
+	else if (FS_FileMatchList(file, tex_scale2xFiles.items) || tex_forceScale2x)
+		scale = 2;
+	w = file->width * scale;
+	h = file->height * scale;
+	if (!tex_allowNPOT)
+	{
+		w = NextPowerOfTwo(w);
+		h = NextPowerOfTwo(h);
+	}
+	pixels = (double)file->width * file->height / 1000000.0;
+	scaled = (double)w * h / 1000000.0;
+	if (!tex_noMipmaps)
+		scaled = scaled * 4.0 / 3.0;
+
+	// image is loaded once, scaled and encoded for each codec
+	cost = pixels / DEFAULT_LOAD_RATE;
+	for (TexCodec *codec = tex_active_codecs; codec; codec = codec->nextActive)
+	{
+		if (scale > 1)
+		{
+			ScaleKey(prefix, sizeof(prefix), tex_firstScaler, tex_secondScaler, scale);
+			cost += pixels / GetRate(prefix, NULL, (scale == 4) ? DefaultScaleRate(tex_firstScaler) / 4 : DefaultScaleRate(tex_firstScaler));
+		}
+		rate = DEFAULT_ENCODE_REGULAR;
+		if (profile == PROFILE_FAST)
+			rate = DEFAULT_ENCODE_FAST;
+		else if (profile == PROFILE_BEST)
+			rate = DEFAULT_ENCODE_BEST;
+		if (codec->forceTool)
+			sprintf_s(prefix, sizeof(prefix), "encode:%s:%s:", codec->parmName, codec->forceTool->parmName);
+		else
+			sprintf_s(prefix, sizeof(prefix), "encode:%s:", codec->parmName);
+		sprintf_s(suffix, sizeof(suffix), ":%s", profileName);
+		cost += scaled / GetRate(prefix, suffix, rate);
+	}
+	return cost;
+}
+
+// simulate greedy dispatch of files to threads, return time when last thread finishes
+double SimulateMakespan(vector<FS_File> &files, int num_threads)
+{
+	vector<double> threads;
+	size_t i, j, best;
+
+	threads.resize(max(1, num_threads), 0.0);
+	for (i = 0; i < files.size(); i++)
+	{
+		best = 0;
+		for (j = 1; j < threads.size(); j++)
+			if (threads[j] < threads[best])
+				best = j;
+		threads[best] += files[i].cost;
+	}
+	return *max_element(threads.begin(), threads.end());
+}
+
+bool CompareCost(const FS_File &a, const FS_File &b)
+{
+	return a.cost > b.cost;
+}
+
+void TexSchedule_ProbeThread(ThreadData *thread)
+{
+	vector<FS_File> *files = (vector<FS_File> *)thread->data;
+	int work;
+
+	while(1)
+	{
+		work = GetWorkForThread(thread);
+		if (work == -1)
+			break;
+		Image_Probe(&(*files)[work]);
+	}
+}
+
+// predict costs and sort files in longest-processing-time-first order
+// so big textures does not start last and run alone
+void TexSchedule_Order(vector<FS_File> &files, int num_threads)
+{
+	double avgcost, cost, avgprofile[NUM_PROFILES];
+	size_t i;
+	int p;
+
+	memset(&tex_schedule, 0, sizeof(tex_schedule));
+	tex_schedule.numFiles = files.size();
+	tex_schedule.numThreads = max(1, num_threads);
+	tex_schedule.startTime = I_DoubleTime();
+	if (!files.size())
+		return;
+
+	// costs are only used for ordering, memory budget and deadline
+	// so skip probing when none of them is active (files are left at zero cost)
+	if (!tex_scheduleOrder && tex_memBudget <= 0 && tex_deadline <= 0)
+		return;
+
+	// probe dimensions (IO bound, run on all threads)
+	ParallelThreads(num_threads, files.size(), &files, TexSchedule_ProbeThread);
+
+	// predict
+	// costs for other profiles are only summed, deadline tracking scales requested profile costs by them
+	avgcost = 0;
+	memset(avgprofile, 0, sizeof(avgprofile));
+	for (i = 0; i < files.size(); i++)
+	{
+		files[i].cost = TexSchedule_PredictCost(&files[i], tex_profile);
+		if (files[i].cost > 0)
+		{
+			avgcost += files[i].cost;
+			tex_schedule.numProbed++;
+			for (p = 0; p < NUM_PROFILES; p++)
+			{
+				cost = (p == tex_profile) ? files[i].cost : TexSchedule_PredictCost(&files[i], (texprofile)p);
+				avgprofile[p] += cost;
+				tex_schedule.profileTotal[p] += cost;
+			}
+		}
+	}
+	// files with unknown dimensions get average cost
+	if (tex_schedule.numProbed)
+	{
+		avgcost /= tex_schedule.numProbed;
+		for (p = 0; p < NUM_PROFILES; p++)
+			avgprofile[p] /= tex_schedule.numProbed;
+	}
+	for (i = 0; i < files.size(); i++)
+	{
+		if (files[i].cost <= 0)
+		{
+			files[i].cost = avgcost;
+			for (p = 0; p < NUM_PROFILES; p++)
+				tex_schedule.profileTotal[p] += avgprofile[p];
+		}
+		tex_schedule.predictedTotal += files[i].cost;
+	}
+	tex_schedule.pendingCost = tex_schedule.predictedTotal;
+
+	// sort
+	tex_schedule.scanOrderMakespan = SimulateMakespan(files, num_threads);
+	if (tex_scheduleOrder)
+		stable_sort(files.begin(), files.end(), CompareCost);
+	tex_schedule.predictedMakespan = SimulateMakespan(files, num_threads);
+}
+
+/*
+==========================================================================================
+
+  Deadline
+
+==========================================================================================
+*/
+
+// predicted cost of a file encoded with another profile
+double ProfileCost(double cost, texprofile profile)
+{
+	if (tex_schedule.profileTotal[tex_profile] <= 0)
+		return cost;
+	return cost * tex_schedule.profileTotal[profile] / tex_schedule.profileTotal[tex_profile];
+}
+
+// pick profile for a file that is about to be processed
+// with deadline set, projected finish time is checked using actual speed of finished files
+// and remaining files are switched to faster profiles until it fits (or back to requested one if it fits again)
+texprofile TexSchedule_BeginWork(FS_File *file)
+{
+	double elapsed, speed, remaining;
+	texprofile profile;
+	int p;
+
+	profile = tex_profile;
+	WaitForSingleObject(tex_costMutex, INFINITE);
+	tex_schedule.pendingCost = max(0.0, tex_schedule.pendingCost - file->cost);
+	if (tex_deadline > 0)
+	{
+		elapsed = I_DoubleTime() - tex_schedule.startTime;
+		speed = (tex_schedule.doneCost > 0) ? tex_schedule.doneSeconds / tex_schedule.doneCost : 1.0;
+		for (p = tex_profile; p >= 0; p--)
+		{
+			profile = (texprofile)p;
+			remaining = tex_schedule.runningCost + ProfileCost(tex_schedule.pendingCost + file->cost, profile);
+			if (elapsed + remaining * speed / tex_schedule.numThreads <= tex_deadline)
+				break;
+		}
+		if (profile != tex_profile)
+			tex_schedule.numDegraded++;
+	}
+	tex_schedule.runningCost += ProfileCost(file->cost, profile);
+	ReleaseMutex(tex_costMutex);
+	return profile;
+}
+
+void TexSchedule_EndWork(FS_File *file, texprofile profile, double seconds)
+{
+	double cost;
+
+	cost = ProfileCost(file->cost, profile);
+	WaitForSingleObject(tex_costMutex, INFINITE);
+	tex_schedule.runningCost = max(0.0, tex_schedule.runningCost - cost);
+	tex_schedule.doneCost += cost;
+	tex_schedule.doneSeconds += seconds;
+	ReleaseMutex(tex_costMutex);
+}
+
+/*
+==========================================================================================
+
+  Learning
+
+==========================================================================================
+*/
+
+void TexSchedule_RecordScale(ImageScaler scaler, ImageScaler scaler2, int factor, double mpix, double seconds)
+{
+	char key[128];
+
+	ScaleKey(key, sizeof(key), scaler, scaler2, factor);
+	AddRate(key, mpix, seconds);
+}
+
+void TexSchedule_RecordEncode(TexEncodeTask *task, double seconds)
+{
+	char key[128];
+	double mpix;
+
+	if (!task->image || !task->tool)
+		return;
+	mpix = 0;
+	for (ImageMap *map = task->image->maps; map; map = map->next)
+		mpix += (double)map->width * map->height / 1000000.0;
+	sprintf_s(key, sizeof(key), "encode:%s:%s:%s", task->codec->parmName, task->tool->parmName, OptionEnumName(task->profile, tex_profiles));
+	AddRate(key, mpix, seconds);
+}
+
+// parse time given as seconds or minutes:seconds
+double TexSchedule_ParseTime(const char *str)
+{
+	const char *sep;
+
+	sep = strchr(str, ':');
+	if (sep)
+		return max(0.0, atoi(str) * 60 + atof(sep + 1));
+	return max(0.0, atof(str));
+}
+
+void TexSchedule_Report(double elapsed)
+{
+	if (!tex_schedule.numFiles || !tex_schedule.numProbed)
+		return;
+	Print("  predicted time: %i:%02.1f (%s, %i of %i files probed)\n", (int)(tex_schedule.predictedMakespan / 60), (double)(tex_schedule.predictedMakespan - ((int)(tex_schedule.predictedMakespan / 60)*60)), tex_scheduleOrder ? "largest first" : "scan order", tex_schedule.numProbed, tex_schedule.numFiles);
+	if (tex_scheduleOrder)
+		Print("      scan order: %i:%02.1f predicted\n", (int)(tex_schedule.scanOrderMakespan / 60), (double)(tex_schedule.scanOrderMakespan - ((int)(tex_schedule.scanOrderMakespan / 60)*60)));
+	if (elapsed > 0)
+		Print("  predict/actual: %.2f\n", tex_schedule.predictedMakespan / elapsed);
+	if (tex_deadline > 0)
+	{
+		Print("        deadline: %i:%02.1f %s\n", (int)(tex_deadline / 60), (double)(tex_deadline - ((int)(tex_deadline / 60)*60)), (elapsed > tex_deadline) ? "(missed)" : "(met)");
+		if (tex_schedule.numDegraded)
+			Print("  degraded files: %i (see \"degraded\" in stats file)\n", tex_schedule.numDegraded);
+	}
+}
+
+/*
+==========================================================================================
+
+  Rates file
+
+==========================================================================================
+*/
+
+void TexSchedule_Load(void)
+{
+	char line[1024];
+	TexCostRate rate;
+	FILE *f;
+
+	if (!tex_costMutex)
+		tex_costMutex = CreateMutex(NULL, FALSE, NULL);
+	tex_costRates.clear();
+	if (!tex_scheduleFile[0])
+		return;
+	f = fopen(tex_scheduleFile, "r");
+	if (!f)
+		return;
+	while(fgets(line, sizeof(line), f) != NULL)
+	{
+		if (line[0] == '#' || (line[0] == '/' && line[1] == '/'))
+			continue;
+		memset(&rate, 0, sizeof(rate));
+		if (sscanf(line, "%127s %lf %lf", rate.key, &rate.mpix, &rate.seconds) != 3)
+			continue;
+		if (rate.mpix <= 0 || rate.seconds <= 0)
+			continue;
+		// fade out old history
+		if (rate.seconds > HISTORY_MAX_SECONDS)
+		{
+			rate.mpix = rate.mpix * HISTORY_MAX_SECONDS / rate.seconds;
+			rate.seconds = HISTORY_MAX_SECONDS;
+		}
+		tex_costRates.push_back(rate);
+	}
+	fclose(f);
+	Verbose("Loaded %i cost rates from \"%s\"\n", tex_costRates.size(), tex_scheduleFile);
+}
+
+void TexSchedule_Save(void)
+{
+	FILE *f;
+
+	if (!tex_scheduleFile[0] || !tex_costRates.size())
+		return;
+	f = fopen(tex_scheduleFile, "w");
+	if (!f)
+	{
+		Warning("TexSchedule_Save(%s): cannot open file (%s) for writing", tex_scheduleFile, strerror(errno));
+		return;
+	}
+	fprintf(f, "# Processing speed table (key, megapixels, seconds)\n");
+	fprintf(f, "# generated automatically, do not modify\n");
+	for (vector<TexCostRate>::iterator r = tex_costRates.begin(); r < tex_costRates.end(); r++)
+		fprintf(f, "%s %f %f\n", r->key, r->mpix, r->seconds);
+	fclose(f);
+}
@@ -0,0 +1,49 @@
+// tex_schedule.h
+#ifndef H_TEX_SCHEDULE_H
+#define H_TEX_SCHEDULE_H
+
+#include "tex.h"
+
+// learned processing speed for codec:tool:profile or scaler
+typedef struct
+{
+	char   key[128];
+	double mpix;    // megapixels processed
+	double seconds; // time spent
+} TexCostRate;
+
+// schedule summary
+typedef struct
+{
+	size_t numFiles;
+	size_t numProbed;          // files with known dimensions
+	double predictedMakespan;  // largest-first order
+	double scanOrderMakespan;  // order files was found in
+	double predictedTotal;     // sum of predicted costs
+	int    numThreads;
+
+	// deadline tracking
+	double profileTotal[NUM_PROFILES]; // sum of predicted costs for each profile
+	double startTime;
+	double pendingCost;        // predicted cost of files not started yet (requested profile)
+	double runningCost;        // predicted cost of files being processed (profile they got)
+	double doneCost;           // predicted cost of finished files (profile they got)
+	double doneSeconds;        // time spent on finished files
+	size_t numDegraded;        // files given faster profile than requested
+} TexSchedule;
+
+extern TexSchedule tex_schedule;
+
+// generic
+double TexSchedule_PredictCost(FS_File *file, texprofile profile);
+void   TexSchedule_Order(vector<FS_File> &files, int num_threads);
+texprofile TexSchedule_BeginWork(FS_File *file);
+void   TexSchedule_EndWork(FS_File *file, texprofile profile, double seconds);
+void   TexSchedule_RecordScale(ImageScaler scaler, ImageScaler scaler2, int factor, double mpix, double seconds);
+void   TexSchedule_RecordEncode(TexEncodeTask *task, double seconds);
+void   TexSchedule_Report(double elapsed);
+double TexSchedule_ParseTime(const char *str);
+void   TexSchedule_Load(void);
+void   TexSchedule_Save(void);
+
+#endif
@@ -0,0 +1,308 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / compression statistics
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "tex.h"
+#include <algorithm>
+
+// records are collected in per-thread buffers without locking
+// and written in one go when processing is finished
+// one buffer for each pool thread (workers and central thread)
+vector< vector<TexStatsRecord> > tex_statsBuffers;
+
+// stage timings per codec/tool
+typedef struct
+{
+	TexCodec          *codec;
+	TexTool           *tool;
+	TexStageHistogram  stages[NUM_TEX_STAGES];
+} TexStageTimings;
+
+vector<TexStageTimings> tex_stageTimings;
+HANDLE                  tex_stageTimingsMutex = NULL;
+
+char *tex_stageNames[NUM_TEX_STAGES] =
+{
+	"load",
+	"convert",
+	"scale",
+	"dimensions",
+	"mipmaps",
+	"compress",
+	"errorcalc",
+	"decompress",
+	"sample",
+};
+
+char *TexStats_StageName(TexStage stage)
+{
+	if (stage < 0 || stage >= NUM_TEX_STAGES)
+		return "unknown";
+	return tex_stageNames[stage];
+}
+
+void TexStats_Init(void)
+{
+	tex_statsBuffers.clear();
+	tex_statsBuffers.resize(max(1, numthreads) + 1);
+	if (!tex_stageTimingsMutex)
+		tex_stageTimingsMutex = CreateMutex(NULL, FALSE, NULL);
+	tex_stageTimings.clear();
+}
+
+void TexStats_Add(TexEncodeTask *task, const char *outfile, const char *event, TexCalcErrors *calc)
+{
+	TexStatsRecord rec;
+
+	rec.time = I_DoubleTime();
+	rec.source = task->file ? task->file->fullpath : "";
+	rec.output = outfile ? outfile : "";
+	rec.event = event;
+	rec.codec = task->codec ? task->codec->name : "";
+	rec.tool = task->tool ? task->tool->name : "";
+	rec.format = task->format ? task->format->name : "";
+	rec.block = task->format ? task->format->block->name : "";
+	rec.imageType = task->image ? OptionEnumName((int)task->image->datatype, ImageTypes, "unknown", "bad") : "";
+	rec.profile = OptionEnumName(task->profile, tex_profiles);
+	rec.degraded = task->degraded;
+	rec.toolSelect = task->toolSelect ? task->toolSelect : "";
+	rec.srcWidth = task->file ? task->file->width : 0;
+	rec.srcHeight = task->file ? task->file->height : 0;
+	rec.width = 0;
+	rec.height = 0;
+	rec.mipLevels = 0;
+	if (task->image && task->image->maps)
+	{
+		rec.width = task->image->maps->width;
+		rec.height = task->image->maps->height;
+		for (ImageMap *map = task->image->maps; map; map = map->next)
+			rec.mipLevels++;
+	}
+	rec.passes = task->preprocessPasses;
+	rec.bytesIn = task->inputBytes;
+	rec.bytesOut = task->stream ? task->streamLen : 0;
+	memcpy(rec.times, task->times, sizeof(rec.times));
+	rec.hasErrors = (calc != NULL);
+	rec.average = calc ? calc->average : 0;
+	rec.dispersion = calc ? calc->dispersion : 0;
+	rec.rms = calc ? calc->rms : 0;
+	if (task->threadnum < 0 || task->threadnum >= (int)tex_statsBuffers.size())
+		Error("TexStats_Add: thread %i has no statistics buffer\n", task->threadnum);
+	tex_statsBuffers[task->threadnum].push_back(rec);
+}
+
+/*
+==========================================================================================
+
+  Writing
+
+==========================================================================================
+*/
+
+bool CompareStatsTime(const TexStatsRecord &a, const TexStatsRecord &b)
+{
+	return a.time < b.time;
+}
+
+// quote string for CSV (double quotes are doubled)
+string StatsCSVString(const string &s)
+{
+	string out = "\"";
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '"')
+			out += '"';
+		out += s[i];
+	}
+	return out + "\"";
+}
+
+// quote string for JSON (backslashes of windows paths are escaped)
+string StatsJSONString(const string &s)
+{
+	char hex[8];
+	string out = "\"";
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		if (s[i] == '"' || s[i] == '\\')
+		{
+			out += '\\';
+			out += s[i];
+		}
+		else if ((byte)s[i] < 32)
+		{
+			sprintf_s(hex, sizeof(hex), "\\u%04x", (byte)s[i]);
+			out += hex;
+		}
+		else
+			out += s[i];
+	}
+	return out + "\"";
+}
+
+void WriteStatsCSV(FILE *f, vector<TexStatsRecord> &records)
+{
+	int i;
+
+	fprintf(f, "source,output,event,codec,tool,format,block,imagetype,profile,degraded,toolselect,srcwidth,srcheight,width,height,miplevels,passes,bytesin,bytesout");
+	for (i = 0; i < NUM_TEX_STAGES; i++)
+		fprintf(f, ",time_%s", tex_stageNames[i]);
+	fprintf(f, ",average,dispersion,rms\n");
+	for (vector<TexStatsRecord>::iterator r = records.begin(); r < records.end(); r++)
+	{
+		fprintf(f, "%s,%s,%s,%s,%s,%s,%s,%s,", StatsCSVString(r->source).c_str(), StatsCSVString(r->output).c_str(), StatsCSVString(r->event).c_str(), StatsCSVString(r->codec).c_str(), StatsCSVString(r->tool).c_str(), StatsCSVString(r->format).c_str(), StatsCSVString(r->block).c_str(), StatsCSVString(r->imageType).c_str());
+		fprintf(f, "%s,%i,%s,", StatsCSVString(r->profile).c_str(), r->degraded ? 1 : 0, StatsCSVString(r->toolSelect).c_str());
+		fprintf(f, "%i,%i,%i,%i,%i,%i,%llu,%llu", r->srcWidth, r->srcHeight, r->width, r->height, r->mipLevels, r->passes, (unsigned long long)r->bytesIn, (unsigned long long)r->bytesOut);
+		for (i = 0; i < NUM_TEX_STAGES; i++)
+			fprintf(f, ",%.6f", r->times[i]);
+		if (r->hasErrors)
+			fprintf(f, ",%f,%f,%f\n", r->average, r->dispersion, r->rms);
+		else
+			fprintf(f, ",,,\n");
+	}
+}
+
+void WriteStatsJSON(FILE *f, vector<TexStatsRecord> &records)
+{
+	int i;
+
+	fprintf(f, "[\n");
+	for (vector<TexStatsRecord>::iterator r = records.begin(); r < records.end(); r++)
+	{
+		fprintf(f, "  { \"source\": %s, \"output\": %s, \"event\": %s, ", StatsJSONString(r->source).c_str(), StatsJSONString(r->output).c_str(), StatsJSONString(r->event).c_str());
+		fprintf(f, "\"codec\": %s, \"tool\": %s, \"format\": %s, \"block\": %s, \"imagetype\": %s, ", StatsJSONString(r->codec).c_str(), StatsJSONString(r->tool).c_str(), StatsJSONString(r->format).c_str(), StatsJSONString(r->block).c_str(), StatsJSONString(r->imageType).c_str());
+		fprintf(f, "\"profile\": %s, \"degraded\": %s, \"toolselect\": %s, ", StatsJSONString(r->profile).c_str(), r->degraded ? "true" : "false", StatsJSONString(r->toolSelect).c_str());
+		fprintf(f, "\"srcwidth\": %i, \"srcheight\": %i, \"width\": %i, \"height\": %i, \"miplevels\": %i, \"passes\": %i, \"bytesin\": %llu, \"bytesout\": %llu, ", r->srcWidth, r->srcHeight, r->width, r->height, r->mipLevels, r->passes, (unsigned long long)r->bytesIn, (unsigned long long)r->bytesOut);
+		fprintf(f, "\"times\": { ");
+		for (i = 0; i < NUM_TEX_STAGES; i++)
+			fprintf(f, "%s\"%s\": %.6f", i ? ", " : "", tex_stageNames[i], r->times[i]);
+		fprintf(f, " }");
+		if (r->hasErrors)
+			fprintf(f, ", \"average\": %f, \"dispersion\": %f, \"rms\": %f", r->average, r->dispersion, r->rms);
+		fprintf(f, " }%s\n", (r + 1 < records.end()) ? "," : "");
+	}
+	fprintf(f, "]\n");
+}
+
+// merge thread buffers and write statistics file
+// format is picked by file extension (.json or CSV otherwise)
+void TexStats_Flush(void)
+{
+	vector<TexStatsRecord> records;
+	char ext[MAX_FPATH];
+	FILE *f;
+
+	if (!tex_statsFile[0])
+		return;
+	for (size_t i = 0; i < tex_statsBuffers.size(); i++)
+	{
+		records.insert(records.end(), tex_statsBuffers[i].begin(), tex_statsBuffers[i].end());
+		tex_statsBuffers[i].clear();
+	}
+	stable_sort(records.begin(), records.end(), CompareStatsTime);
+	ExtractFileExtension(tex_statsFile, ext);
+	f = SafeOpenWrite(tex_statsFile);
+	if (!stricmp(ext, "json"))
+		WriteStatsJSON(f, records);
+	else
+		WriteStatsCSV(f, records);
+	fclose(f);
+	Verbose("Written %i statistics records to \"%s\"\n", records.size(), tex_statsFile);
+}
+
+/*
+==========================================================================================
+
+  Stage timings
+
+==========================================================================================
+*/
+
+void TexStats_AddTimings(TexEncodeTask *task)
+{
+	TexStageTimings *timings, add;
+	TexStageHistogram *h;
+	double ms;
+	int i, b;
+
+	if (!task->codec || !task->tool)
+		return;
+	WaitForSingleObject(tex_stageTimingsMutex, INFINITE);
+	timings = NULL;
+	for (vector<TexStageTimings>::iterator t = tex_stageTimings.begin(); t < tex_stageTimings.end(); t++)
+	{
+		if (t->codec == task->codec && t->tool == task->tool)
+		{
+			timings = &(*t);
+			break;
+		}
+	}
+	if (!timings)
+	{
+		memset(&add, 0, sizeof(add));
+		add.codec = task->codec;
+		add.tool = task->tool;
+		tex_stageTimings.push_back(add);
+		timings = &tex_stageTimings.back();
+	}
+	for (i = 0; i < NUM_TEX_STAGES; i++)
+	{
+		if (task->times[i] <= 0)
+			continue;
+		h = &timings->stages[i];
+		h->count++;
+		h->total += task->times[i];
+		h->max = max(h->max, task->times[i]);
+		ms = task->times[i] * 1000.0;
+		for (b = 0; b < STATS_HISTOGRAM_BUCKETS - 1 && ms >= 1.0; b++)
+			ms *= 0.5;
+		h->buckets[b]++;
+	}
+	ReleaseMutex(tex_stageTimingsMutex);
+}
+
+// upper bound of bucket containing given percentile (seconds)
+double HistogramPercentile(TexStageHistogram *h, double percentile)
+{
+	size_t target, sum;
+	int b;
+
+	target = (size_t)ceil(h->count * percentile);
+	sum = 0;
+	for (b = 0; b < STATS_HISTOGRAM_BUCKETS - 1; b++)
+	{
+		sum += h->buckets[b];
+		if (sum >= target)
+			break;
+	}
+	return min(h->max, (double)(1 << b) / 1000.0);
+}
+
+void TexStats_PrintTimings(void)
+{
+	TexStageHistogram *h;
+	char bars[STATS_HISTOGRAM_BUCKETS + 1];
+	int i, b;
+
+	for (vector<TexStageTimings>::iterator t = tex_stageTimings.begin(); t < tex_stageTimings.end(); t++)
+	{
+		Print("%s/%s stage timings:\n", t->codec->name, t->tool->name);
+		Print("       stage  count      total        avg       p50       p90       max  1ms..\n");
+		for (i = 0; i < NUM_TEX_STAGES; i++)
+		{
+			h = &t->stages[i];
+			if (!h->count)
+				continue;
+			// histogram as a row of digits (log10 of bucket count), each next bucket is 2x longer
+			for (b = 0; b < STATS_HISTOGRAM_BUCKETS; b++)
+				bars[b] = h->buckets[b] ? '1' + (char)min(8.0, floor(log10((double)h->buckets[b]))) : '.';
+			bars[b] = 0;
+			Print("  %10s %6i %9.3fs %9.4fs %8.4fs %8.4fs %8.4fs  %s\n", tex_stageNames[i], (int)h->count, h->total, h->total / h->count, HistogramPercentile(h, 0.5), HistogramPercentile(h, 0.9), h->max, bars);
+		}
+	}
+}
@@ -0,0 +1,60 @@
+// tex_stats.h
+#ifndef H_TEX_STATS_H
+#define H_TEX_STATS_H
+
+#include "tex.h"
+
+// a single statistics record
+typedef struct
+{
+	double  time;           // when record was made, used to merge thread buffers
+	string  source;         // source file
+	string  output;         // output file
+	string  event;
+	string  codec;
+	string  tool;
+	string  format;
+	string  block;
+	string  imageType;
+	string  profile;
+	bool    degraded;       // profile was lowered to meet deadline
+	string  toolSelect;     // tool tournament result
+	int     srcWidth;
+	int     srcHeight;
+	int     width;
+	int     height;
+	int     mipLevels;
+	int     passes;         // map preprocessing passes
+	size_t  bytesIn;
+	size_t  bytesOut;
+	double  times[NUM_TEX_STAGES];
+	bool    hasErrors;
+	double  average;
+	double  dispersion;
+	double  rms;
+} TexStatsRecord;
+
+// stage timings histogram (log2 buckets of milliseconds)
+#define STATS_HISTOGRAM_BUCKETS 20
+
+typedef struct
+{
+	size_t count;
+	double total;
+	double max;
+	size_t buckets[STATS_HISTOGRAM_BUCKETS];
+} TexStageHistogram;
+
+// util
+string StatsCSVString(const string &s);
+string StatsJSONString(const string &s);
+
+// generic
+char *TexStats_StageName(TexStage stage);
+void  TexStats_Init(void);
+void  TexStats_Add(TexEncodeTask *task, const char *outfile, const char *event, TexCalcErrors *calc);
+void  TexStats_Flush(void);
+void  TexStats_AddTimings(TexEncodeTask *task);
+void  TexStats_PrintTimings(void);
+
+#endif
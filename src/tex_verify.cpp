@@ -0,0 +1,458 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / batch decompression and verification of compressed files
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include "tex.h"
+#include "freeimage.h"
+
+/*
+==========================================================================================
+
+  Source pairing
+
+==========================================================================================
+*/
+
+// cut suffix from the end of name
+bool VerifyStripSuffix(char *name, const char *suffix)
+{
+	size_t len, slen;
+
+	if (!suffix || !suffix[0])
+		return false;
+	len = strlen(name);
+	slen = strlen(suffix);
+	if (slen >= len || stricmp(name + len - slen, suffix))
+		return false;
+	name[len - slen] = 0;
+	return true;
+}
+
+// cut prefix from the start of path
+bool VerifyStripPrefix(char *path, const char *prefix)
+{
+	size_t len;
+
+	if (!prefix || !prefix[0])
+		return false;
+	len = strlen(prefix);
+	if (strnicmp(path, prefix, len))
+		return false;
+	memmove(path, path + len, strlen(path + len) + 1);
+	return true;
+}
+
+bool VerifyIsContainerFile(const char *ext)
+{
+	for (TexContainer *c = tex_containers; c; c = c->next)
+		if (!stricmp(c->extensionName, ext))
+			return true;
+	return false;
+}
+
+// find source image of compressed file by reversing output naming rules
+// (codec directory, additional path, format/tool/profile suffixes)
+bool VerifyFindSource(FS_File *file, FS_File *source)
+{
+	char path[MAX_FPATH], name[MAX_FPATH], pattern[MAX_FPATH], ext[MAX_FPATH], suffix[MAX_FPATH];
+	size_t best;
+	bool found;
+
+	if (!tex_verifySource[0])
+		return false;
+
+	// path
+	strlcpy(path, file->path.c_str(), sizeof(path));
+	for (TexCodec *codec = tex_codecs; codec; codec = codec->next)
+		if (VerifyStripPrefix(path, codec->destDir))
+			break;
+	VerifyStripPrefix(path, tex_addPath.c_str());
+
+	// suffixes are added in format, sRGB, tool, profile order
+	strlcpy(name, file->name.c_str(), sizeof(name));
+	if (tex_useSuffix & TEXSUFF_PROFILE)
+	{
+		for (OptionList *profile = tex_profiles; profile->name; profile++)
+		{
+			sprintf_s(suffix, sizeof(suffix), "-%s", profile->name);
+			if (VerifyStripSuffix(name, suffix))
+				break;
+		}
+	}
+	if (tex_useSuffix & TEXSUFF_TOOL)
+	{
+		for (TexTool *tool = tex_tools; tool; tool = tool->next)
+			if (VerifyStripSuffix(name, tool->suffix))
+				break;
+	}
+	if (tex_useSuffix & TEXSUFF_FORMAT)
+	{
+		VerifyStripSuffix(name, "_sRGB");
+		// longest matching suffix wins, so "_dxt5" is not taken for "_dxt5_ycocg"
+		best = 0;
+		for (TexFormat *format = tex_formats; format; format = format->next)
+		{
+			if (!format->suffix || strlen(format->suffix) <= best || strlen(format->suffix) >= strlen(name))
+				continue;
+			if (!stricmp(name + strlen(name) - strlen(format->suffix), format->suffix))
+			{
+				best = strlen(format->suffix);
+				strlcpy(suffix, format->suffix, sizeof(suffix));
+			}
+		}
+		if (best)
+			VerifyStripSuffix(name, suffix);
+	}
+
+	// any image with this name which is not a container file
+	sprintf_s(pattern, sizeof(pattern), "%s%s%s.*", tex_verifySource, path, name);
+	found = false;
+#ifdef WIN32
+	WIN32_FIND_DATA n_file;
+	HANDLE hFile = FindFirstFile(pattern, &n_file);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	do
+	{
+		if (n_file.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+		ExtractFileExtension(n_file.cFileName, ext);
+		if (VerifyIsContainerFile(ext))
+			continue;
+		FS_SetFile(source, path, n_file.cFileName);
+		source->basepath = tex_verifySource;
+		found = true;
+		break;
+	}
+	while(FindNextFile(hFile, &n_file) != 0);
+	FindClose(hFile);
+#endif
+	return found;
+}
+
+/*
+==========================================================================================
+
+  Verification
+
+==========================================================================================
+*/
+
+bool VerifyFail(TexVerifyResult *r, const char *message)
+{
+	r->failed = true;
+	r->message = message;
+	return false;
+}
+
+// decode all mip levels, compare base level with source
+bool VerifyDecode(TexVerifyResult *r, TexDecodeTask *task, LoadedImage *original)
+{
+	char message[1024], filepath[MAX_FPATH], outfile[MAX_FPATH];
+	TexCalcErrors *calc;
+	size_t compressedSize;
+	int levels;
+
+	if (!task->container->fReadHeader(task))
+		return VerifyFail(r, task->errorMessage);
+	r->format = task->format->name;
+	r->width = task->width;
+	r->height = task->height;
+	if (!task->codec->fDecode)
+	{
+		sprintf_s(message, sizeof(message), "%s codec does not support decoding of %s format", task->codec->name, task->format->name);
+		return VerifyFail(r, message);
+	}
+
+	levels = 1 + task->numMipmaps;
+	task->image = Image_Create();
+	task->image->width = task->width;
+	task->image->height = task->height;
+	for (int level = 0; level < levels; level++)
+	{
+		// DecompressImage aborts on truncated data, so check it first
+		task->image->bpp = compressedTextureBPP(task->image, task->format, task->container);
+		compressedSize = compressedTextureSize(task->image, task->format, task->container, true, false);
+		if (compressedSize > task->pixeldatasize)
+		{
+			sprintf_s(message, sizeof(message), "level %i data %i is lesser than estimated data size %i", level, (int)task->pixeldatasize, (int)compressedSize);
+			return VerifyFail(r, message);
+		}
+		DecompressImage(task);
+		UnswizzleImage(task);
+		Image_LoadFinish(task->image, false);
+
+		// compare base level
+		if (level == 0 && original)
+		{
+			if (original->width != task->image->width || original->height != task->image->height)
+			{
+				FIBITMAP *scaled = fiRescale(original->bitmap, task->image->width, task->image->height, FILTER_BILINEAR, false);
+				bool oldColorSwap = original->colorSwap;
+				fiBindToImage(scaled, original);
+				original->colorSwap = oldColorSwap;
+			}
+			calc = TexCompressionError(task->format, task->image, original, ERRORMETRIC_AUTO, false);
+			r->hasErrors = true;
+			r->average = calc->average;
+			r->rms = calc->rms;
+			r->psnr = ErrorCalcPSNR(calc);
+			FreeErrorCalc(calc);
+		}
+
+		// export
+		if (tex_verifyTGA)
+		{
+			sprintf_s(filepath, sizeof(filepath), "%s%s%s", tex_srcDir, r->file->path.c_str(), r->file->name.c_str());
+			if (level > 0)
+				sprintf_s(outfile, sizeof(outfile), "%s_%i.tga", filepath, level);
+			else
+				sprintf_s(outfile, sizeof(outfile), "%s.tga", filepath);
+			CreatePath(outfile);
+			Image_ExportTarga(task->image, outfile);
+		}
+		task->pixeldata += compressedSize;
+		task->pixeldatasize -= compressedSize;
+		fiFree(task->image->bitmap);
+		task->image->bitmap = NULL;
+		r->levels++;
+
+		// next mip level
+		if (task->image->width < 2)
+			break;
+		task->image->width = task->image->width / 2;
+		task->image->height = task->image->height / 2;
+	}
+	if (task->pixeldatasize > 0)
+	{
+		sprintf_s(message, sizeof(message), "image data contains %i tail bytes", (int)task->pixeldatasize);
+		r->message = message;
+	}
+	return true;
+}
+
+void VerifyFile(TexVerifyResult *r)
+{
+	TexDecodeTask task;
+	LoadedImage *original;
+	FS_File source;
+	char filename[MAX_FPATH];
+	byte *data;
+
+	memset(&task, 0, sizeof(task));
+	sprintf_s(filename, sizeof(filename), "%s%s.%s", r->file->path.c_str(), r->file->name.c_str(), r->file->ext.c_str());
+	data = FS_LoadFile(r->file, &task.datasize);
+	if (!data)
+	{
+		VerifyFail(r, "cannot load file");
+		return;
+	}
+	r->bytes = task.datasize;
+	task.filename = filename;
+	task.data = data;
+	task.container = findContainerForFile(filename, data, task.datasize);
+	if (!task.container)
+	{
+		VerifyFail(r, "unknown container");
+		mem_free(data);
+		return;
+	}
+	r->container = task.container->name;
+
+	// source image
+	original = NULL;
+	if (VerifyFindSource(r->file, &source))
+	{
+		original = Image_Create();
+		Image_Load(&source, original);
+		if (original->bitmap)
+		{
+			r->source = source.path + source.name + "." + source.ext;
+			original->datatype = IMAGE_COLOR;
+			if (FS_FileMatchList(&source, original, tex_normalMapFiles.items))
+				original->datatype = IMAGE_NORMALMAP;
+		}
+		else
+		{
+			Image_Delete(original);
+			original = NULL;
+		}
+	}
+
+	// decode
+	VerifyDecode(r, &task, original);
+
+	// cleanup
+	if (task.image)
+		Image_Delete(task.image);
+	FreeDecodeTask(&task);
+	if (original)
+		Image_Delete(original);
+	mem_free(data);
+}
+
+void TexVerify_WorkerThread(ThreadData *thread)
+{
+	TexVerifyData *SharedData;
+	TexVerifyResult *r;
+	double start;
+	int work;
+
+	SharedData = (TexVerifyData *)thread->data;
+	while(1)
+	{
+		work = GetWorkForThread(thread);
+		if (work == -1)
+			break;
+		r = &(*SharedData->results)[work];
+		start = I_DoubleTime();
+		VerifyFile(r);
+		r->seconds = I_DoubleTime() - start;
+		InterlockedIncrement(&SharedData->num_verified);
+	}
+}
+
+void TexVerify_MainThread(ThreadData *thread)
+{
+	TexVerifyData *SharedData;
+
+	SharedData = (TexVerifyData *)thread->data;
+	thread->pool->started = true;
+	while(!thread->pool->finished)
+	{
+		if (!noprint)
+			Pacifier(" file %i of %i", SharedData->num_verified, thread->pool->work_num);
+		else
+			PercentPacifier("%i", (int)(((float)SharedData->num_verified / (float)thread->pool->work_num)*100));
+		Sleep(1);
+	}
+	PacifierEnd();
+}
+
+/*
+==========================================================================================
+
+  Report
+
+==========================================================================================
+*/
+
+void VerifyWriteCSV(FILE *f, vector<TexVerifyResult> &results)
+{
+	fprintf(f, "file,container,format,width,height,levels,bytes,status,message,source,average,rms,psnr,time\n");
+	for (vector<TexVerifyResult>::iterator r = results.begin(); r < results.end(); r++)
+	{
+		fprintf(f, "%s,%s,%s,", StatsCSVString(r->file->fullpath).c_str(), StatsCSVString(r->container).c_str(), StatsCSVString(r->format).c_str());
+		fprintf(f, "%i,%i,%i,%llu,%s,%s,%s,", r->width, r->height, r->levels, (unsigned long long)r->bytes, r->failed ? "failed" : "ok", StatsCSVString(r->message).c_str(), StatsCSVString(r->source).c_str());
+		if (r->hasErrors)
+			fprintf(f, "%f,%f,%f,%.6f\n", r->average, r->rms, r->psnr, r->seconds);
+		else
+			fprintf(f, ",,,%.6f\n", r->seconds);
+	}
+}
+
+void VerifyWriteJSON(FILE *f, vector<TexVerifyResult> &results)
+{
+	fprintf(f, "[\n");
+	for (vector<TexVerifyResult>::iterator r = results.begin(); r < results.end(); r++)
+	{
+		fprintf(f, "  { \"file\": %s, \"container\": %s, \"format\": %s, ", StatsJSONString(r->file->fullpath).c_str(), StatsJSONString(r->container).c_str(), StatsJSONString(r->format).c_str());
+		fprintf(f, "\"width\": %i, \"height\": %i, \"levels\": %i, \"bytes\": %llu, \"status\": \"%s\", ", r->width, r->height, r->levels, (unsigned long long)r->bytes, r->failed ? "failed" : "ok");
+		fprintf(f, "\"message\": %s, \"source\": %s, \"time\": %.6f", StatsJSONString(r->message).c_str(), StatsJSONString(r->source).c_str(), r->seconds);
+		if (r->hasErrors)
+			fprintf(f, ", \"average\": %f, \"rms\": %f, \"psnr\": %f", r->average, r->rms, r->psnr);
+		fprintf(f, " }%s\n", (r + 1 < results.end()) ? "," : "");
+	}
+	fprintf(f, "]\n");
+}
+
+bool CompareVerifyPSNR(const TexVerifyResult *a, const TexVerifyResult *b)
+{
+	return a->psnr < b->psnr;
+}
+
+// decode every container file in parallel, optionally compare with source images
+// and write a single report
+int TexVerify(vector<FS_File> &files)
+{
+	vector<TexVerifyResult> results;
+	vector<TexVerifyResult*> worst;
+	TexVerifyResult result;
+	TexVerifyData SharedData;
+	double timeelapsed, rms, psnr;
+	int failed, compared;
+	char ext[MAX_FPATH];
+	FILE *f;
+
+	// results are pre-sized, so each thread writes only its own item
+	for (vector<FS_File>::iterator file = files.begin(); file < files.end(); file++)
+	{
+		result.file = &(*file);
+		result.width = result.height = result.levels = 0;
+		result.bytes = 0;
+		result.failed = result.hasErrors = false;
+		result.average = result.rms = result.psnr = result.seconds = 0;
+		results.push_back(result);
+	}
+	Print("%i files to verify\n", files.size());
+	if (tex_verifySource[0])
+		Print("Pairing with source images from \"%s\"\n", tex_verifySource);
+	SharedData.files = &files;
+	SharedData.results = &results;
+	SharedData.num_verified = 0;
+	timeelapsed = ParallelThreads(numthreads, files.size(), &SharedData, TexVerify_WorkerThread, TexVerify_MainThread);
+
+	// summary
+	failed = compared = 0;
+	rms = psnr = 0;
+	for (vector<TexVerifyResult>::iterator r = results.begin(); r < results.end(); r++)
+	{
+		if (r->failed)
+		{
+			failed++;
+			Print("%s: %s\n", r->file->fullpath.c_str(), r->message.c_str());
+			continue;
+		}
+		if (r->hasErrors)
+		{
+			compared++;
+			rms += r->rms;
+			psnr += r->psnr;
+			worst.push_back(&(*r));
+		}
+	}
+	Print("Verification finished!\n");
+	Print("--------\n");
+	Print("  files verified: %i\n", results.size());
+	Print("          failed: %i\n", failed);
+	Print("    time elapsed: %i:%02.1f\n", (int)(timeelapsed / 60), (double)(timeelapsed - ((int)(timeelapsed / 60)*60)));
+	if (compared)
+	{
+		Print(" paired w/source: %i\n", compared);
+		Print("     average rms: %.4f\n", rms / compared);
+		Print("    average psnr: %.2f\n", psnr / compared);
+		stable_sort(worst.begin(), worst.end(), CompareVerifyPSNR);
+		Print("    lowest psnr:\n");
+		for (size_t i = 0; i < worst.size() && i < 5; i++)
+			Print("      %6.2f %s\n", worst[i]->psnr, worst[i]->file->fullpath.c_str());
+	}
+
+	// report
+	if (tex_verifyReport[0])
+	{
+		ExtractFileExtension(tex_verifyReport, ext);
+		f = SafeOpenWrite(tex_verifyReport);
+		if (!stricmp(ext, "json"))
+			VerifyWriteJSON(f, results);
+		else
+			VerifyWriteCSV(f, results);
+		fclose(f);
+		Print("Verification report written to \"%s\"\n", tex_verifyReport);
+	}
+	return failed ? 1 : 0;
+}
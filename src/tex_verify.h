@@ -0,0 +1,38 @@
+// tex_verify.h
+#ifndef H_TEX_VERIFY_H
+#define H_TEX_VERIFY_H
+
+#include "tex.h"
+
+// verification result for a single compressed file
+typedef struct
+{
+	FS_File    *file;
+	string      container;
+	string      format;
+	int         width;
+	int         height;
+	int         levels;     // decoded mip levels
+	size_t      bytes;
+	bool        failed;
+	string      message;    // failure reason
+	string      source;     // paired source file (empty if not found)
+	bool        hasErrors;
+	double      average;
+	double      rms;
+	double      psnr;
+	double      seconds;
+} TexVerifyResult;
+
+// shared data of verify threads
+typedef struct
+{
+	vector<FS_File> *files;
+	vector<TexVerifyResult> *results;
+	LONG             num_verified;
+} TexVerifyData;
+
+// generic
+int TexVerify(vector<FS_File> &files);
+
+#endif
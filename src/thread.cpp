@@ -11,6 +11,12 @@
 #include "main.h"
 #include "cmd.h"
 
+// number of threads currently processing a work item (all pools)
+volatile LONG thread_busy = 0;
+
+// number of helper threads lent to tools for a single work item
+volatile LONG thread_helpers = 0;
+
 // get a new work for thread
 int	GetWorkForThread(ThreadData *thread)
 {
@@ -25,9 +31,116 @@ int	GetWorkForThread(ThreadData *thread)
 		thread->pool->work_pending++;
 	}
 	ReleaseMutex(thread->pool->work_mutex);
+
+	// track busy threads
+	if (thread->busy && r == -1)
+	{
+		InterlockedDecrement(&thread_busy);
+		thread->busy = false;
+	}
+	else if (!thread->busy && r != -1)
+	{
+		InterlockedIncrement(&thread_busy);
+		thread->busy = true;
+	}
 	return r;
 }
 
+// cores left by work items and given helpers
+// idle cores and helper budget are both counted against physical cores
+int FreeCores(LONG helpers)
+{
+	return num_cpu_cores - (int)thread_busy - (int)helpers;
+}
+
+// number of cores not running any work
+int IdleCores(void)
+{
+	return max(0, FreeCores(thread_helpers));
+}
+
+// shared helper threads budget
+// tools may run own threads only on cores that are not busy with other work items
+int AcquireHelperThreads(int max_helpers)
+{
+	LONG helpers, want;
+
+	if (max_helpers <= 0)
+		return 0;
+	while(1)
+	{
+		helpers = thread_helpers;
+		want = min(max_helpers, FreeCores(helpers));
+		if (want <= 0)
+			return 0;
+		if (InterlockedCompareExchange(&thread_helpers, helpers + want, helpers) == helpers)
+			return (int)want;
+	}
+}
+
+void ReleaseHelperThreads(int helpers)
+{
+	if (helpers > 0)
+		InterlockedExchangeAdd(&thread_helpers, -helpers);
+}
+
+// memory budget admission
+void AcquireMemoryForThread(ThreadData *thread, size_t bytes)
+{
+	ThreadPool *pool = thread->pool;
+	bool admitted;
+
+	ReleaseMemoryForThread(thread);
+	if (!pool->mem_budget)
+		return;
+	while(1)
+	{
+		WaitForSingleObject(pool->work_mutex, INFINITE);
+		admitted = false;
+		if (pool->mem_blocker < 0 || pool->mem_blocker == thread->num)
+		{
+			// big works are run with less neighbours, but never starve
+			if (pool->mem_used == 0 || pool->mem_used + bytes <= pool->mem_budget)
+			{
+				pool->mem_used += bytes;
+				pool->mem_blocker = -1;
+				thread->mem_acquired = bytes;
+				admitted = true;
+			}
+			else
+				pool->mem_blocker = thread->num;
+		}
+		ReleaseMutex(pool->work_mutex);
+		if (admitted)
+			break;
+		Sleep(5);
+	}
+}
+
+void AdjustMemoryForThread(ThreadData *thread, size_t bytes)
+{
+	ThreadPool *pool = thread->pool;
+
+	if (!pool->mem_budget)
+		return;
+	WaitForSingleObject(pool->work_mutex, INFINITE);
+	pool->mem_used = pool->mem_used - thread->mem_acquired + bytes;
+	thread->mem_acquired = bytes;
+	ReleaseMutex(pool->work_mutex);
+}
+
+void ReleaseMemoryForThread(ThreadData *thread)
+{
+	ThreadPool *pool = thread->pool;
+
+	if (!thread->mem_acquired)
+		return;
+	WaitForSingleObject(pool->work_mutex, INFINITE);
+	pool->mem_used -= thread->mem_acquired;
+	thread->mem_acquired = 0;
+	ReleaseMutex(pool->work_mutex);
+}
+
 /*
 ===================================================================
 
@@ -42,6 +155,27 @@ WIN32
 
 int	num_cpu_cores = -1;
 
+// row bands job, caller and helpers take bands until none is left
+typedef struct
+{
+	int           height;
+	int           bands;
+	void         *data;
+	void        (*row_func)(void *data, int yFirst, int yLast);
+	volatile LONG nextBand;
+	volatile LONG pending;  // helper tickets not finished
+	HANDLE        finished; // set by last helper
+}RowsJob;
+
+// persistent row helpers, started on first use
+#define ROWS_QUEUE_SIZE 64
+HANDLE          rows_mutex = NULL;
+HANDLE          rows_tickets = NULL;
+RowsJob        *rows_queue[ROWS_QUEUE_SIZE];
+int             rows_queueHead = 0;
+int             rows_queueTail = 0;
+volatile LONG   rows_started = 0;
+
 void Thread_Init(void)
 {
 	SYSTEM_INFO info;
@@ -50,14 +184,100 @@ void Thread_Init(void)
 	num_cpu_cores = info.dwNumberOfProcessors;
 	if (num_cpu_cores < 1 || num_cpu_cores > 32)
 		num_cpu_cores = 1;
+	if (!rows_mutex)
+		rows_mutex = CreateMutex(NULL, FALSE, NULL);
 }
 
 void Thread_Shutdown(void)
 {
 }
 
+void RowsJobRun(RowsJob *job)
+{
+	int band;
+
+	while((band = InterlockedIncrement(&job->nextBand) - 1) < job->bands)
+		job->row_func(job->data, job->height * band / job->bands, job->height * (band + 1) / job->bands);
+}
+
+DWORD WINAPI RowsHelperThread(LPVOID unused)
+{
+	RowsJob *job;
+
+	while(1)
+	{
+		WaitForSingleObject(rows_tickets, INFINITE);
+		WaitForSingleObject(rows_mutex, INFINITE);
+		job = rows_queue[rows_queueHead];
+		rows_queueHead = (rows_queueHead + 1) % ROWS_QUEUE_SIZE;
+		ReleaseMutex(rows_mutex);
+		RowsJobRun(job);
+		if (InterlockedDecrement(&job->pending) == 0)
+			SetEvent(job->finished);
+	}
+	return 0;
+}
+
+void RowsHelpers_Start(void)
+{
+	DWORD id;
+
+	WaitForSingleObject(rows_mutex, INFINITE);
+	if (!rows_started)
+	{
+		rows_tickets = CreateSemaphore(NULL, 0, ROWS_QUEUE_SIZE, NULL);
+		for (int i = 0; i < num_cpu_cores - 1; i++)
+			CloseHandle(CreateThread(NULL, THREAD_STACK_SIZE, (LPTHREAD_START_ROUTINE)RowsHelperThread, NULL, 0, &id));
+		InterlockedExchange(&rows_started, 1);
+	}
+	ReleaseMutex(rows_mutex);
+}
+
+// process image rows in parallel bands
+// caller is helped by cores taken from helper budget, so busy batch is not oversubscribed
+void ParallelRows(int height, size_t pixels, void *data, void (*row_func)(void *data, int yFirst, int yLast))
+{
+	RowsJob job;
+	int want, helpers, i;
+
+	want = 0;
+	if (pixels >= PARALLEL_ROWS_PIXELS)
+		want = min(num_cpu_cores, height / PARALLEL_ROWS_MIN) - 1;
+	helpers = AcquireHelperThreads(want);
+	if (helpers <= 0)
+	{
+		row_func(data, 0, height);
+		return;
+	}
+	if (!rows_started)
+		RowsHelpers_Start();
+
+	// post tickets
+	job.height = height;
+	job.bands = min((helpers + 1) * 4, height / PARALLEL_ROWS_MIN);
+	job.data = data;
+	job.row_func = row_func;
+	job.nextBand = 0;
+	job.pending = helpers;
+	job.finished = CreateEvent(NULL, TRUE, FALSE, NULL);
+	WaitForSingleObject(rows_mutex, INFINITE);
+	for (i = 0; i < helpers; i++)
+	{
+		rows_queue[rows_queueTail] = &job;
+		rows_queueTail = (rows_queueTail + 1) % ROWS_QUEUE_SIZE;
+	}
+	ReleaseMutex(rows_mutex);
+	ReleaseSemaphore(rows_tickets, helpers, NULL);
+
+	// work along and wait for helpers to leave the job
+	RowsJobRun(&job);
+	WaitForSingleObject(job.finished, INFINITE);
+	CloseHandle(job.finished);
+	ReleaseHelperThreads(helpers);
+}
+
 // run thread in parallel
-double ParallelThreads(int num_threads, int work_count, void *common_data, void(*thread_func)(ThreadData *thread), void(*central_thread)(ThreadData *thread))
+double ParallelThreads(int num_threads, int work_count, void *common_data, void(*thread_func)(ThreadData *thread), void(*central_thread)(ThreadData *thread), size_t mem_budget)
 {
 	double start;
 	ThreadPool pool = { 0 };
@@ -78,6 +298,9 @@ double ParallelThreads(int num_threads, int work_count, void *common_data, void(
 	pool.work_num = work_count;
 	pool.work_pending = 0;
 	pool.work_mutex = CreateMutex(NULL, FALSE, NULL);
+	pool.mem_budget = mem_budget;
+	pool.mem_used = 0;
+	pool.mem_blocker = -1;
 	pool.threads_num = max(1, min(num_threads, work_count)) + startThread;
 	pool.threads = mem_alloc(sizeof(ThreadData) * pool.threads_num);
 	memset(pool.threads, 0, sizeof(ThreadData) * pool.threads_num);
@@ -9,6 +9,10 @@
 #define	MAX_THREADS 32
 #define THREAD_STACK_SIZE (4 * 1024 * 1024)
 
+// images with more pixels are split into row bands for idle cores
+#define PARALLEL_ROWS_PIXELS (64 * 1024)
+#define PARALLEL_ROWS_MIN    16 // min rows in band
+
 extern int num_cpu_cores;
 
 typedef struct 
@@ -23,6 +27,11 @@ typedef struct
 	bool   stop;         // stop all threads, this only can be set before started mark
 	bool   started;      // central thread is started
 	bool   finished;     // work threads are finished
+
+	// memory budget admission (0 - unlimited)
+	size_t mem_budget;   // max sum of memory acquired by threads
+	size_t mem_used;     // memory acquired by threads
+	int    mem_blocker;  // thread waiting for a big chunk, holds admission of others (-1 - none)
 }ThreadPool;
 
 typedef struct
@@ -31,6 +40,8 @@ typedef struct
 	int         num;    // thread num (0 - number of threads)
 	HANDLE      handle; // thread handle
 	ThreadPool *pool;   // pointer to shared thread pool
+	size_t      mem_acquired; // memory acquired from pool budget
+	bool        busy;         // processing a work item
 
 	// shared data
 	void       *data;   
@@ -39,8 +50,26 @@ typedef struct
 // get a new work for thread
 int	GetWorkForThread(ThreadData *thread);
 
+// memory budget admission
+// blocks until work fits into pool memory budget, work is always admitted if no other memory is acquired
+void AcquireMemoryForThread(ThreadData *thread, size_t bytes);
+void ReleaseMemoryForThread(ThreadData *thread);
+// replace acquired amount without waiting (estimate became known)
+void AdjustMemoryForThread(ThreadData *thread, size_t bytes);
+
+// number of cores not running any work
+int IdleCores(void);
+
+// helper threads budget (for tools with own multithreading)
+// returns number of helper threads granted (0 - run single-threaded), they should be released after encoding
+int  AcquireHelperThreads(int max_helpers);
+void ReleaseHelperThreads(int helpers);
+
+// process image rows in parallel bands, row_func should handle [yFirst, yLast)
+void ParallelRows(int height, size_t pixels, void *data, void (*row_func)(void *data, int yFirst, int yLast));
+
 // run thread in parallel
-double ParallelThreads(int num_threads, int work_count, void *common_data, void(*thread_func)(ThreadData *thread), void(*central_thread)(ThreadData *thread) = NULL);
+double ParallelThreads(int num_threads, int work_count, void *common_data, void(*thread_func)(ThreadData *thread), void(*central_thread)(ThreadData *thread) = NULL, size_t mem_budget = 0);
 
 // init threading system
 void Thread_Init(void);
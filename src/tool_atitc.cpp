@@ -145,10 +145,10 @@ bool ATITC_Compress(TexEncodeTask *t)
 
 	// get options
 	options.nAlphaThreshold = 127;
-	options.nCompressionSpeed = atitc_compressionSpeed[tex_profile];
+	options.nCompressionSpeed = atitc_compressionSpeed[t->profile];
 	options.bUseAdaptiveWeighting = atitc_useAdaptiveWeighting;
 	options.bUseChannelWeighting = false;
-	options.bDisableMultiThreading = (tex_mode == TEXMODE_DROP_FILE) ? false : true;
+	options.bDisableMultiThreading = true; // enabled per map if there are idle cores
 	options.dwSize = sizeof(options);
 	if (t->format == &F_DXT5_RXGB)
 	{
@@ -210,8 +210,17 @@ bool ATITC_Compress(TexEncodeTask *t)
 	dst.pData = stream;
 	for (ImageMap *map = t->image->maps; map; map = map->next)
 	{
+		// library spawns a thread per core, so it is only allowed when most cores are idle
+		int helpers = AcquireHelperThreads(num_cpu_cores - 1);
+		if (helpers < num_cpu_cores / 2)
+		{
+			ReleaseHelperThreads(helpers);
+			helpers = 0;
+		}
+		options.bDisableMultiThreading = helpers ? false : true;
 		dst.pData = stream;
 		res = AtiCompressData(&src, &dst, map->data, map->width, map->height, &options, compress, t->image->bpp);
+		ReleaseHelperThreads(helpers);
 		if (res != ATI_TC_OK)
 			break;
 		stream += dst.dwDataSize;
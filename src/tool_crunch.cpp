@@ -25,6 +25,8 @@ TexTool TOOL_CRUNCH =
 // tool options
 crn_dxt_quality         crnlib_speed[NUM_PROFILES];
 crn_dxt_compressor_type crnlib_compressor_type;
+uint                    crnlib_quality;
+float                   crnlib_bitrate;
 OptionList              crnlib_speedOption[] = 
 { 
 	{ "superfast", cCRNDXTQualitySuperFast }, 
@@ -57,6 +59,8 @@ void Crunch_Init(void)
 	crnlib_speed[PROFILE_REGULAR] = cCRNDXTQualityBetter;
 	crnlib_speed[PROFILE_BEST]    = cCRNDXTQualityUber;
 	crnlib_compressor_type        = cCRNDXTCompressorCRN;
+	crnlib_quality                = cCRNMaxQualityLevel;
+	crnlib_bitrate                = 0;
 }
 
 void Crunch_Option(const char *group, const char *key, const char *val, const char *filename, int linenum)
@@ -86,6 +90,10 @@ void Crunch_Option(const char *group, const char *key, const char *val, const ch
 			else
 				crnlib_compressor_type = cCRNDXTCompressorCRN; 
 		}
+		else if (!stricmp(key, "quality"))
+			crnlib_quality = (uint)min(max(0, atoi(val)), cCRNMaxQualityLevel);
+		else if (!stricmp(key, "bitrate"))
+			crnlib_bitrate = max(0.0f, (float)atof(val));
 		else
 			Warning("%s:%i: unknown key '%s'", filename, linenum, key);
 		return;
@@ -99,6 +107,25 @@ void Crunch_Load(void)
 	if (CheckParm("-crnf"))    crnlib_compressor_type = cCRNDXTCompressorCRNF;
 	// COMMANDLINEPARM: -ryg:  CrnLib: select RYG compressor
 	if (CheckParm("-ryg"))     crnlib_compressor_type = cCRNDXTCompressorRYG;
+	for (int i = 1; i < myargc; i++)
+	{
+		// COMMANDLINEPARM: -crnquality: CrnLib: quality level 0-255, lower values make clustered DXT (DDS/KTX) or smaller .crn files
+		if (!stricmp(myargv[i], "-crnquality"))
+		{
+			i++;
+			if (i < myargc)
+				crnlib_quality = (uint)min(max(0, atoi(myargv[i])), cCRNMaxQualityLevel);
+			continue;
+		}
+		// COMMANDLINEPARM: -crnbitrate: CrnLib: target bits per texel, overrides quality level
+		if (!stricmp(myargv[i], "-crnbitrate"))
+		{
+			i++;
+			if (i < myargc)
+				crnlib_bitrate = max(0.0f, (float)atof(myargv[i]));
+			continue;
+		}
+	}
 	// note options
 	if (crnlib_compressor_type != cCRNDXTCompressorCRN)
 	{
@@ -107,6 +134,12 @@ void Crunch_Load(void)
 		else if (crnlib_compressor_type == cCRNDXTCompressorRYG)
 			Print("%s: using RYG compressor\n", TOOL_CRUNCH.name);
 	}
+	if (crnlib_bitrate > 0)
+		Print("%s: targeting %.2f bits per texel\n", TOOL_CRUNCH.name, crnlib_bitrate);
+	else if (crnlib_quality < cCRNMaxQualityLevel)
+		Print("%s: using quality level %i\n", TOOL_CRUNCH.name, crnlib_quality);
+	if (tex_container != &CONTAINER_CRN && (crnlib_bitrate > 0 || crnlib_quality < cCRNMaxQualityLevel))
+		Print("%s: generating clustered (rate-distortion optimized) DXT\n", TOOL_CRUNCH.name);
 }
 
 const char *Crunch_Version(void)
@@ -124,52 +157,64 @@ const char *Crunch_Version(void)
 ==========================================================================================
 */
 
-size_t Crunch_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth, int imageheight, byte *imagedata)
+// common compression parameters
+bool Crunch_SetOptions(crn_comp_params *options, TexEncodeTask *t)
 {
-	crn_comp_params options;
-	crn_uint32 quality_level = 0;
-    crn_uint32 output_size = 0;
-	float actual_bitrate = 0;
-	byte *output_data;
-
-	// set options
-	options.clear();
-	options.m_width = imagewidth;
-	options.m_height = imageheight;
-	options.m_pImages[0][0] = (crn_uint32 *)imagedata;
-	options.set_flag(cCRNCompFlagPerceptual, true); // crnlib non-perceptural mode looks worse
+	options->clear();
+	options->set_flag(cCRNCompFlagPerceptual, true); // crnlib non-perceptural mode looks worse
 	if (t->image->datatype == IMAGE_GRAYSCALE)
-		options.set_flag(cCRNCompFlagGrayscaleSampling, true);
+		options->set_flag(cCRNCompFlagGrayscaleSampling, true);
 	else
-		options.set_flag(cCRNCompFlagGrayscaleSampling, false);
-	options.set_flag(cCRNCompFlagUseBothBlockTypes, true);
-	options.set_flag(cCRNCompFlagHierarchical, true);
-	options.m_file_type = cCRNFileTypeDDS;
-	options.m_quality_level = cCRNMaxQualityLevel;
-	options.m_dxt1a_alpha_threshold = 128;
-	options.m_dxt_quality = crnlib_speed[tex_profile];
-	options.m_dxt_compressor_type = crnlib_compressor_type;
-	options.m_num_helper_threads = (tex_mode == TEXMODE_DROP_FILE) ? (numthreads - 1): 0;
+		options->set_flag(cCRNCompFlagGrayscaleSampling, false);
+	options->set_flag(cCRNCompFlagUseBothBlockTypes, true);
+	options->set_flag(cCRNCompFlagHierarchical, true);
+	// quality below maximum or target bitrate gives clustered DXT (compresses better with zip/zstd)
+	options->m_quality_level = crnlib_quality;
+	options->m_target_bitrate = crnlib_bitrate;
+	options->m_dxt1a_alpha_threshold = 128;
+	options->m_dxt_quality = crnlib_speed[t->profile];
+	options->m_dxt_compressor_type = crnlib_compressor_type;
+	options->m_num_helper_threads = 0; // set from helper threads budget right before compressing
 	if (t->format->block == &B_DXT1)
 	{
-		options.m_format = cCRNFmtDXT1;
+		options->m_format = cCRNFmtDXT1;
 		if (t->image->hasAlpha)
-			options.set_flag(cCRNCompFlagDXT1AForTransparency, true);
+			options->set_flag(cCRNCompFlagDXT1AForTransparency, true);
 		else
-			options.set_flag(cCRNCompFlagDXT1AForTransparency, false);
+			options->set_flag(cCRNCompFlagDXT1AForTransparency, false);
 	}
 	else if (t->format->block == &B_DXT2 || t->format->block == &B_DXT3)
-		options.m_format = cCRNFmtDXT3;
+		options->m_format = cCRNFmtDXT3;
 	else if (t->format->block == &B_DXT4 || t->format->block == &B_DXT5)
-		options.m_format = cCRNFmtDXT5;
+		options->m_format = cCRNFmtDXT5;
 	else
+		return false;
+	return true;
+}
+
+size_t Crunch_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth, int imageheight, byte *imagedata)
+{
+	crn_comp_params options;
+	crn_uint32 quality_level = 0;
+    crn_uint32 output_size = 0;
+	float actual_bitrate = 0;
+	byte *output_data;
+
+	// set options
+	if (!Crunch_SetOptions(&options, t))
 	{
 		Warning("CrnLib: %s%s.dds - unsupported compression %s/%s", t->file->path.c_str(), t->file->name.c_str(), t->format->name, t->format->block->name);
 		return 0;
 	}
+	options.m_width = imagewidth;
+	options.m_height = imageheight;
+	options.m_pImages[0][0] = (crn_uint32 *)imagedata;
+	options.m_file_type = cCRNFileTypeDDS;
 
-	// compress
+	// compress, idle cores help
+	options.m_num_helper_threads = AcquireHelperThreads(cCRNMaxHelperThreads);
 	output_data = (byte *)crn_compress(options, output_size, &quality_level, &actual_bitrate);
+	ReleaseHelperThreads(options.m_num_helper_threads);
 	if (output_data)
 	{
 		output_size -= DDS_HEADER_SIZE; // crnlib generates data with DDS header
@@ -181,10 +226,50 @@ size_t Crunch_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth
 	return 0;
 }
 
+// compress all maps to .crn file, returns allocated file data
+byte *Crunch_CompressFile(TexEncodeTask *t, size_t *outsize)
+{
+	crn_comp_params options;
+	crn_uint32 output_size = 0;
+	byte *output_data, *data;
+	ImageMap *map;
+	uint level;
+
+	if (!Crunch_SetOptions(&options, t) || options.m_format == cCRNFmtDXT3)
+		Error("CrnLib: %s%s.crn - %s format cannot be stored in .crn file\n", t->file->path.c_str(), t->file->name.c_str(), t->format->name);
+	if (t->image->width > cCRNMaxLevelResolution || t->image->height > cCRNMaxLevelResolution)
+		Error("CrnLib: %s%s.crn - .crn file cannot be larger than %ix%i\n", t->file->path.c_str(), t->file->name.c_str(), cCRNMaxLevelResolution, cCRNMaxLevelResolution);
+	options.m_file_type = cCRNFileTypeCRN;
+	options.m_width = t->image->width;
+	options.m_height = t->image->height;
+	for (map = t->image->maps, level = 0; map && level < cCRNMaxLevels; map = map->next, level++)
+		options.m_pImages[0][level] = (crn_uint32 *)map->data;
+	options.m_levels = level;
+	// keep exact format (swizzled DXT5, DXT1A) and colorspace for decoding
+	options.m_userdata0 = t->format->fourCC;
+	options.m_userdata1 = ((t->format->features & FF_ALPHA) ? CRN_USERDATA_ALPHA : 0) | (t->image->maps->sRGB ? CRN_USERDATA_SRGB : 0) | ((t->image->datatype == IMAGE_NORMALMAP) ? CRN_USERDATA_NORMALMAP : 0);
+
+	// compress, idle cores help
+	options.m_num_helper_threads = AcquireHelperThreads(cCRNMaxHelperThreads);
+	output_data = (byte *)crn_compress(options, output_size);
+	ReleaseHelperThreads(options.m_num_helper_threads);
+	if (!output_data)
+		Error("CrnLib: %s%s.crn - compressor failed\n", t->file->path.c_str(), t->file->name.c_str());
+	data = (byte *)mem_alloc(output_size);
+	memcpy(data, output_data, output_size);
+	crn_free_block(output_data);
+	*outsize = output_size;
+	return data;
+}
+
 bool Crunch_Compress(TexEncodeTask *t)
 {
 	size_t output_size;
 
+	// .crn file is made of all levels at once by container (CRN_PackStream)
+	if (t->container == &CONTAINER_CRN)
+		return true;
+
 	// compress
 	byte *stream = t->stream;
 	for (ImageMap *map = t->image->maps; map; map = map->next)
@@ -194,4 +279,4 @@ bool Crunch_Compress(TexEncodeTask *t)
 			stream += output_size;
 	}
 	return true;
-}
\ No newline at end of file
+}
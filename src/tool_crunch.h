@@ -9,6 +9,7 @@ void Crunch_Option(const char *group, const char *key, const char *val, const ch
 void Crunch_Load(void);
 bool Crunch_Compress(TexEncodeTask *task);
 const char *Crunch_Version(void);
+byte *Crunch_CompressFile(TexEncodeTask *task, size_t *outsize);
 
 extern TexTool TOOL_CRUNCH;
 
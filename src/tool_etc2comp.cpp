@@ -90,8 +90,6 @@ typedef struct compressOptions_t
 	Etc::Image::Format format;
 	Etc::ErrorMetric errorMetric;
 	float effortLevel;
-	int minThreads;
-	int maxThreads;
 } compressOptions_t;
 
 // compress texture
@@ -102,10 +100,12 @@ size_t Etc2Comp_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewid
 	for (byte *dataend = &imagedata[imagewidth * imageheight * 4]; imagedata < dataend; imagedata += 4)
 		*floatPixel++ = Etc::ColorFloatRGBA::ConvertFromRGBA8(imagedata[0], imagedata[1], imagedata[2], imagedata[3]);
 
-	// encode ETC2
+	// encode ETC2, idle cores help
 	Etc::Image image((float *)floatPixels, imagewidth, imageheight, options->errorMetric);
 	image.m_bVerboseOutput = false;
-	Etc::Image::EncodingStatus status = image.Encode(options->format, options->errorMetric, options->effortLevel, options->minThreads, options->maxThreads);
+	int helpers = AcquireHelperThreads(MAX_THREADS - 1);
+	Etc::Image::EncodingStatus status = image.Encode(options->format, options->errorMetric, options->effortLevel, 1 + helpers, 1 + helpers);
+	ReleaseHelperThreads(helpers);
 	if (status >= Etc::Image::EncodingStatus::ERROR_THRESHOLD)
 	{
 		Error("Etc2Comp: %s%s.dds - compression failed with status %s", t->file->path.c_str(), t->file->name.c_str(), Etc::ImageStatusName(status));
@@ -127,9 +127,7 @@ bool Etc2Comp_Compress(TexEncodeTask *t)
 	compressOptions_t options;
 
 	// set options
-	options.minThreads = 1;
-	options.maxThreads = 1;
-	options.effortLevel = etc2comp_effortLevel[tex_profile];
+	options.effortLevel = etc2comp_effortLevel[t->profile];
 	if (t->format->block == &B_ETC1)
 		options.format = Etc::Image::Format::ETC1;
 	else if (t->format->block == &B_ETC2)
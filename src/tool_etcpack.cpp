@@ -253,20 +253,20 @@ void ETCPack_WriteAlphaBlock(byte **stream, byte *alphadata)
 }
 
 // compress ETC1 RGB block
-void ETCPack_CompressBlockETC1(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y)
+void ETCPack_CompressBlockETC1(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y, bool exhaustive)
 {
 	unsigned int block1, block2;
 
 	if (etcpack_linearcolormetric)
 	{
-		if (etcpack_speed[tex_profile])
+		if (exhaustive)
 			etcpack_compressBlockETC1Exhaustive(imagedata, decoded, w, h, x, y, block1, block2);
 		else
 			etcpack_compressBlockDiffFlipFast(imagedata, decoded, w, h, x, y, block1, block2);
 	}
 	else
 	{
-		if (etcpack_speed[tex_profile])
+		if (exhaustive)
 			etcpack_compressBlockETC1ExhaustivePerceptual(imagedata, decoded, w, h, x, y, block1, block2);
 		else
 			etcpack_compressBlockDiffFlipFastPerceptual(imagedata, decoded, w, h, x, y, block1, block2);
@@ -275,21 +275,21 @@ void ETCPack_CompressBlockETC1(byte **stream, byte *imagedata, byte *imagealpha,
 }
 
 // compress ETC2 RGB block
-void ETCPack_CompressBlockETC2(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y)
+void ETCPack_CompressBlockETC2(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y, bool exhaustive)
 {
 	unsigned int block1, block2;
 
 	// compress color block
 	if (etcpack_linearcolormetric)
 	{
-		if (etcpack_speed[tex_profile])
+		if (exhaustive)
 			etcpack_compressBlockETC2Exhaustive(imagedata, decoded, w, h, x, y, block1, block2);
 		else
 			etcpack_compressBlockETC2Fast(imagedata, NULL, decoded, w, h, x, y, block1, block2);
 	}
 	else
 	{
-		if (etcpack_speed[tex_profile])
+		if (exhaustive)
 			etcpack_compressBlockETC2ExhaustivePerceptual(imagedata, decoded, w, h, x, y, block1, block2);
 		else
 			etcpack_compressBlockETC2FastPerceptual(imagedata, decoded, w, h, x, y, block1, block2);
@@ -298,7 +298,7 @@ void ETCPack_CompressBlockETC2(byte **stream, byte *imagedata, byte *imagealpha,
 }
 
 // compress ETC2 RGBA block
-void ETCPack_CompressBlockETC2A(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y)
+void ETCPack_CompressBlockETC2A(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y, bool exhaustive)
 {
 	unsigned int block1, block2;
 	byte alphadata[8];
@@ -306,21 +306,21 @@ void ETCPack_CompressBlockETC2A(byte **stream, byte *imagedata, byte *imagealpha
 	// compress color block
 	if (etcpack_linearcolormetric)
 	{
-		if (etcpack_speed[tex_profile])
+		if (exhaustive)
 			etcpack_compressBlockETC2Exhaustive(imagedata, decoded, w, h, x, y, block1, block2);
 		else
 			etcpack_compressBlockETC2Fast(imagedata, NULL, decoded, w, h, x, y, block1, block2);
 	}
 	else
 	{
-		if (etcpack_speed[tex_profile])
+		if (exhaustive)
 			etcpack_compressBlockETC2ExhaustivePerceptual(imagedata, decoded, w, h, x, y, block1, block2);
 		else
 			etcpack_compressBlockETC2FastPerceptual(imagedata, decoded, w, h, x, y, block1, block2);
 	}
 
 	// compress and write EAC block
-	if (etcpack_speed[tex_profile])
+	if (exhaustive)
 		etcpack_compressBlockAlphaSlow(imagealpha, x, y, w, h, alphadata);
 	else
 		etcpack_compressBlockAlphaFast(imagealpha, x, y, w, h, alphadata);
@@ -330,7 +330,7 @@ void ETCPack_CompressBlockETC2A(byte **stream, byte *imagedata, byte *imagealpha
 }
 
 // compress ETC2 RGBA1 block
-void ETCPack_CompressBlockETC2A1(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y)
+void ETCPack_CompressBlockETC2A1(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y, bool exhaustive)
 {
 	unsigned int block1, block2;
 
@@ -340,13 +340,15 @@ void ETCPack_CompressBlockETC2A1(byte **stream, byte *imagedata, byte *imagealph
 	ETCPack_WriteColorBlock(stream, block1, block2);
 }
 
-size_t ETCPack_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth, int imageheight, byte *imagedata, void (*compressBlockFunction)(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y))
+size_t ETCPack_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth, int imageheight, byte *imagedata, void (*compressBlockFunction)(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y, bool exhaustive))
 {
 	byte *data, *dec, *src, *src_alpha, *block_src, *block_src_alpha, *block_dec;
 	int resized, x, y, w, h;
+	bool exhaustive;
 	size_t out = 0;
 	
 	resized = 0;
+	exhaustive = etcpack_speed[t->profile] ? true : false;
 	data = stream;
 	ETCPack_Prepare(imagedata, imagewidth, imageheight, t->image->bpp, &src, &src_alpha, &w, &h, &dec, &resized, (compressBlockFunction == ETCPack_CompressBlockETC2A1) ? true : false);
 	block_src = src;
@@ -354,14 +356,14 @@ size_t ETCPack_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidt
 	block_dec = dec;
 	for (y = 0; y < h / 4; y++)
 		for (x = 0; x < w / 4; x++)
-			compressBlockFunction(&data, block_src, block_src_alpha, block_dec, w, h, x*4, y*4);
+			compressBlockFunction(&data, block_src, block_src_alpha, block_dec, w, h, x*4, y*4, exhaustive);
 	ETCPack_Free(src, src_alpha, dec, resized);
 	return data - stream;
 }
 
 bool ETCPack_Compress(TexEncodeTask *t)
 {
-	void (*compressBlockFunction)(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y);
+	void (*compressBlockFunction)(byte **stream, byte *imagedata, byte *imagealpha, byte *decoded, int w, int h, int x, int y, bool exhaustive);
 	size_t output_size;
 
 	// options
@@ -132,7 +132,7 @@ bool NvDXTLib_Compress(TexEncodeTask *t)
 	// options
 	options.SetDefaultOptions();
 	options.DoNotGenerateMIPMaps();
-	options.SetQuality(nvdxtlib_quality[tex_profile], 200);
+	options.SetQuality(nvdxtlib_quality[t->profile], 200);
 	options.bDitherColor = nvdxtlib_dithering;
 	options.user_data = &writeOptions;
 	if (t->format->block == &B_DXT1)
@@ -205,7 +205,7 @@ bool NvTT_Compress_Task(TexEncodeTask *t, nvtt::Quality quality, bool dithering)
 
 bool NvTT_Compress(TexEncodeTask *t)
 {
-	return NvTT_Compress_Task(t, nvtt_quality[tex_profile], nvtt_dithering);
+	return NvTT_Compress_Task(t, nvtt_quality[t->profile], nvtt_dithering);
 }
 
 /*
@@ -266,7 +266,7 @@ void NvTT_NvDXTLib_Load(void)
 
 bool NvTT_NvDXTLib_Compress(TexEncodeTask *t)
 {
-	return NvTT_Compress_Task(t, nvdxtlib_quality[tex_profile], nvdxtlib_dithering);
+	return NvTT_Compress_Task(t, nvdxtlib_quality[t->profile], nvdxtlib_dithering);
 }
 
 TexTool TOOL_NVDXTLIB =
@@ -185,37 +185,37 @@ size_t PVRTex_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth
 	}
 	if (t->format->block == &B_ETC1)
 	{
-		quality = pvrtex_quality_etc[tex_profile];
+		quality = pvrtex_quality_etc[t->profile];
 		pixeltype = pvrtex_pixeltype_etc1;
 	}
 	else if (t->format->block == &B_ETC2)
 	{
-		quality = pvrtex_quality_etc[tex_profile];
+		quality = pvrtex_quality_etc[t->profile];
 		pixeltype = pvrtex_pixeltype_etc2rgb;
 	}
 	else if (t->format->block == &B_ETC2A)
 	{
-		quality = pvrtex_quality_etc[tex_profile];
+		quality = pvrtex_quality_etc[t->profile];
 		pixeltype = pvrtex_pixeltype_etc2rgba;
 	}
 	else if (t->format->block == &B_ETC2A1)
 	{
-		quality = pvrtex_quality_etc[tex_profile];
+		quality = pvrtex_quality_etc[t->profile];
 		pixeltype = pvrtex_pixeltype_etc2rgba1;
 	}
 	else if (t->format->block == &B_EAC1)
 	{
-		quality = pvrtex_quality_etc[tex_profile];
+		quality = pvrtex_quality_etc[t->profile];
 		pixeltype = pvrtex_pixeltype_eac1;
 	}
 	else if (t->format->block == &B_EAC2)
 	{
-		quality = pvrtex_quality_etc[tex_profile];
+		quality = pvrtex_quality_etc[t->profile];
 		pixeltype = pvrtex_pixeltype_eac2;
 	}
 	else if (t->format->block == &B_PVRTC_2BPP_RGB || t->format->block == &B_PVRTC_2BPP_RGBA)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		if (t->image->hasAlpha)
 			pixeltype = pvrtex_pixeltype_pvrtc_2bpp_rgba;
 		else
@@ -223,7 +223,7 @@ size_t PVRTex_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth
 	}
 	else if (t->format->block == &B_PVRTC_4BPP_RGB || t->format->block == &B_PVRTC_4BPP_RGBA)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		if (t->image->hasAlpha)
 			pixeltype = pvrtex_pixeltype_pvrtc_4bpp_rgba;
 		else
@@ -231,32 +231,32 @@ size_t PVRTex_CompressSingleImage(byte *stream, TexEncodeTask *t, int imagewidth
 	}
 	else if (t->format->block == &B_PVRTC2_2BPP)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		pixeltype = pvrtex_pixeltype_pvrtc2_2bpp;
 	}
 	else if (t->format->block == &B_PVRTC2_4BPP)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		pixeltype = pvrtex_pixeltype_pvrtc2_4bpp;
 	}
 	else if (t->format->block == &B_DXT1)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		pixeltype = pvrtex_pixeltype_dxt1;
 	}
 	else if (t->format->block == &B_DXT2 || t->format->block == &B_DXT3)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		pixeltype = pvrtex_pixeltype_dxt3;
 	}
 	else if (t->format->block == &B_DXT4 || t->format->block == &B_DXT5)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		pixeltype = pvrtex_pixeltype_dxt5;
 	}
 	else if (t->format->block == &B_ETC1)
 	{
-		quality = pvrtex_quality_prvtc[tex_profile];
+		quality = pvrtex_quality_prvtc[t->profile];
 		pixeltype = pvrtex_pixeltype_etc1;
 	}
 	else
@@ -129,7 +129,7 @@ bool RgEtc1_Compress(TexEncodeTask *t)
 	// set parameters
 	options.clear();
 	options.m_dithering = rgetc1_dithering;
-	options.m_quality = rgetc1_quality[tex_profile];
+	options.m_quality = rgetc1_quality[t->profile];
 
 	// compress
 	byte *stream = t->stream;
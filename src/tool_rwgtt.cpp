@@ -63,34 +63,7 @@ size_t PackBGRAData(TexEncodeTask *t, byte *stream, byte *data, int width, int h
 {
 	if (t->format->block == &B_BGRA || t->format->block == &B_BGR6 || t->format->block == &B_BGR3 || t->format->block == &B_BGR1)
 	{
-		byte *in = data;
-		byte *end = in + width * height * t->image->bpp;
-		byte *out = stream;
-		int bpp = t->format->block->bitlength / 8;
-		if (t->image->hasAlpha)
-		{
-			while(in < end)
-			{
-				out[0] = in[0];
-				out[1] = in[1];
-				out[2] = in[2];
-				out[3] = in[3];
-				out += bpp;		
-				in  += t->image->bpp;
-			}
-		}
-		else
-		{
-			while(in < end)
-			{
-				out[0] = in[0];
-				out[1] = in[1];
-				out[2] = in[2];
-				out[3] = 255;
-				out += bpp;
-				in  += t->image->bpp;
-			}
-		}
+		ImageData_CopyPixels(stream, t->format->block->bitlength / 8, data, t->image->bpp, width * height, t->image->hasAlpha ? false : true);
 		return width * height * ( t->format->block->bitlength / 8);
 	}
 	Warning("PackBGRA : %s%s.dds - unsupported compression %s/%s", t->file->path.c_str(), t->file->name.c_str(), t->format->name, t->format->block->name);
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////
+//
+// RwgTex / timing trace
+// (c) Pavel [VorteX] Timofeyev
+// See LICENSE text file for a license agreement
+//
+////////////////////////////////
+
+#include "main.h"
+#include <vector>
+using namespace std;
+
+typedef struct
+{
+	const char *name;    // static string
+	char        detail[96];
+	double      start;
+	double      end;
+}traceevent;
+
+// each thread writes to it's own ring, no locking is needed
+typedef struct
+{
+	int         tid;
+	size_t      count;   // total events pushed, ring position is count % TRACE_RING_SIZE
+	traceevent *events;
+}tracering;
+
+bool               trace_enabled = false;
+HANDLE             trace_mutex = NULL;
+vector<tracering*> trace_rings;
+thread_local tracering *trace_ring = NULL;
+
+void Trace_Start(void)
+{
+	if (!trace_mutex)
+		trace_mutex = CreateMutex(NULL, FALSE, NULL);
+	I_DoubleTime();
+	trace_enabled = true;
+}
+
+static tracering *Trace_GetRing(void)
+{
+	if (trace_ring)
+		return trace_ring;
+	trace_ring = (tracering *)mem_alloc(sizeof(tracering));
+	trace_ring->count = 0;
+	trace_ring->events = (traceevent *)mem_alloc(sizeof(traceevent) * TRACE_RING_SIZE);
+	WaitForSingleObject(trace_mutex, INFINITE);
+	trace_ring->tid = (int)trace_rings.size() + 1;
+	trace_rings.push_back(trace_ring);
+	ReleaseMutex(trace_mutex);
+	return trace_ring;
+}
+
+void Trace_Event(const char *name, const char *detail, double start, double end)
+{
+	tracering *ring;
+	traceevent *ev;
+
+	if (!trace_enabled)
+		return;
+	ring = Trace_GetRing();
+	ev = &ring->events[ring->count % TRACE_RING_SIZE];
+	ev->name = name;
+	ev->start = start;
+	ev->end = end;
+	if (detail)
+		strlcpy(ev->detail, detail, sizeof(ev->detail));
+	else
+		ev->detail[0] = 0;
+	ring->count++;
+}
+
+// write string escaped for JSON
+static void Trace_WriteString(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fputc('\\', f);
+		if ((byte)*s < 32)
+			continue;
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+// write Chrome/Perfetto trace (JSON array of complete events)
+// should be called when all traced threads are finished
+bool Trace_Write(char *filename)
+{
+	size_t first, i, dropped;
+	traceevent *ev;
+	bool comma;
+	FILE *f;
+
+	if (!trace_enabled)
+		return false;
+	f = fopen(filename, "w");
+	if (!f)
+	{
+		Warning("Trace_Write(%s): cannot open file (%s) for writing", filename, strerror(errno));
+		return false;
+	}
+	dropped = 0;
+	comma = false;
+	fprintf(f, "{\"traceEvents\":[\n");
+	for (vector<tracering*>::iterator r = trace_rings.begin(); r < trace_rings.end(); r++)
+	{
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"thread %i\"}}", comma ? ",\n" : "", (*r)->tid, (*r)->tid);
+		comma = true;
+		first = 0;
+		if ((*r)->count > TRACE_RING_SIZE)
+		{
+			first = (*r)->count - TRACE_RING_SIZE;
+			dropped += first;
+		}
+		for (i = first; i < (*r)->count; i++)
+		{
+			ev = &(*r)->events[i % TRACE_RING_SIZE];
+			fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"rwgtex\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.1f,\"dur\":%.1f", ev->name, (*r)->tid, ev->start * 1000000.0, (ev->end - ev->start) * 1000000.0);
+			if (ev->detail[0])
+			{
+				fprintf(f, ",\"args\":{\"file\":");
+				Trace_WriteString(f, ev->detail);
+				fprintf(f, "}");
+			}
+			fprintf(f, "}");
+		}
+	}
+	fprintf(f, "\n]}\n");
+	fclose(f);
+	if (dropped)
+		Warning("Trace_Write(%s): %i oldest events were dropped (ring buffer overflow)", filename, dropped);
+	return true;
+}
+
+void Trace_Shutdown(void)
+{
+	trace_enabled = false;
+	for (vector<tracering*>::iterator r = trace_rings.begin(); r < trace_rings.end(); r++)
+	{
+		mem_free((*r)->events);
+		mem_free(*r);
+	}
+	trace_rings.clear();
+	trace_ring = NULL;
+	if (trace_mutex)
+		CloseHandle(trace_mutex);
+	trace_mutex = NULL;
+}
+
+/*
+==========================================================================================
+
+  Scoped timer
+
+==========================================================================================
+*/
+
+TraceScope::TraceScope(const char *name, double *accumulate, const char *detail)
+{
+	this->name = name;
+	this->detail = detail;
+	this->accumulate = accumulate;
+	this->start = I_DoubleTime();
+}
+
+TraceScope::~TraceScope()
+{
+	double end = I_DoubleTime();
+
+	if (accumulate)
+		*accumulate += end - start;
+	if (trace_enabled)
+		Trace_Event(name, detail, start, end);
+}
+
+double TraceScope::Elapsed(void)
+{
+	return I_DoubleTime() - start;
+}
@@ -0,0 +1,30 @@
+// trace.h
+#ifndef H_TRACE_H
+#define H_TRACE_H
+
+// events kept per thread, oldest are overwritten
+#define TRACE_RING_SIZE 16384
+
+extern bool trace_enabled;
+
+void Trace_Start(void);
+void Trace_Event(const char *name, const char *detail, double start, double end);
+bool Trace_Write(char *filename);
+void Trace_Shutdown(void);
+
+// scoped timer
+// adds elapsed time to accumulator (if given) and emits trace event when tracing is enabled
+class TraceScope
+{
+public:
+	TraceScope(const char *name, double *accumulate = NULL, const char *detail = NULL);
+	~TraceScope();
+	double Elapsed(void);
+private:
+	const char *name;
+	const char *detail;
+	double     *accumulate;
+	double      start;
+};
+
+#endif